@@ -1,16 +1,32 @@
+#ifndef APPARATUS_H
+#define APPARATUS_H
 
 #include <Arduino.h>
 #include <Servo.h>
 
+// Edge-first debouncer: the first edge is reported immediately, then the input is ignored for
+// LEVER_DEBOUNCING_MICROS (hold-off) so the bounce can't produce further edges; a change that is still there when the
+// hold-off ends is accepted with the time of its edge (so the next hold-off doesn't run late into the next press)
+struct LeverDebouncer
+{
+    uint8_t state = false;   // debounced state
+    uint8_t holding = false; // hold-off after the last accepted edge is running
+    uint8_t changed = false; // the input left state during the hold-off, at changeTime
+    uint32_t edgeTime = 0;   // micros() of the last accepted edge
+    uint32_t changeTime = 0;
+    uint8_t update(uint8_t level, uint32_t time);
+};
+
 class Apparatus
 {
 private:
     int num;
     Servo leverLock;
-    unsigned long deployEndTime;
-    unsigned long leverLockTimeoutTime;
-    unsigned long leverUpDebouncingTime;
-    unsigned long leverDownDebouncingTime;
+    uint32_t deployEndTime;        // 0 while the deployer is off
+    uint32_t leverLockTimeoutTime; // 0 while the lever lock servo is detached
+    LeverDebouncer leverUpDebouncer;
+    LeverDebouncer leverDownDebouncer;
+    void updateLevers(uint8_t pins, uint32_t time);
 
 public:
     Apparatus();
@@ -20,5 +36,9 @@ public:
     uint8_t openLever(bool state);
     uint8_t debouncedLeverUp;
     uint8_t debouncedLeverDown;
+    uint32_t leverUpTime;   // micros() of the edge that led to the current debouncedLeverUp state
+    uint32_t leverDownTime; // micros() of the edge that led to the current debouncedLeverDown state
     uint16_t deployCounter;
-};
\ No newline at end of file
+};
+
+#endif
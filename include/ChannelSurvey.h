@@ -0,0 +1,44 @@
+/* ChannelSurvey Class
+ *  - Startup spectrum survey: counts for every channel (0-125) in how many of SURVEY_PASSES sweeps the receiver
+ *    saw a carrier above -64 dBm (testRPD()), print() sends the spectrum over serial
+ *  - Channels are ranked by their own and their neighbours' counts (a WiFi channel spreads over ~20 nRF24 channels)
+ *  - Negotiation helpers: the master proposes its SURVEY_CANDIDATES quietest channels, every slave answers with its
+ *    own noise on them, the master adds up the answers and decides
+ */
+
+#ifndef CHANNEL_SURVEY_H
+#define CHANNEL_SURVEY_H
+
+#include <Arduino.h>
+#include <RF24.h>
+
+#define SURVEY_CHANNELS 126          // nRF24 channels 0-125 (2400-2525 MHz)
+#define SURVEY_PASSES 15             // Sweeps over all channels (max 15, counts are stored in 4 bits)
+#define SURVEY_DWELL_MICROS 128      // Listening time per channel and sweep (RPD needs >= 40 micros after RX settling)
+#define SURVEY_CANDIDATES 4          // Number of channels proposed by the master (packed into one frame timestamp)
+#define SURVEY_PROPOSE_MICROS 1e6    // Master repeats its proposal this often until a slave answers
+#define SURVEY_ANSWER_MICROS 1e6     // Master decides this long after the first answer, even if not all slaves answered
+#define SURVEY_SILENCE_MICROS 5e6    // Back to RADIO_CHANNEL when nothing was received for this long on the negotiated channel
+
+class ChannelSurvey
+{
+public:
+    ChannelSurvey(RF24 &radio) : radio(radio){};
+    void scan(); // takes SURVEY_PASSES * SURVEY_CHANNELS * ~300 micros, radio is left in standby
+    void print();
+    uint32_t propose();                   // master: packed candidates (byte i = channel i), quietest first
+    uint32_t noise(uint32_t candidates);  // slave: packed own noise for the proposed candidates
+    void vote(uint32_t noise);            // master: add a slave's answer
+    uint8_t decide();                     // master: candidate with the lowest total noise
+
+private:
+    uint8_t hits(uint8_t channel);
+    uint8_t score(uint8_t channel);
+
+    RF24 &radio;
+    uint8_t counts[SURVEY_CHANNELS / 2]; // two 4 bit counts per byte
+    uint8_t candidates[SURVEY_CANDIDATES];
+    uint16_t totals[SURVEY_CANDIDATES];
+};
+
+#endif
@@ -0,0 +1,37 @@
+/* ClockSync Class
+ *  - Estimates the offset and drift of a remote micros() clock from ping/pong round trips
+ *    (t1 ping sent (local), t2 ping received (remote), t3 pong sent (remote), t4 pong received (local))
+ *  - Samples delayed by queueing or radio retries are rejected by their round-trip time (min RTT filter)
+ *  - toLocal() maps a remote timestamp (e.g. slave lever pull) onto the local clock
+ */
+
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <Arduino.h>
+
+#define CLOCK_SYNC_INTERVAL_MICROS 1e6   // Time between two pings
+#define CLOCK_SYNC_RTT_TOLERANCE 400     // Samples with a RTT more than this above the best recent RTT are rejected (micros)
+#define CLOCK_SYNC_RTT_WINDOW 16         // Number of samples after which the best RTT is re-learned (link may have changed)
+#define CLOCK_SYNC_DRIFT_GAIN 0.25       // Weight of a new drift measurement (exponential smoothing)
+#define CLOCK_SYNC_DRIFT_MIN_MICROS 5e5  // Min time between two accepted samples to measure drift
+
+class ClockSync
+{
+public:
+    void addSample(uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4);
+    uint32_t toLocal(uint32_t remoteTime);
+    bool synced = false;
+    int32_t offset = 0; // remote - local clock at offsetTime (micros, modulo 2^32)
+    float drift = 0;    // remote clock rate - local clock rate (e.g. 50e-6 = 50 ppm)
+    int32_t rtt = 0;    // round-trip time of the last accepted sample (micros)
+
+private:
+    uint32_t offsetTime = 0; // local time the offset was measured at
+    bool driftValid = false;
+    int32_t minRtt = 0;      // best RTT since the window started
+    int32_t windowMinRtt = 0;
+    uint8_t windowCount = 0;
+};
+
+#endif
@@ -0,0 +1,61 @@
+/* EventLog Class
+ *  - Binary event records instead of the text lines of the task logic (EVENT_LOG_ENABLED): log() puts a fixed-size
+ *    record (event, micros(), value) into a RAM ring and returns, drain() at the end of loop() hands the ring to the
+ *    UART only as far as its TX buffer has room, so no print of the pull handling waits for the serial port
+ *  - A full ring drops the record and counts it, the count goes out as an EVENT_DROPPED record once the ring is empty
+ *  - Wire format: [EVENT_LOG_SYNC][event][time (4)][value (4)][checksum], little-endian, checksum = sum of the 9 bytes
+ *    between sync and checksum; text lines (setup, link and loop records, trace) stay plain text in between, they can
+ *    overtake the records of the same loop (the record times tell the order)
+ *  - Decoded on the host with ../tools/event_decode.cpp (text lines as before, or CSV)
+ */
+
+#ifndef EVENT_LOG_H
+#define EVENT_LOG_H
+
+#include <Arduino.h>
+
+#define EVENT_LOG_SYNC 0xE5     // first byte of every record, never part of a text line (ASCII)
+#define EVENT_LOG_RECORDS 16    // Records the ring holds (a pull takes 4, a full TX buffer about 5)
+#define EVENT_LOG_RECORD_LEN 9  // event, time, value
+#define EVENT_LOG_WIRE_LEN (EVENT_LOG_RECORD_LEN + 2)
+
+// value of each event, text line it replaces
+enum event_id
+{
+    EVENT_DROPPED,        // records dropped since startup    "Events dropped: <value>"
+    EVENT_STATE,          // ST_STATES of src/main.cpp        "State: <name>"
+    EVENT_LEVER_UP,       // debounced state, edge time       "leverUp: <value>"
+    EVENT_LEVER_DOWN,     // debounced state, edge time       "leverDown: <value>"
+    EVENT_DEPLOY,         // deploy counter                   "deployCounter: <value>"
+    EVENT_PULL_GOAL,      // new random pull goal (TRAINING)  "New random pull goal: <value>"
+    EVENT_REWARD_LATENCY, // micros from the pull (slave)     "Pull to reward latency: <value>"
+    EVENT_COUNT
+};
+
+class EventLog
+{
+public:
+    void log(uint8_t event, uint32_t value); // loop() only (not from an ISR), time is micros()
+    void log(uint8_t event, uint32_t value, uint32_t time);
+    void drain(); // never waits for the serial port
+
+private:
+    struct Record
+    {
+        uint8_t event;
+        uint32_t time;
+        uint32_t value;
+    };
+
+    void write(const Record &record);
+
+    Record ring[EVENT_LOG_RECORDS];
+    uint8_t head = 0; // next record to write out
+    uint8_t count = 0;
+    uint16_t dropped = 0; // stops at 65535
+    uint16_t reported = 0;
+};
+
+extern EventLog eventLog;
+
+#endif
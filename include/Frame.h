@@ -0,0 +1,74 @@
+/* Frame
+ *  - Compact, versioned radio frame exchanged between master and slave (sent with dynamic payload size)
+ *  - Layout: [version][type][seq][flags] followed by 0-3 little-endian uint32_t timestamps (number fixed by type)
+ *  - Integrity is covered by the nRF24 hardware CRC-16, the sequence number lets the receiver drop
+ *    retransmitted duplicates and count missed frames (SeqTracker)
+ *  - A frame repeated under its old sequence number may come after newer ones (ACK payload repeated by the master),
+ *    so SeqTracker drops any of the last FRAME_SEQ_WINDOW sequence numbers, not only the last one
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <Arduino.h>
+
+#define FRAME_VERSION 2
+#define FRAME_HEADER_LEN 4
+#define FRAME_MAX_TIMES 3
+#define FRAME_MAX_LEN (FRAME_HEADER_LEN + 4 * FRAME_MAX_TIMES)
+#define FRAME_DUPLICATE_MICROS 2e6 // A repeated sequence number only counts as duplicate within this time (sender may have rebooted)
+#define FRAME_SEQ_WINDOW 4         // Last accepted sequence numbers a repeat is checked against
+
+enum frame_type
+{
+    FRAME_COMMAND = 0, // instructions in flags (m -> s)
+    FRAME_PULL = 1,    // lever pulled, time[0] = pull time on slave clock (m <- s)
+    FRAME_PING = 2,    // clock sync request and heartbeat, time[0] = ping sent on master clock, time[1] = master state (m -> s)
+    FRAME_PONG = 3,    // clock sync reply, time[0] = echoed ping time, time[1] = ping received, time[2] = pong sent (m <- s)
+    FRAME_BEACON = 4,  // slot beacon, time[0] = micros into the slot frame of the beacon source (slot 0 master -> all boxes)
+    FRAME_CHANNEL = 5, // channel negotiation, time[0] = 4 packed bytes: proposed channels (m -> s), their noise (m <- s)
+                       // or with FRAME_FLAG_CHANNEL_SWITCH the channel to switch to in byte 0 (m -> s)
+    FRAME_PAIR = 6,    // pairing, time[0] = ID of the sender, time[1] = member number (byte 0) and channel (byte 1) offered (m -> s)
+    FRAME_STATE = 7,   // heartbeat as ACK payload of any slave frame, time[0] = master state like in FRAME_PING (m -> s)
+    FRAME_TYPE_COUNT
+};
+
+// flag bitfield
+#define FRAME_FLAG_TRIGGER_REWARD _BV(0) // trigger reward in slave (m -> s)
+#define FRAME_FLAG_LONG_TIMEOUT _BV(1)   // enable long timeout in slave (m -> s)
+#define FRAME_FLAG_LOCK_LEVER _BV(2)     // lock lever in slave (m -> s)
+#define FRAME_FLAG_REMOTE_LOCK _BV(3)    // lock/unlock both levers on remote press (m -> s)
+#define FRAME_FLAG_ON_PULL _BV(4)        // only valid as ACK payload answering a pull frame (m -> s)
+#define FRAME_FLAG_CHANNEL_SWITCH _BV(5) // FRAME_CHANNEL decides the channel (m -> s)
+
+struct Frame
+{
+    uint8_t type = FRAME_COMMAND;
+    uint8_t seq = 0;
+    uint8_t flags = 0;
+    uint32_t time[FRAME_MAX_TIMES] = {0, 0, 0};
+};
+
+uint8_t frameEncode(const Frame *frame, uint8_t *buf);             // returns the encoded length
+bool frameDecode(const uint8_t *buf, uint8_t len, Frame *frame);   // false for unknown version/type or wrong length
+uint16_t frameAirMicros(uint8_t len);                               // on-air time of one attempt at 250 kbps
+
+class SeqTracker
+{
+public:
+    bool accept(uint8_t seq, uint32_t time); // false if the frame is a duplicate
+    void restart();                          // next frame starts a new sequence (link reopened), keeps the counters
+    uint16_t received = 0;                   // accepted frames
+    uint16_t duplicates = 0;                 // dropped duplicates
+    uint16_t missed = 0;                     // frames never received (gaps in the sequence)
+
+private:
+    bool seen(uint8_t seq); // one of the last accepted sequence numbers
+    bool valid = false;
+    uint8_t lastSeq = 0;
+    uint32_t lastTime = 0;
+    uint8_t recent[FRAME_SEQ_WINDOW]; // last accepted sequence numbers, newest first
+    uint8_t recentCount = 0;
+};
+
+#endif
@@ -0,0 +1,29 @@
+/* Group Class
+ *  - Last lever pull of every member of a cooperation group (member 0 = the master itself, 1 to size - 1 = slaves)
+ *  - count() tells how many members pulled within a time window around a reference pull, the master compares it
+ *    with GROUP_QUORUM ("k of n levers within SYNCH_MICROS")
+ *  - No hardware access, the pull times come from the caller (on the master clock)
+ */
+
+#ifndef GROUP_H
+#define GROUP_H
+
+#include <Arduino.h>
+
+#define GROUP_MAX_SIZE 6 // master + one slave per nRF24 reading pipe (1-5)
+
+class Group
+{
+public:
+    Group(uint8_t size) : size(size){};
+    void pull(uint8_t member, uint32_t time);
+    uint8_t count(uint32_t reference, uint32_t window); // members whose last pull is at most window micros away from reference
+    void clear();                                       // forget all pulls (each member has to pull again)
+    uint8_t size;
+
+private:
+    uint32_t pullTime[GROUP_MAX_SIZE];
+    uint8_t pulled = 0; // bitfield, members with a valid pullTime
+};
+
+#endif
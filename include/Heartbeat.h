@@ -0,0 +1,32 @@
+/* Heartbeat Class
+ *  - Liveness of one link partner: every frame received from it counts as a heartbeat, the master's pings (one per
+ *    CLOCK_SYNC_INTERVAL_MICROS) and the slaves' pongs keep an idle link beating
+ *  - expired() reports a partner silent for HEARTBEAT_TIMEOUT_MICROS once, seen() reports it coming back
+ *  - differs() compares the master's state carried by a ping with the own state, a difference only counts once it was
+ *    seen on HEARTBEAT_CONFIRM heartbeats in a row (a state change may be crossing a ping on air)
+ *  - No hardware access, the times come from the caller
+ */
+
+#ifndef HEARTBEAT_H
+#define HEARTBEAT_H
+
+#include <Arduino.h>
+
+#define HEARTBEAT_TIMEOUT_MICROS 3.5e6 // Partner counts as lost after this long without a frame (3 pings missed)
+#define HEARTBEAT_CONFIRM 2            // Heartbeats in a row with the same state difference before the slave takes the master's state
+
+class Heartbeat
+{
+public:
+    bool seen(uint32_t now);                      // frame received, true if the partner was lost before
+    bool expired(uint32_t now);                   // true once when the partner fell silent
+    bool differs(uint32_t local, uint32_t remote); // true once the difference is confirmed
+    bool alive = false;
+
+private:
+    uint32_t lastTime = 0;
+    uint32_t lastDifference = 0;
+    uint8_t differenceCount = 0;
+};
+
+#endif
@@ -0,0 +1,40 @@
+/* LeverEvents
+ *  - Captures lever edges on LEVER_UP_PIN and LEVER_DOWN_PIN with a pin-change interrupt (PCINT2, port D)
+ *  - The ISR stamps every edge with micros() and pushes it together with a PIND snapshot into a
+ *    lock-free single-producer (ISR) / single-consumer (Apparatus::update()) ring
+ *  - Edge timing therefore doesn't depend on how long loop() takes to get back to the lever
+ */
+
+#ifndef LEVER_EVENTS_H
+#define LEVER_EVENTS_H
+
+#include <Arduino.h>
+
+#include "settings.h"
+
+#define LEVER_EVENT_QUEUE_LEN 16 // Number of buffered edges (must be a power of two)
+#define LEVER_EVENT_PIN_MASK (_BV(LEVER_UP_PIN) | _BV(LEVER_DOWN_PIN)) // Lever pins are on port D (pins 0-7 = PD0-PD7)
+
+struct LeverEvent
+{
+    uint32_t time; // micros() when the edge was seen in the ISR
+    uint8_t pins;  // PIND snapshot (masked to LEVER_EVENT_PIN_MASK) right after the edge
+};
+
+class LeverEventQueue
+{
+public:
+    void init();
+    bool push(uint32_t time, uint8_t pins); // only called from the ISR
+    bool pop(LeverEvent *event);            // only called from loop()
+    volatile uint8_t dropped;               // number of edges lost because the queue was full
+
+private:
+    LeverEvent events[LEVER_EVENT_QUEUE_LEN];
+    volatile uint8_t head = 0; // written by producer only
+    volatile uint8_t tail = 0; // written by consumer only
+};
+
+extern LeverEventQueue leverEvents;
+
+#endif
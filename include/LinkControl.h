@@ -0,0 +1,60 @@
+/* LinkControl Class
+ *  - Tunes the radio's auto-retry delay (ARD) and count (ARC limit) and the PA level at runtime from the ARC and
+ *    failed attempts of the own ACKed payloads (fed by RadioLink), so a clean link answers fast and a marginal
+ *    link doesn't stall
+ *  - Every LINK_CONTROL_WINDOW payloads the loss rate per transmission is estimated (smoothed over windows) and
+ *    - the retry count is set to the fewest retries that still deliver an attempt with LINK_CONTROL_TARGET
+ *    - an attempt that failed completely (burst longer than all retries, or the peer transmitting at the same time)
+ *      doubles the retry delay and restores all retries until the end of the window, a window without failed
+ *      attempts steps back towards the shortest delay that still fits the ACK (payload)
+ *    - the PA level is raised above LINK_CONTROL_PA_UP_LOSS and lowered again below LINK_CONTROL_PA_DOWN_LOSS
+ *  - The data rate stays fixed, it has to be the same on both sides of the link
+ *  - No RadioLink dependency: update() must only be called while no attempt is on air
+ */
+
+#ifndef LINK_CONTROL_H
+#define LINK_CONTROL_H
+
+#include <Arduino.h>
+#include <RF24.h>
+
+#define LINK_CONTROL_WINDOW 8           // Payloads (delivered or failed attempts) per estimate, only delivered ones count for the loss
+#define LINK_CONTROL_TARGET 0.999       // Delivery probability of one attempt (all auto-retries) the retry count is chosen for
+#define LINK_CONTROL_MIN_COUNT 2        // Fewest auto-retries (a single collision must not fail an attempt)
+#define LINK_CONTROL_MIN_DELAY 3        // Shortest retry delay (1000 micros, ACK with a 16 byte payload at 250 kbps)
+#define LINK_CONTROL_PA_UP_LOSS 0.2     // Loss rate per transmission above which the PA level is raised
+#define LINK_CONTROL_PA_DOWN_LOSS 0.02  // Loss rate per transmission below which the PA level is lowered
+
+class LinkControl
+{
+public:
+    LinkControl(RF24 &radio, uint8_t minPaLevel, uint8_t maxPaLevel)
+        : radio(radio), minPaLevel(minPaLevel), maxPaLevel(maxPaLevel){};
+    void begin(uint8_t minDelay, uint8_t maxDelay, uint8_t maxCount); // (re)start with the longest delay, the most retries and the lowest PA level
+    void delivered(uint8_t arc); // ACKed payload, arc = retransmissions it needed
+    void failed();               // attempt ended with MAX_RT
+    void update();               // adjusts and applies the settings at the end of a window
+    void print();                // current settings and loss estimate, without line end
+    uint8_t retryDelay = 15;
+    uint8_t retryCount = 15;
+    uint8_t paLevel = 0;
+    uint8_t loss = 0; // smoothed loss rate per transmission (x / 256)
+
+private:
+    void apply();
+    uint8_t retriesFor(uint8_t loss);
+
+    RF24 &radio;
+    uint8_t minPaLevel;
+    uint8_t maxPaLevel;
+    uint8_t minDelay = LINK_CONTROL_MIN_DELAY;
+    uint8_t maxDelay = 15;
+    uint8_t maxCount = 15;
+    uint8_t payloads = 0;       // in the current window
+    uint8_t failures = 0;       // attempts that ended with MAX_RT in the current window
+    uint16_t transmissions = 0; // in the current window
+    uint16_t losses = 0;        // transmissions without ACK in the current window
+    bool escalate = false;      // an attempt failed since the last update()
+};
+
+#endif
@@ -0,0 +1,41 @@
+/* LinkStats Class
+ *  - Running link quality counters of the own transmissions: payloads delivered and lost, failed attempts (MAX_RT),
+ *    auto-retransmit count (ARC) of every ACKed payload and its round-trip time (first attempt to TX_DS)
+ *  - ARC and RTT are kept as log2 histograms (bucket i counts values below 2^i resp. 2^(i + 9) micros,
+ *    the last bucket everything above), counters stop at 65535 instead of wrapping
+ *  - print() writes one compact record (received frames, duplicates and gaps per peer are added by the caller)
+ */
+
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <Arduino.h>
+
+#define LINK_STATS_REQUEST 'L'    // Character that requests the record over serial
+#define LINK_STATS_ARC_BUCKETS 5  // ARC 0, 1, 2-3, 4-7, 8-15
+#define LINK_STATS_RTT_BUCKETS 12 // RTT < 512 micros, < 1 ms, < 2 ms ... < 512 ms, above
+#define LINK_STATS_RTT_SHIFT 9    // Upper limit of the first RTT bucket is 2^LINK_STATS_RTT_SHIFT micros
+
+class LinkStats
+{
+public:
+    void delivered(uint8_t arc, uint32_t rtt); // ACKed payload
+    void delivered();                          // payload sent without ACK (broadcast, beacon)
+    void failedAttempt();                      // MAX_RT (or attempt timeout), payload is retried
+    void lost();                               // payload given up after RADIO_TRANSMISSION_MAX_ATTEMPTS
+    void print();                              // record without line end
+    void clear();
+
+private:
+    static void count(uint16_t &counter);
+    static uint8_t bucket(uint32_t value, uint8_t count);
+
+    uint16_t sent = 0;
+    uint16_t lostCount = 0;
+    uint16_t maxRt = 0;
+    uint32_t arcSum = 0;
+    uint16_t arcHistogram[LINK_STATS_ARC_BUCKETS] = {0};
+    uint16_t rttHistogram[LINK_STATS_RTT_BUCKETS] = {0};
+};
+
+#endif
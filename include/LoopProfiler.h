@@ -0,0 +1,93 @@
+/* LoopProfiler Class
+ *  - Duration of every loop() phase (lever, remote, radio block, task procedure) and of the whole loop, as min, max
+ *    and log2 histogram (bucket i counts durations below 2^i ticks, the last bucket everything above, all buckets
+ *    halved, rounded up, once one is full), plus the phases of the slowest loop so far
+ *  - Ticks of 4 micros from timer 0 and its overflow count (32 bit, a stalled loop of seconds is still measured):
+ *    register reads instead of a micros() call, mark() only stores the tick, start() files the whole previous loop
+ *  - calibrate() measures the own overhead per loop, print() writes one record (on LOOP_PROFILE_REQUEST over serial),
+ *    the loop that prints it isn't counted
+ */
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <Arduino.h>
+
+#define LOOP_PROFILE_REQUEST 'P'    // Character that requests the record over serial
+#define LOOP_PROFILE_PHASES 4       // lever, remote, radio, task
+#define LOOP_PROFILE_BUCKETS 12     // 0 ticks, 1 tick (4 micros), 2-3 ticks ... 512-1023 ticks (4 ms), above
+#define LOOP_PROFILE_TICK_MICROS 4  // Timer 0 tick (prescaler 64 at 16 MHz)
+#define LOOP_PROFILE_CALIBRATION 64 // Loops profiled by calibrate()
+
+enum loop_phase
+{
+    LOOP_PHASE_LEVER,
+    LOOP_PHASE_REMOTE,
+    LOOP_PHASE_RADIO,
+    LOOP_PHASE_TASK
+};
+
+#ifdef TCNT0
+extern "C" volatile unsigned long timer0_overflow_count; // wiring.c
+#endif
+
+class LoopProfiler
+{
+public:
+    void start(); // top of loop(), files the previous loop
+    void mark(loop_phase phase) // end of a phase
+    {
+        this->marks[phase] = ticks();
+    }
+    void calibrate(); // in setup(), before the first loop
+    void print();     // record with line end
+    void clear();
+
+    // timer 0 ticks over prescaler 64 at 16 MHz, the overflow count of micros() gives the high bytes
+    static uint32_t ticks()
+    {
+#ifdef TCNT0
+        uint8_t sreg = SREG;
+        cli();
+        uint8_t low = TCNT0;
+        uint32_t high = timer0_overflow_count;
+        if ((TIFR0 & _BV(TOV0)) && low < 255) // overflow not counted yet
+        {
+            high++;
+        }
+        SREG = sreg;
+        return high << 8 | low;
+#else
+        static uint32_t last = 0, carry = 0;
+        uint32_t now = micros();
+        if (now < last) // micros() wraps after 2^30 ticks, carried on like the overflow count
+        {
+            carry += 1UL << 30;
+        }
+        last = now;
+        return carry + now / LOOP_PROFILE_TICK_MICROS;
+#endif
+    }
+
+private:
+    struct Phase
+    {
+        uint32_t min = 0xFFFFFFFF;
+        uint32_t max = 0;
+        uint16_t histogram[LOOP_PROFILE_BUCKETS] = {0};
+    };
+
+    static void record(Phase &phase, uint32_t ticks);
+    static void printMicros(uint32_t ticks);
+
+    uint32_t loopStart = 0;
+    uint32_t marks[LOOP_PROFILE_PHASES];
+    Phase phases[LOOP_PROFILE_PHASES + 1]; // the whole loop last
+    uint32_t worst[LOOP_PROFILE_PHASES + 1] = {0};
+    uint32_t worstMillis = 0; // end of the slowest loop
+    uint32_t loops = 0;
+    uint16_t overheadNanos = 0;
+    bool skip = false; // loop printed the record
+};
+
+#endif
@@ -0,0 +1,90 @@
+/* Messages
+ *  - Catalog of the serial messages of all modules, keyed by message_id: each text is stored once in flash (PROGMEM),
+ *    string literals without F() would be copied to SRAM at startup
+ *  - message(id) is printed like an F() string: Serial.println(message(MSG_SETUP_SUCCESSFUL))
+ *  - Field labels of the link, loop and survey records and the prints only compiled for debugging (PRINT_DEBUG,
+ *    DEBUG_REMOTE) stay F() strings next to their values (in flash as well)
+ */
+
+#ifndef MESSAGES_H
+#define MESSAGES_H
+
+#include <Arduino.h>
+
+enum message_id
+{
+    // task states, order of ST_STATES (src/main.cpp)
+    MSG_ST_START,
+    MSG_ST_UNLOCKLEVER,
+    MSG_ST_LEVERFULLUP,
+    MSG_ST_LEVERFULLDOWN,
+    MSG_ST_SYNCBOXES,
+    MSG_ST_REWARD,
+    MSG_ST_LOCKLEVER,
+    MSG_ST_WAIT,
+    // modes, order of MD_MODES (src/main.cpp)
+    MSG_MD_ONE,
+    MSG_MD_TWO,
+    MSG_MD_THREE,
+    // loop phases, order of watchdog_phase (include/Watchdog.h)
+    MSG_WD_SETUP,
+    MSG_WD_LEVER,
+    MSG_WD_REMOTE,
+    MSG_WD_RADIO,
+    MSG_WD_TASK,
+
+    // task
+    MSG_STATE,
+    MSG_MODE,
+    MSG_CURRENT_PULL_GOAL,
+    MSG_NEW_PULL_GOAL,
+    MSG_LEVER_UP,
+    MSG_LEVER_DOWN,
+    MSG_DEPLOY_COUNTER,
+
+    // setup
+    MSG_AUDIO_NOT_RESPONDING,
+    MSG_AUDIO_CHECK_CONNECTION,
+    MSG_AUDIO_CHECK_SD_CARD,
+    MSG_AUDIO_RESTART,
+    MSG_ILLEGAL_SETUP,
+    MSG_CHECK_SETTINGS,
+    MSG_RADIO_NOT_RESPONDING,
+    MSG_BOX_ID,
+    MSG_SETUP_SUCCESSFUL,
+
+    // radio link
+    MSG_ALERT,
+    MSG_SLAVE,
+    MSG_MASTER,
+    MSG_LINK_LOST,
+    MSG_LINK_BACK,
+    MSG_LINK_SILENT,
+    MSG_CHANNEL,
+    MSG_STATE_RESYNCHRONISED,
+    MSG_CORRUPT_PAYLOAD,
+    MSG_INVALID_FRAME,
+    MSG_UNKNOWN_PIPE,
+    MSG_DUPLICATE_FRAME,
+    MSG_TX_QUEUE_FULL,
+    MSG_TX_FAILED_DEFINITIVELY,
+    MSG_TX_FAILED,
+    MSG_TX_RETRYING,
+    MSG_TX_SUCCESSFUL,
+
+    // pairing
+    MSG_PAIRING_STARTED,
+    MSG_PAIRING_STOPPED,
+    MSG_PAIRING_NO_ANSWER,
+    MSG_PAIRING_WAITING,
+    MSG_PAIRING_BOX,
+    MSG_PAIRING_IS_MEMBER,
+    MSG_PAIRING_MEMBER,
+
+    MSG_COUNT
+};
+
+const __FlashStringHelper *message(message_id id);
+const __FlashStringHelper *message(uint8_t first, uint8_t offset); // entry offset of a list (state, mode names)
+
+#endif
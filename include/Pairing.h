@@ -0,0 +1,38 @@
+/* Pairing Class
+ *  - Unique ID of this box (random, generated on the first start and kept in EEPROM)
+ *  - Pairing record in EEPROM: the group (ID of its master), the member number (slave) or the number of paired
+ *    slaves (master) and the channel of the group
+ *  - Paired boxes talk on private addresses derived from the group, so pairs can't hear each other by mistake
+ */
+
+#ifndef PAIRING_H
+#define PAIRING_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#define PAIRING_EEPROM_ADDRESS 0 // box ID (4 bytes) followed by the pairing record
+#define PAIRING_VERSION 1        // record layout, a different value (e.g. erased EEPROM) means unpaired
+#define PAIRING_OFFER_MICROS 5e5 // Master repeats its offer this often while pairing
+#define PAIRING_MICROS 30e6      // Master gives up pairing after this long
+
+struct PairingRecord
+{
+    uint8_t version;
+    uint32_t group;  // ID of the master
+    uint8_t member;  // slave: own member number, master: number of paired slaves
+    uint8_t channel; // channel of the group
+};
+
+class Pairing
+{
+public:
+    void init(); // loads (or generates) the ID and the record
+    bool paired();
+    void save(uint32_t group, uint8_t member, uint8_t channel);
+    void address(uint8_t member, uint8_t *address); // private 5 byte address of a group member (0 = master)
+    uint32_t id = 0;
+    PairingRecord record;
+};
+
+#endif
@@ -0,0 +1,100 @@
+/* RadioLink Class
+ *  - Non-blocking transmit engine on top of RF24
+ *  - send() copies a payload into a small TX queue and returns immediately (transmission starts right away if idle)
+ *  - update() (called every loop) starts queued transmissions with startWrite() and polls the radio status
+ *    for TX_DS / MAX_RT, retries up to RADIO_TRANSMISSION_MAX_ATTEMPTS times and reports the result through
+ *    the optional callback
+ *  - The nRF24 IRQ line (RADIO_IRQ_PIN, pin-change interrupt) flags radio events and records their arrival time,
+ *    so the radio is only read over SPI when it actually has something to report
+ *  - armAck() preloads an ACK payload for reading pipe 1, it goes out with the hardware ACK of the next received frame
+ *    (a transmission flushes it, so it has to be re-armed afterwards)
+ *  - Broadcast mode (init(repeats > 0)): payloads go out without ACK so several receivers can listen on the same
+ *    address, each payload is sent repeats times instead of being retried (delivery is not confirmed)
+ *  - Slotted mode (slots set): attempts only start while the own time slot is open, the radio listens in between
+ *  - A payload sent to another address (e.g. a beacon) goes out once without ACK, then the own writing pipe is restored
+ *  - stats counts delivered and lost payloads, ARC and round-trip time of every ACKed payload (LinkStats)
+ *  - Adaptive mode (control set): ARC and failed attempts are passed on, the controller adjusts the radio between payloads
+ */
+
+#ifndef RADIO_LINK_H
+#define RADIO_LINK_H
+
+#include <Arduino.h>
+#include <RF24.h>
+
+#include "LinkControl.h"
+#include "LinkStats.h"
+#include "SlotClock.h"
+#include "settings.h"
+
+#define RADIO_TX_QUEUE_LEN 4          // Max number of queued payloads
+#define RADIO_FRAME_MAX_LEN 16        // Max size of one queued payload in bytes (nRF24 limit is 32)
+#define RADIO_TX_TIMEOUT_MICROS 15e4  // Safety timeout for one attempt (> 15 retries * (4000 + 1000) micros at 250 kbps)
+#define RADIO_IRQ_POLL_MICROS 1e5     // Status is read at least this often, even without IRQ (missed edge, unwired IRQ)
+#define RADIO_BACKOFF_MICROS 10000    // Longest listening pause before retrying a failed attempt (random, half of it at least)
+#define RADIO_REPEAT_MICROS 30000     // Longest pause between two copies of a broadcast (random, half of it at least), a
+                                      // receiver that just sent its own frame is deaf until its loop() gets to the radio
+
+typedef void (*RadioTxCallback)(uint8_t tag, bool success);
+
+class RadioLink
+{
+public:
+    RadioLink(RF24 &radio) : radio(radio){};
+    void init(uint8_t broadcastRepeats = 0); // after radio.begin()
+    bool send(const void *buf, uint8_t len, uint8_t tag = 0, RadioTxCallback callback = NULL, const uint8_t *address = NULL); // false if queue is full
+    void update();
+    bool busy();
+    bool slotOpen();       // a transmission would go on air right now (always true without slots)
+    void setChannel(uint8_t channel);         // only while no attempt is on air (e.g. !busy())
+    void setAddress(const uint8_t *txAddress); // writing pipe, only while no attempt is on air
+    SlotClock *slots = NULL; // slotted mode
+    LinkControl *control = NULL; // adaptive retries and PA level
+    bool available();    // a received payload is waiting (SPI access only after an IRQ)
+    uint32_t rxTime = 0; // micros() when the IRQ for the last received payload fired
+    uint8_t rxPipe = 0;  // reading pipe of the waiting payload (set by available())
+    bool armAck(const void *buf, uint8_t len); // false while transmitting (try again later)
+    void disarmAck();
+    bool ackConsumed(); // the armed ACK payload went out with a received frame since the last call
+    bool ackGone();     // same without taking it, also before the IRQ of that frame is read (SPI access while armed)
+    bool ackArmed = false;
+    bool ackSent = false; // the armed ACK payload went out, ackConsumed() hasn't taken it yet
+    LinkStats stats;
+
+private:
+    struct TxEntry
+    {
+        uint8_t len;
+        uint8_t tag;
+        RadioTxCallback callback;
+        const uint8_t *address; // NULL = own writing pipe
+        uint8_t data[RADIO_FRAME_MAX_LEN];
+    };
+
+    void startNext();
+    void startAttempt();
+    void startBackoff(uint32_t longest = RADIO_BACKOFF_MICROS);
+    void startListening(); // back to RX unless already there
+    void stopListening(); // an ACK payload already gone counts as sent (ackGone())
+    void finish(bool success);
+    void serviceIrq(bool &txOk, bool &txFail);
+
+    RF24 &radio;
+    TxEntry queue[RADIO_TX_QUEUE_LEN];
+    uint8_t queueHead = 0; // next entry to transmit
+    uint8_t queueCount = 0;
+    bool transmitting = false; // an attempt is on air
+    bool listening = true;     // setup() starts listening right after init()
+    const uint8_t *txAddress = NULL;
+    uint8_t attempts = 0;
+    uint32_t attemptStartTime = 0;
+    uint32_t firstAttemptTime = 0; // start of the first attempt of the current payload (round-trip time)
+    uint32_t backoffStart = 0;     // failed attempt, the radio listens for backoff micros before the next one
+    uint32_t backoff = 0;
+    uint32_t txDoneTime = 0;       // IRQ time of the last TX_DS
+    bool rxPending = false;
+    uint32_t lastStatusTime = 0;
+    uint8_t broadcastRepeats = 0;
+};
+
+#endif
@@ -0,0 +1,39 @@
+/* SlotClock Class
+ *  - Time slots for several pairs/groups sharing one channel (slotted mode, RADIO_SLOT_COUNT > 0)
+ *  - A frame of RADIO_SLOT_COUNT slots of RADIO_SLOT_MICROS repeats endlessly, slot i belongs to the pair/group with
+ *    RADIO_SLOT_ID i (master and slaves of a pair/group transmit in the same slot)
+ *  - The master with slot 0 is the beacon source: its clock defines the frame and it regularly broadcasts its
+ *    position in the frame (FRAME_BEACON), every other box aligns its frame to the last received beacon
+ *  - Without a beacon for SLOT_BEACON_TIMEOUT_MICROS the slots are ignored (free transmission as without slotted mode)
+ */
+
+#ifndef SLOT_CLOCK_H
+#define SLOT_CLOCK_H
+
+#include <Arduino.h>
+
+#define SLOT_GUARD_MICROS 15000          // An attempt is only started with this much of the own slot left (radio auto-retries included)
+#define SLOT_BEACON_INTERVAL_MICROS 1e6  // Time between two beacons of the beacon source
+#define SLOT_BEACON_TIMEOUT_MICROS 5e6   // Slots are ignored when the last beacon is older than this
+
+class SlotClock
+{
+public:
+    SlotClock(uint8_t slot, uint8_t count, uint32_t slotMicros, bool source)
+        : slot(slot), count(count), slotMicros(slotMicros), source(source){};
+    bool open(uint32_t now);                      // own slot is running with at least SLOT_GUARD_MICROS left (or not synced)
+    bool synced(uint32_t now);                    // beacon source, or a recent beacon was received
+    uint32_t phase(uint32_t now);                 // micros since the current frame started
+    void beacon(uint32_t phase, uint32_t rxTime); // beacon received: source was phase micros into its frame at rxTime (local clock)
+
+private:
+    uint8_t slot;
+    uint8_t count;
+    uint32_t slotMicros;
+    bool source;
+    uint32_t frameStart = 0; // local time a frame started (moved forward by whole frames, so it never wraps)
+    uint32_t lastBeacon = 0;
+    bool beaconValid = false;
+};
+
+#endif
@@ -0,0 +1,47 @@
+/* Sniffer Class
+ *  - Passive capture of the frames of one pair/group (RADIO_ROLE RADIO_SNIFFER, spare box without lever)
+ *  - The radio listens on up to 6 known addresses with auto-ACK and CRC disabled and a fixed 32 byte payload, so it
+ *    never answers on air and also picks up the ACKs (they carry the address of the frame) and corrupt frames; the
+ *    raw bytes (packet control field, payload and CRC, bit-shifted) are decoded on the host
+ *  - Fixed channel, or a sweep over 0 to RADIO_SURVEY_MAX_CHANNEL that stays on a channel as long as there is traffic
+ *  - Records are streamed in binary: [SNIFFER_SYNC][type][length][length bytes]
+ *    SNIFFER_RECORD_ADDRESS: pipe, 5 address bytes (repeated every SNIFFER_ADDRESS_MICROS for late listeners)
+ *    SNIFFER_RECORD_CAPTURE: micros (4, little-endian), channel, pipe, 32 raw bytes
+ */
+
+#ifndef SNIFFER_H
+#define SNIFFER_H
+
+#include <Arduino.h>
+#include <RF24.h>
+
+#define SNIFFER_SYNC 0xA5
+#define SNIFFER_RECORD_ADDRESS 1
+#define SNIFFER_RECORD_CAPTURE 2
+#define SNIFFER_PIPES 6
+#define SNIFFER_RAW_LEN 32               // Payload width, longer than the longest frame + packet control field + CRC
+#define SNIFFER_SWEEP 255                // Channel value for a sweep
+#define SNIFFER_DWELL_MICROS 1.1e6       // Time per channel while sweeping (longer than the ping interval)
+#define SNIFFER_ADDRESS_MICROS 1e6       // Address records are repeated this often
+
+class Sniffer
+{
+public:
+    Sniffer(RF24 &radio) : radio(radio){};
+    void begin(uint8_t addresses[][6], uint8_t count, uint8_t channel); // after radio.begin(), channel or SNIFFER_SWEEP
+    void update();                                                      // forwards captured frames, never waits for the radio
+
+private:
+    void tune(uint8_t channel);
+    void writeRecord(uint8_t type, const uint8_t *data, uint8_t len);
+
+    RF24 &radio;
+    uint8_t (*addresses)[6] = NULL;
+    uint8_t count = 0;
+    bool sweep = false;
+    uint8_t channel = 0;
+    uint32_t dwellStart = 0;
+    uint32_t lastAddressTime = 0;
+};
+
+#endif
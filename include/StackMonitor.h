@@ -0,0 +1,39 @@
+/* StackMonitor Class
+ *  - Stack painting: paint() at the end of setup() fills the free SRAM between the heap and the stack with
+ *    STACK_CANARY, the stack overwrites it as it grows; the canary bytes still left above the heap are the smallest
+ *    gap there has been between heap and stack (loop() and the ISRs, setup() isn't painted)
+ *  - start() at the top of loop() keeps the stack pointer of loop(), the depth is how far the stack went below it
+ *  - print() writes "Stack: free=<now> gap=<smallest> depth=<deepest loop()>" (bytes), on STACK_REQUEST over serial
+ *    and with the PRINT_DEBUG loop times; the canary scan takes up to about 0.3 ms
+ *  - The heap starts at __malloc_heap_start (nothing in the firmware calls malloc())
+ */
+
+#ifndef STACK_MONITOR_H
+#define STACK_MONITOR_H
+
+#include <Arduino.h>
+
+#define STACK_REQUEST 'M'      // Character that requests the record over serial
+#define STACK_CANARY 0xC5      // Paint of the unused SRAM
+#define STACK_PAINT_MARGIN 16  // Bytes below the stack pointer paint() leaves alone (its own frame and interrupts)
+
+class StackMonitor
+{
+public:
+    void paint(); // end of setup()
+    void start(); // top of loop()
+    void print(); // record with line end
+    uint16_t freeNow();
+    uint16_t smallestGap();
+    uint16_t deepestLoop();
+
+private:
+    static uint8_t *heapEnd();
+    static uint8_t *stackPointer();
+    uint8_t *lowest(); // lowest byte the stack has written since paint()
+
+    uint8_t *paintedEnd = NULL; // first byte above the painted SRAM, NULL before paint()
+    uint8_t *loopBase = NULL;   // stack pointer at the top of loop()
+};
+
+#endif
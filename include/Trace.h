@@ -0,0 +1,47 @@
+/* Trace Class
+ *  - Input trace of a session (TRACE_ENABLED): every input the task logic reacts to is written as one line between
+ *    the normal serial output, so a captured serial log is both the trace and the expected output of its replay on
+ *    the host (native/replay.cpp)
+ *  - Records: '~', type, fixed-width hex fields, times are micros() of the box
+ *    ~H version(2) role(2) time(8) pins(2) synch(8) iti(8) long(8) pullmax(2) count1(2) count2(2) count3(2)
+ *                                              setup: port D (lever, remote) and the session settings
+ *    ~N seed(8)                                randomSeed() value
+ *    ~P id(8) version(2) group(8) member(2) channel(2)   box ID and pairing record loaded from EEPROM
+ *    ~L time(8) pins(2)                        lever edge from the ISR queue, port D snapshot
+ *    ~R time(8) level(1)                       remote pin level changed (as polled by Remote::update())
+ *    ~F time(8) pipe(1) data(2 per byte)       payload read from the radio, time of its IRQ
+ *    ~T time(8) delivered(1) arc(1)            end of an own transmission attempt (TX_DS or MAX_RT), time of its IRQ
+ *    ~S time(8) char(2)                        character read from the serial port
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+
+#include "settings.h"
+
+#define TRACE_VERSION 1
+#define TRACE_MARK '~' // first character of every trace line
+
+class Trace
+{
+public:
+    void begin(uint8_t role); // after Serial.begin()
+    void seed(uint32_t seed);
+    void pairing(uint32_t id, uint8_t version, uint32_t group, uint8_t member, uint8_t channel);
+    void lever(uint32_t time, uint8_t pins);
+    void remote(uint32_t time, uint8_t level); // every poll, only changes are written
+    void frame(uint32_t time, uint8_t pipe, const uint8_t *data, uint8_t len);
+    void transmitted(uint32_t time, bool delivered, uint8_t arc);
+    void serialInput(uint32_t time, uint8_t c);
+
+private:
+    void start(char type);
+    void hex(uint32_t value, uint8_t digits);
+    uint8_t remoteLevel = 0xFF; // last level written, none yet
+};
+
+extern Trace trace;
+
+#endif
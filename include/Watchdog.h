@@ -0,0 +1,64 @@
+/* Watchdog Class
+ *  - AVR watchdog in reset mode (WATCHDOG_ENABLED): a setup() error loop or a loop() that hangs (radio call, serial)
+ *    resets the box instead of leaving it dead until a power cycle; WATCHDOG_SETUP_TIMEOUT during setup() (audio player
+ *    start), WATCHDOG_TIMEOUT from resume() on, kick() at the top of every loop()
+ *  - A .noinit record, which a reset leaves alone, keeps the phase being executed (enter()), the start of its loop and
+ *    the mode to resume with; after a watchdog reset begin() prints "Watchdog: reset phase=<phase> at=<millis>" (loop
+ *    start in the uptime before the reset) and resume() "Watchdog: resumed locked recovery=<millis>"
+ *  - Recovery counts from the start of the stalled loop to the end of the next setup(): the timeout (nominal, the
+ *    watchdog oscillator is off by up to 10 %) plus the setup() duration, so it is bounded by both
+ *  - Reset cause: Optiboot (nanoatmega328new) hands MCUSR over in r2, it is read and the watchdog turned off before the
+ *    constructors run (after a reset it stays on at the shortest timeout)
+ */
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <Arduino.h>
+#include <avr/wdt.h>
+
+#define WATCHDOG_SETUP_TIMEOUT WDTO_8S // Longest setup() (the audio player takes up to 3 s to start)
+#define WATCHDOG_MAGIC 0x57444F47UL     // "WDOG", record written since the last power-on
+
+// timeout of the WDTO_ constants: 2048 cycles of the 128 kHz watchdog oscillator, doubled per step
+#define WATCHDOG_MILLIS(timeout) (16UL << (timeout))
+
+// phase being executed, the loop() phases of LoopProfiler
+enum watchdog_phase
+{
+    WATCHDOG_SETUP,
+    WATCHDOG_LEVER,
+    WATCHDOG_REMOTE,
+    WATCHDOG_RADIO,
+    WATCHDOG_TASK,
+    WATCHDOG_PHASES
+};
+
+class Watchdog
+{
+public:
+    void begin(uint8_t mode, uint8_t goal); // start of setup() (after Serial.begin()), mode and pull goal of a new session
+    void resume();                          // end of setup()
+    void kick(uint8_t mode, uint8_t goal);  // top of loop(), mode and pull goal to resume with
+    void enter(watchdog_phase phase);
+    bool stalled = false; // setup() runs after a watchdog reset
+    uint8_t mode = 0;     // to resume with: of the stalled session, or the ones begin() got
+    uint8_t goal = 0;
+
+private:
+    uint16_t stallMillis = 0; // start of the stalled loop to the reset
+    struct Record
+    {
+        uint32_t magic;
+        uint32_t loopMillis; // start of the loop being executed
+        uint8_t phase;
+        uint8_t mode;
+        uint8_t goal;
+    };
+
+    static Record record; // .noinit
+};
+
+extern Watchdog watchdog;
+
+#endif
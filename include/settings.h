@@ -1,3 +1,6 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
 // ======================================================================================================================================
 // = SETUP GUIDE ========================================================================================================================
 
@@ -8,10 +11,18 @@
 //          -  set #define RADIO_ROLE to RADIO_TRAINING
 //      - TESTING:
 //          -  set #define RADIO_ROLE to RADIO_MASTER or RADIO_SLAVE (required for communication between the boxes)
+//          -  groups of more than two boxes: one RADIO_MASTER, all others RADIO_SLAVE with different RADIO_MEMBER_IDs (1, 2, ...),
+//             RADIO_GROUP_SIZE and GROUP_QUORUM the same on all boxes of the group
+//      - PAIRING (instead of setting RADIO_CHANNEL and RADIO_MEMBER_ID per box):
+//          -  switch the slave on while holding its lever pulled down, then press LONG LONG LONG on the master's remote
+//          -  the master numbers its slaves in the order they are paired (once the group is full, pairing starts a new group)
+//      - DEBUGGING the radio link of a pair/group (optional, on a spare box):
+//          -  set #define RADIO_ROLE to RADIO_SNIFFER and the SNIFFER settings below
 
 // (2.) CHANNEL of the apparatus  (only for TESTING)
 //      - When using the apparatus for TESTING, master and slave must use the same channel (#define RADIO_CHANNEL).
 //      - When using multiple pairs in TESTING mode, the different pairs must have different channels (so the communication between different pairs doesn't interfere).
+//      - Or, for many pairs: slotted mode (#define RADIO_SLOT_COUNT > 0), all pairs on the same channel with different RADIO_SLOT_IDs (one pair must have slot 0).
 
 // ======================================================================================================================================
 // = MAIN SETTINGS ======================================================================================================================
@@ -22,16 +33,45 @@
 #define RADIO_TRAINING 2                                                      // Role for TRAINING sessions
 #define RADIO_SLAVE 0                                                         // Role that sends status to MASTER and receives instructions from MASTER
 #define RADIO_MASTER 1                                                        // Role that receives status from SLAVE and sends instructions to SLAVE
-#define RADIO_ROLE RADIO_MASTER                                               // Role of this apparatus - change to RADIO_<ROLE> (ROLE = MASTER/SLAVE/TRAINING) to select role
+#define RADIO_SNIFFER 3                                                       // Role of a spare box that only captures the frames of one pair/group (debugging, see SNIFFER below)
+#define RADIO_ROLE RADIO_MASTER                                               // Role of this apparatus - change to RADIO_<ROLE> (ROLE = MASTER/SLAVE/TRAINING/SNIFFER) to select role
                                                                               // !! For TESTING sessions, one apparatus must be RADIO_MASTER and one RADIO_SLAVE !!
 
 #define RADIO_CE_PIN 9                                                        // Pin ID nRF24L01 CE Pin
 #define RADIO_CSN_PIN 10                                                      // Pin ID nRF24L01 CSN Pin
+#define RADIO_IRQ_PIN 8                                                       // Pin ID nRF24L01 IRQ Pin (must be on port B (pins 8-13), read with a pin-change interrupt)
+
+#define RADIO_GROUP_SIZE 2                                                    // Number of boxes in one group (2-6): one RADIO_MASTER and RADIO_GROUP_SIZE - 1 RADIO_SLAVEs
+#define RADIO_MEMBER_ID 1                                                     // Number of this RADIO_SLAVE in its group (1 to RADIO_GROUP_SIZE - 1), different for each slave
+#define RADIO_BROADCAST_REPEATS 3                                             // Groups > 2: master commands go to all slaves at once without ACK, each sent this often
 
 #define RADIO_TRANSMISSION_MAX_ATTEMPTS 5                                     // Max attempts when trying to send a transmission
+#define RADIO_ADAPTIVE_ENABLED true                                           // Tune retry delay, retry count and PA level at runtime from the measured link quality
+#define RADIO_PA_LEVEL RF24_PA_LOW                                            // PA level (= lowest level with RADIO_ADAPTIVE_ENABLED) (PA = Power amplifier)
+#define RADIO_PA_LEVEL_MAX RF24_PA_HIGH                                       // Highest PA level with RADIO_ADAPTIVE_ENABLED (RF24_PA_MAX could cause power supply problems)
+
+#define RADIO_ACK_PAYLOAD_ENABLED true                                        // Master preloads its instruction for a synchronous slave pull into the radio ACK (saves a transmission, pairs only)
 
 #define RADIO_CHANNEL 76                                                      // Channel for transmission between master and slave (0-125)
                                                                               // Must be same for one pair of master and slave, but different for different pairs
+#define RADIO_CHANNEL_SURVEY false                                            // At startup scan all channels, print the spectrum and move master and slave(s) to the quietest channel
+                                                                              // (RADIO_CHANNEL stays the meeting and fallback channel, not with slotted mode)
+#define RADIO_SURVEY_MAX_CHANNEL 83                                           // Highest channel the survey or the pairing may choose (2483 MHz, upper end of the 2.4 GHz ISM band)
+
+#define RADIO_PAIRING_ENABLED true                                            // Pairing with the remote: LONG_LONG_LONG on the master, slave switched on with the lever pulled down
+                                                                              // (paired boxes keep their private addresses, member number and channel in EEPROM)
+#define RADIO_PAIRING_CHANNEL 2                                               // Channel master and slave meet on while pairing
+
+#define RADIO_SLOT_COUNT 0                                                    // Slotted mode: number of time slots (0 = off), pairs on one channel then only transmit in their own slot
+#define RADIO_SLOT_ID 0                                                       // Slot of this pair (0 to RADIO_SLOT_COUNT - 1), same on master and slave(s) but different for different pairs
+                                                                              // The master with slot 0 sends the beacon all others align to
+#define RADIO_SLOT_MICROS 30000                                               // Duration of one slot (RADIO_SLOT_COUNT * RADIO_SLOT_MICROS = max wait for the own slot)
+
+// SNIFFER (#define RADIO_ROLE RADIO_SNIFFER, captures are decoded with ../tools/sniffer_decode.cpp)
+#define SNIFFER_CHANNEL RADIO_CHANNEL                                         // Channel to capture on, or SNIFFER_SWEEP to sweep all channels (stays where there is traffic)
+#define SNIFFER_GROUP 0                                                       // Box ID of the master of a paired group (printed at its startup), 0 = the pair/group of RADIO_CHANNEL
+                                                                              // and RADIO_SLOT_ID (set both as on the pair/group to capture)
+#define SNIFFER_BAUD 1000000                                                  // Serial speed of the binary capture stream
 
 // AUDIO
 #define ENABLE_AUDIO true
@@ -55,6 +95,7 @@
 // TIMINGS
 #define SECOND_MICROS 1e6                                                     // One second in microseconds
 #define SYNCH_MICROS 5 * SECOND_MICROS                                        // Time window in which lever pull in both boxes results in reward
+#define GROUP_QUORUM RADIO_GROUP_SIZE                                         // Number of levers (master's included) that must be pulled within SYNCH_MICROS of the master's pull
 #define ITI_MICROS 5 * SECOND_MICROS                                          // Inter trial interval duration in micros (time for which lever is locked)
 #define LONG_TIMEOUT_MICROS 120 * SECOND_MICROS                               // Long timeout after SYNCH_PULL_MAX synchPulls
 
@@ -76,6 +117,18 @@
 
 // DEBUG
 #define PRINT_DEBUG false                                                     // If true, debug print outs are enabled (printing payloads, loop time, etc to monitor) (keep false for training/testing mode)
+                                                                              // Independent of PRINT_DEBUG: send L over serial for the link quality record (see ../include/LinkStats.h),
+                                                                              // M for free SRAM and stack depth (see ../include/StackMonitor.h, also printed with the loop times)
+#define TRACE_ENABLED false                                                   // If true, every input of the task logic is written as a ~ line between the serial output, a captured log
+                                                                              // can be replayed on the host (see ../include/Trace.h and ../native/replay.cpp)
+#define LOOP_PROFILE_ENABLED true                                             // If true, loop() phases are timed (min, max, histogram, slowest loop), send P over serial for the record
+                                                                              // (see ../include/LoopProfiler.h)
+#define EVENT_LOG_ENABLED true                                                // If true, state changes, lever edges and rewards go out as binary records that never block loop()
+                                                                              // (decode the serial stream with ../tools/event_decode.cpp, see ../include/EventLog.h), false = text lines at 9600 baud
+#define EVENT_LOG_BAUD 1000000                                                // Serial speed with EVENT_LOG_ENABLED
+#define WATCHDOG_ENABLED true                                                 // If true, a hang in setup() or loop() resets the box, it reports the stalled loop phase and resumes with the
+                                                                              // lever locked (see ../include/Watchdog.h, needs Optiboot: board nanoatmega328new)
+#define WATCHDOG_TIMEOUT WDTO_1S                                              // Longest loop() before the watchdog resets the box (WDTO_ constant of avr/wdt.h, 8 s during setup())
 
 // ======================================================================================================================================
 // = APPARATUS CONFIGURATION ============================================================================================================
@@ -93,7 +146,7 @@
 #define LEVER_DOWN_PIN 4                                                      // Pin ID where the LEVER_DOWN input is read from
 #define LEVER_DOWN_STATE HIGH                                                 // State in wich the LEVER_DOWN_STATE input is true
 
-#define LEVER_DEBOUNCING_MICROS SECOND_MICROS * 1 / 10                        // LEVER debouncing duration
+#define LEVER_DEBOUNCING_MICROS SECOND_MICROS * 1 / 10                        // LEVER debouncing hold-off (first edge counts immediately, bounces within this time are ignored)
 
 // MOTOR
 #define DEPLOYER_PIN 5                                                        // Pin ID where the deployer continuous rotation servo is connected
@@ -129,4 +182,6 @@
 // 5 -/-
 // 6 SPK1 -> Speaker red cable (not arduino pin)
 // 7 GND  -> GND
-// 8 SPK2 -> Speaker black cable (not arduino pin)
\ No newline at end of file
+// 8 SPK2 -> Speaker black cable (not arduino pin)
+
+#endif
@@ -0,0 +1,78 @@
+/* Event records on the host
+ *  - Checks the binary records of include/EventLog.h and renders them as the text line the firmware prints without
+ *    EVENT_LOG_ENABLED, or as CSV fields
+ *  - Used by the native HAL (a record reaches the session driver as its text line) and by tools/event_decode.cpp
+ */
+
+#ifndef EVENT_FORMAT_H
+#define EVENT_FORMAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <string>
+
+#include "EventLog.h"
+
+struct EventRecord
+{
+    uint8_t event;
+    uint32_t time; // micros() of the box
+    uint32_t value;
+};
+
+// src/main.cpp
+static const char *const eventStateNames[] = {"ST_START",     "ST_UNLOCKLEVER", "ST_LEVERFULLUP", "ST_LEVERFULLDOWN",
+                                              "ST_SYNCBOXES", "ST_REWARD",      "ST_LOCKLEVER",   "ST_WAIT"};
+static const uint32_t eventStateCount = sizeof(eventStateNames) / sizeof(eventStateNames[0]);
+
+// by event_id
+static const char *const eventNames[EVENT_COUNT] = {"dropped", "state",    "leverUp",      "leverDown",
+                                                    "deploy",  "pullGoal", "rewardLatency"};
+static const char *const eventLines[EVENT_COUNT] = {"Events dropped: ", "State: ",
+                                                    "leverUp: ",        "leverDown: ",
+                                                    "deployCounter: ",  "New random pull goal: ",
+                                                    "Pull to reward latency: "};
+
+// wire: EVENT_LOG_WIRE_LEN bytes from EVENT_LOG_SYNC on, false if the checksum or the event doesn't fit
+inline bool eventParse(const uint8_t *wire, EventRecord *record)
+{
+    const uint8_t *bytes = wire + 1;
+    uint8_t checksum = 0;
+    for (int i = 0; i < EVENT_LOG_RECORD_LEN; i++)
+    {
+        checksum += bytes[i];
+    }
+    if (wire[0] != EVENT_LOG_SYNC || checksum != bytes[EVENT_LOG_RECORD_LEN] || bytes[0] >= EVENT_COUNT)
+    {
+        return false;
+    }
+    record->event = bytes[0];
+    record->time = 0;
+    record->value = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        record->time |= (uint32_t)bytes[1 + i] << (8 * i);
+        record->value |= (uint32_t)bytes[5 + i] << (8 * i);
+    }
+    return record->event != EVENT_STATE || record->value < eventStateCount;
+}
+
+// value as the firmware prints it (state name, number)
+inline std::string eventValue(const EventRecord &record)
+{
+    if (record.event == EVENT_STATE)
+    {
+        return eventStateNames[record.value];
+    }
+    char number[12];
+    snprintf(number, sizeof(number), "%lu", (unsigned long)record.value);
+    return number;
+}
+
+inline std::string eventLine(const EventRecord &record)
+{
+    return eventLines[record.event] + eventValue(record);
+}
+
+#endif
@@ -0,0 +1,367 @@
+/* Session (native HAL)
+ *  - What the session drivers (session.cpp, sweep.cpp) put around the boxes: a recorder of everything the boxes put
+ *    out, animals pulling the levers, the remote and the power-on of a master/slave pair
+ *  - Settings the sweep varies are read at runtime (box_settings.h), so the checks follow them
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include "box_settings.h"
+
+#define SESSION_MINUTE 60000000ULL
+#define SESSION_SECOND 1000000ULL
+#define SESSION_SETTLE_MICROS (30 * SESSION_SECOND) // animals stop this long before the end, so the counts settle
+#define SESSION_TICK_MICROS 10000                  // animals look at their lever lock this often
+#define SESSION_SYNCH_MARGIN_MICROS 500000         // radio latency and clock drift on top of SYNCH_MICROS
+#define SESSION_REWARD_MICROS 1000000              // a due reward comes this soon (all retransmissions included)
+#define SESSION_LOOP_MICROS 5000                   // slowest loop() allowed on a lossy or cut link
+#define SESSION_LEVER_TRAVEL_MICROS 80000          // lever from leaving the up switch to reaching the down switch
+#define SESSION_LEVER_HOLD_MICROS 300000           // lever held down
+#define SESSION_FOLLOW_MICROS 1000000              // mean reaction of a follower to its partner's pull
+#define SESSION_REMOTE_SHORT_MICROS 150000
+#define SESSION_REMOTE_LONG_MICROS 800000
+#define SESSION_REMOTE_GAP_MICROS 250000 // between the presses of one gesture
+
+// everything the boxes put out
+class Recorder : public hal::Listener
+{
+public:
+    struct Record
+    {
+        std::vector<hal::Time> rewards; // deployer switched on
+        std::vector<std::pair<hal::Time, std::string>> lines;
+        int txFailures = 0;         // AUDIO_SOUND_TRANSMISSION_FAIL played
+        hal::Time lockedMicros = 0; // lever lock closed
+        hal::Time lockedSince = 0;
+        bool locked = false;
+        int longTimeouts = 0;   // lock closed for about ITI_MICROS + LONG_TIMEOUT_MICROS
+        int windowTimeouts = 0; // ST_SYNCBOXES left to ST_START: the synch window ran out
+        hal::Time synchSince = 0;
+        bool synching = false;
+        std::vector<hal::Time> trials; // ST_SYNCBOXES entered
+    };
+
+    void serialLine(hal::Box *box, const char *line) override
+    {
+        Record &record = this->records[box];
+        if (this->keepLines)
+        {
+            record.lines.push_back(std::make_pair(hal::now(), std::string(line)));
+        }
+        if (this->verbose)
+        {
+            printf("%10.3f %-8s %s\n", hal::now() / 1e6, box->name, line);
+        }
+        if (this->log && !strcmp(box->name, this->logBox))
+        {
+            fprintf(this->log, "%s\n", line);
+        }
+        if (!strncmp(line, "State: ", 7))
+        {
+            bool windowOver = hal::now() - record.synchSince >= 0.9 * SYNCH_MICROS;
+            record.windowTimeouts += record.synching && windowOver && !strcmp(line, "State: ST_START");
+            record.synching = !strcmp(line, "State: ST_SYNCBOXES");
+            record.synchSince = hal::now();
+            if (record.synching)
+            {
+                record.trials.push_back(hal::now());
+            }
+        }
+    }
+
+    void audio(hal::Box *box, uint8_t folder, uint8_t file) override
+    {
+        (void)folder;
+        if (file == AUDIO_SOUND_TRANSMISSION_FAIL)
+        {
+            this->records[box].txFailures++;
+        }
+    }
+
+    void pwm(hal::Box *box, uint8_t pin, int value) override
+    {
+        if (pin == DEPLOYER_PIN && value)
+        {
+            this->records[box].rewards.push_back(hal::now());
+        }
+    }
+
+    void servo(hal::Box *box, uint8_t pin, int angle) override
+    {
+        Record &record = this->records[box];
+        if (pin != LEVERLOCK_PIN || record.locked == (angle != 0))
+        {
+            return;
+        }
+        record.locked = angle != 0;
+        if (record.locked)
+        {
+            record.lockedSince = hal::now();
+            return;
+        }
+        hal::Time locked = hal::now() - record.lockedSince;
+        record.lockedMicros += locked;
+        record.longTimeouts += locked >= (ITI_MICROS + LONG_TIMEOUT_MICROS) / 2;
+    }
+
+    // lever lock closed until now, the lock still closed included
+    hal::Time lockedMicros(hal::Box *box)
+    {
+        Record &record = this->records[box];
+        return record.lockedMicros + (record.locked ? hal::now() - record.lockedSince : 0);
+    }
+
+    // number of lines containing text printed by box at or after from
+    int printed(hal::Box *box, const char *text, hal::Time from = 0)
+    {
+        int count = 0;
+        for (const std::pair<hal::Time, std::string> &line : this->records[box].lines)
+        {
+            count += line.first >= from && line.second.find(text) != std::string::npos;
+        }
+        return count;
+    }
+
+    std::map<hal::Box *, Record> records;
+    bool keepLines = true; // off for long sessions, the counters don't need the lines
+    bool verbose = false;  // prints the serial output of the boxes
+    FILE *log = NULL;      // serial output of logBox as captured from its port (e.g. a trace to replay)
+    const char *logBox = NULL;
+};
+
+extern Recorder recorder;
+
+// animal at one box: pulls the lever at random (exponential wait, from the moment the lever is unlocked), a follower
+// pulls as well shortly after this animal's pull with followChance
+class Animal
+{
+public:
+    Animal(hal::Box *box, double meanMicros) : box(box), meanMicros(meanMicros) {}
+
+    void start(hal::Time time, hal::Time until)
+    {
+        this->until = until;
+        hal::at(time, [this]() { this->tick(); });
+    }
+
+    // pulls at or after from (down switch reached)
+    int pullsSince(hal::Time from) const
+    {
+        int count = 0;
+        for (hal::Time pull : this->pulls)
+        {
+            count += pull >= from;
+        }
+        return count;
+    }
+
+    // the partner pulled: pull soon, unless a pull is due earlier anyway
+    void prompt()
+    {
+        if (this->pulling || this->box->servo[LEVERLOCK_PIN] != 0)
+        {
+            return;
+        }
+        hal::Time soon = hal::now() + hal::exponential(SESSION_FOLLOW_MICROS);
+        if (!this->nextPull || soon < this->nextPull)
+        {
+            this->nextPull = soon;
+        }
+    }
+
+    hal::Box *box;
+    std::vector<hal::Time> pulls;
+    Animal *follower = NULL;
+    double followChance = 0;
+
+private:
+    void tick()
+    {
+        hal::Time now = hal::now();
+        if (now >= this->until)
+        {
+            return;
+        }
+        hal::at(now + SESSION_TICK_MICROS, [this]() { this->tick(); });
+        if (this->pulling)
+        {
+            return;
+        }
+        if (this->box->servo[LEVERLOCK_PIN] != 0) // locked (or never unlocked)
+        {
+            this->nextPull = 0;
+            return;
+        }
+        if (!this->nextPull)
+        {
+            this->nextPull = now + hal::exponential(this->meanMicros);
+        }
+        if (now + SESSION_TICK_MICROS > this->nextPull) // pull at the exact time, not on the tick
+        {
+            this->pulling = true;
+            hal::at(this->nextPull, [this]() { this->pull(hal::now()); });
+            this->nextPull = 0;
+        }
+    }
+
+    // up switch opens (with a bounce), down switch closes, held, released, back up
+    void pull(hal::Time now)
+    {
+        hal::Box *box = this->box;
+        this->pulling = true;
+        box->setPin(LEVER_UP_PIN, !LEVER_UP_STATE);
+        hal::at(now + 2000, [box]() { box->setPin(LEVER_UP_PIN, LEVER_UP_STATE); });
+        hal::at(now + 3000, [box]() { box->setPin(LEVER_UP_PIN, !LEVER_UP_STATE); });
+        hal::at(now + SESSION_LEVER_TRAVEL_MICROS, [this, box]() {
+            box->setPin(LEVER_DOWN_PIN, LEVER_DOWN_STATE);
+            this->pulls.push_back(hal::now());
+            if (this->follower && hal::chance(this->followChance))
+            {
+                this->follower->prompt();
+            }
+        });
+        hal::Time release = now + SESSION_LEVER_TRAVEL_MICROS + SESSION_LEVER_HOLD_MICROS;
+        hal::at(release, [box]() { box->setPin(LEVER_DOWN_PIN, !LEVER_DOWN_STATE); });
+        hal::at(release + SESSION_LEVER_TRAVEL_MICROS, [this, box]() {
+            box->setPin(LEVER_UP_PIN, LEVER_UP_STATE);
+            this->pulling = false;
+        });
+    }
+
+    double meanMicros;
+    hal::Time until = 0;
+    hal::Time nextPull = 0;
+    bool pulling = false;
+};
+
+// lever at rest, remote released
+static inline void rest(hal::Box *box)
+{
+    box->setPin(LEVER_UP_PIN, LEVER_UP_STATE);
+    box->setPin(LEVER_DOWN_PIN, !LEVER_DOWN_STATE);
+    box->setPin(REMOTE_PIN, LOW); // the remote receiver drives the pin high while the button is pressed
+}
+
+// remote gesture at time, e.g. "S" (SHORT), "L" (LONG), "LLL" (LONG_LONG_LONG)
+static inline void press(hal::Box *box, hal::Time time, const char *gesture)
+{
+    for (; *gesture; gesture++)
+    {
+        hal::Time duration = *gesture == 'L' ? SESSION_REMOTE_LONG_MICROS : SESSION_REMOTE_SHORT_MICROS;
+        hal::at(time, [box]() { box->setPin(REMOTE_PIN, HIGH); });
+        hal::at(time + duration, [box]() { box->setPin(REMOTE_PIN, LOW); });
+        time += duration + SESSION_REMOTE_GAP_MICROS;
+    }
+}
+
+// servo angle of the lever lock at time (written into angles, read after the run)
+static inline void sample(hal::Box *box, hal::Time time, int *angle)
+{
+    hal::at(time, [box, angle]() { *angle = box->servo[LEVERLOCK_PIN]; });
+}
+
+// how a pair served the synchronous pulls: a master trial with a slave pull clearly inside its synch window (and
+// no reward since) must be rewarded right after the later of the two pulls, every master reward must come out of
+// the slave exactly once
+struct Synchrony
+{
+    int pulls = 0;       // synchronous pulls
+    int missed = 0;      // synchronous pulls the master didn't reward within SESSION_REWARD_MICROS
+    int slaveMissed = 0; // master rewards without a slave reward
+    int duplicated = 0;  // slave rewards without a master reward of their own
+};
+
+static inline Synchrony synchrony(hal::Box *master, hal::Box *slave, const Animal &slaveAnimal)
+{
+    Synchrony result;
+    const std::vector<hal::Time> &rewards = recorder.records[master].rewards;
+    const std::vector<hal::Time> &slaveRewards = recorder.records[slave].rewards;
+    const std::vector<hal::Time> &pulls = slaveAnimal.pulls;
+    hal::Time window = SYNCH_MICROS > SESSION_SYNCH_MARGIN_MICROS ? SYNCH_MICROS - SESSION_SYNCH_MARGIN_MICROS : 0;
+    size_t reward = 0, pull = 0; // first master reward at or after the trial, first slave pull that can count
+    for (hal::Time trial : recorder.records[master].trials)
+    {
+        while (reward < rewards.size() && rewards[reward] < trial)
+        {
+            reward++;
+        }
+        hal::Time from = trial > window ? trial - window : 0;
+        if (reward && rewards[reward - 1] >= from)
+        {
+            from = rewards[reward - 1] + 1; // pulls before the last reward were used up by it
+        }
+        while (pull < pulls.size() && pulls[pull] < from)
+        {
+            pull++;
+        }
+        if (pull == pulls.size() || pulls[pull] > trial + window)
+        {
+            continue;
+        }
+        result.pulls++;
+        result.missed += reward == rewards.size() || rewards[reward] > max(trial, pulls[pull]) + SESSION_REWARD_MICROS;
+    }
+
+    // pair every slave reward with the earliest master reward close to it that has none yet
+    std::vector<bool> paired(rewards.size(), false);
+    size_t first = 0;
+    for (hal::Time slaveReward : slaveRewards)
+    {
+        while (first < rewards.size() && rewards[first] + SESSION_REWARD_MICROS < slaveReward)
+        {
+            first++;
+        }
+        size_t match = first;
+        while (match < rewards.size() && paired[match])
+        {
+            match++;
+        }
+        if (match < rewards.size() && rewards[match] <= slaveReward + SESSION_REWARD_MICROS)
+        {
+            paired[match] = true;
+        }
+        else
+        {
+            result.duplicated++;
+        }
+    }
+    for (bool rewarded : paired)
+    {
+        result.slaveMissed += !rewarded;
+    }
+    return result;
+}
+
+static inline void startPair(hal::Box *master, hal::Box *slave)
+{
+    slave->clockPpm = 50;                      // crystal tolerance, the clock sync has something to do
+    slave->clockOffset = 0x80000000 - 15000; // half the micros() range apart, the offset crosses 2^31 after 5 minutes
+    rest(master);
+    rest(slave);
+    master->start(0);
+    slave->start(300000);
+}
+
+void check(bool condition, const char *what); // session.cpp, prints the check and fails the scenario if false
+
+void leverRing(); // units.cpp
+void debounce();  // units.cpp
+void frames();    // units.cpp
+void profiler();  // units.cpp
+void clockSync(); // units.cpp
+
+int sweep(const char *program, int argc, char **argv); // sweep.cpp, runs program sweep-session for every session
+int sweepSession(int argc, char **argv);               // one session of the sweep
+int replay(int argc, char **argv);                     // replay.cpp
+
+#endif
@@ -0,0 +1,30 @@
+/* Box of the group (native HAL)
+ *  - The firmware built for a group of GROUP_BOXES boxes with a quorum of GROUP_BOX_QUORUM levers, one box per
+ *    native/box_group_*.cpp: it defines GROUP_BOX_NAME, GROUP_BOX_NAMESPACE, GROUP_BOX_ROLE and GROUP_BOX_MEMBER, then
+ *    includes this file (settings.h as it is otherwise, like the pair boxes)
+ *  - The group boxes share the medium with the pair boxes, a scenario only starts the boxes it uses
+ */
+
+#include "box_headers.h"
+
+#include "settings.h"
+#undef RADIO_ROLE
+#undef RADIO_GROUP_SIZE
+#undef RADIO_MEMBER_ID
+#undef GROUP_QUORUM
+#define RADIO_ROLE GROUP_BOX_ROLE
+#define RADIO_GROUP_SIZE GROUP_BOXES
+#define RADIO_MEMBER_ID GROUP_BOX_MEMBER
+#define GROUP_QUORUM GROUP_BOX_QUORUM
+#include "box_settings.h"
+
+static hal::Box box(GROUP_BOX_NAME, RADIO_IRQ_PIN); // current while the global objects of the firmware are constructed
+
+namespace GROUP_BOX_NAMESPACE
+{
+#include "box_sources.h"
+}
+
+static const bool programmed =
+    box.program(GROUP_BOX_NAMESPACE::setup, GROUP_BOX_NAMESPACE::loop, GROUP_BOX_NAMESPACE::PCINT0_vect,
+                GROUP_BOX_NAMESPACE::PCINT1_vect, GROUP_BOX_NAMESPACE::PCINT2_vect);
@@ -0,0 +1,9 @@
+/* MASTER of the group (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_MASTER in namespace group_master, see box_group.h
+ */
+
+#define GROUP_BOX_NAME "group-master"
+#define GROUP_BOX_NAMESPACE group_master
+#define GROUP_BOX_ROLE RADIO_MASTER
+#define GROUP_BOX_MEMBER 1 // unused by the master
+#include "box_group.h"
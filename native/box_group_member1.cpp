@@ -0,0 +1,9 @@
+/* MEMBER 1 of the group (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE and RADIO_MEMBER_ID 1 in namespace member_1, see box_group.h
+ */
+
+#define GROUP_BOX_NAME "member-1"
+#define GROUP_BOX_NAMESPACE member_1
+#define GROUP_BOX_ROLE RADIO_SLAVE
+#define GROUP_BOX_MEMBER 1
+#include "box_group.h"
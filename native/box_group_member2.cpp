@@ -0,0 +1,9 @@
+/* MEMBER 2 of the group (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE and RADIO_MEMBER_ID 2 in namespace member_2, see box_group.h
+ */
+
+#define GROUP_BOX_NAME "member-2"
+#define GROUP_BOX_NAMESPACE member_2
+#define GROUP_BOX_ROLE RADIO_SLAVE
+#define GROUP_BOX_MEMBER 2
+#include "box_group.h"
@@ -0,0 +1,9 @@
+/* MEMBER 3 of the group (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE and RADIO_MEMBER_ID 3 in namespace member_3, see box_group.h
+ */
+
+#define GROUP_BOX_NAME "member-3"
+#define GROUP_BOX_NAMESPACE member_3
+#define GROUP_BOX_ROLE RADIO_SLAVE
+#define GROUP_BOX_MEMBER 3
+#include "box_group.h"
@@ -0,0 +1,25 @@
+/* Headers of the boxes (native HAL)
+ *  - Included before the namespace of a box, so the includes of the firmware find them already included and all
+ *    boxes share one Arduino core, one radio medium and the standard library
+ */
+
+#ifndef BOX_HEADERS_H
+#define BOX_HEADERS_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Arduino.h>
+#include <DFRobotDFPlayerMini.h>
+#include <EEPROM.h>
+#include <NeoSWSerial.h>
+#include <RF24.h>
+#include <SPI.h>
+#include <Servo.h>
+#include <printf.h>
+#include <avr/wdt.h>
+
+#endif
@@ -0,0 +1,21 @@
+/* MASTER box (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_MASTER in namespace master, settings.h as it is otherwise (session settings at
+ *    runtime, box_settings.h)
+ */
+
+#include "box_headers.h"
+
+#include "settings.h"
+#undef RADIO_ROLE
+#define RADIO_ROLE RADIO_MASTER
+#include "box_settings.h"
+
+static hal::Box box("master", RADIO_IRQ_PIN); // current while the global objects of the firmware are constructed
+
+namespace master
+{
+#include "box_sources.h"
+}
+
+static const bool programmed = box.program(master::setup, master::loop, master::PCINT0_vect, master::PCINT1_vect,
+                                           master::PCINT2_vect);
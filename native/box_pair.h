@@ -0,0 +1,40 @@
+/* Box of an extra pair (native HAL)
+ *  - Pairs next to master/slave for the scenarios with several pairs on the air, one box per native/box_pair_*.cpp:
+ *    it defines PAIR_BOX_NAME, PAIR_BOX_NAMESPACE and PAIR_BOX_ROLE, plus the settings it changes (PAIR_BOX_SLOT_COUNT,
+ *    PAIR_BOX_SLOT_ID, PAIR_BOX_CHANNEL, PAIR_BOX_ADAPTIVE), then includes this file (settings.h as it is otherwise)
+ *  - Pairs on one channel keep apart by their addresses (RADIO_SLOT_ID), with or without slots
+ */
+
+#include "box_headers.h"
+
+#include "settings.h"
+#undef RADIO_ROLE
+#define RADIO_ROLE PAIR_BOX_ROLE
+#ifdef PAIR_BOX_SLOT_COUNT
+#undef RADIO_SLOT_COUNT
+#define RADIO_SLOT_COUNT PAIR_BOX_SLOT_COUNT
+#endif
+#ifdef PAIR_BOX_SLOT_ID
+#undef RADIO_SLOT_ID
+#define RADIO_SLOT_ID PAIR_BOX_SLOT_ID
+#endif
+#ifdef PAIR_BOX_CHANNEL
+#undef RADIO_CHANNEL
+#define RADIO_CHANNEL PAIR_BOX_CHANNEL
+#endif
+#ifdef PAIR_BOX_ADAPTIVE
+#undef RADIO_ADAPTIVE_ENABLED
+#define RADIO_ADAPTIVE_ENABLED PAIR_BOX_ADAPTIVE
+#endif
+#include "box_settings.h"
+
+static hal::Box box(PAIR_BOX_NAME, RADIO_IRQ_PIN); // current while the global objects of the firmware are constructed
+
+namespace PAIR_BOX_NAMESPACE
+{
+#include "box_sources.h"
+}
+
+static const bool programmed =
+    box.program(PAIR_BOX_NAMESPACE::setup, PAIR_BOX_NAMESPACE::loop, PAIR_BOX_NAMESPACE::PCINT0_vect,
+                PAIR_BOX_NAMESPACE::PCINT1_vect, PAIR_BOX_NAMESPACE::PCINT2_vect);
@@ -0,0 +1,11 @@
+/* SLAVE of the pair with fixed radio settings (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE, RADIO_ADAPTIVE_ENABLED false and RADIO_CHANNEL 86 (next to
+ *    master/slave, not in its way) in namespace fixed_slave, see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "fixed-slave"
+#define PAIR_BOX_NAMESPACE fixed_slave
+#define PAIR_BOX_ROLE RADIO_SLAVE
+#define PAIR_BOX_ADAPTIVE false
+#define PAIR_BOX_CHANNEL 86
+#include "box_pair.h"
@@ -0,0 +1,10 @@
+/* SLAVE of pair 1 on the channel of master/slave, without slots (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE and RADIO_SLOT_ID 1 (own addresses) in namespace free1_slave,
+ *    see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "free1-slave"
+#define PAIR_BOX_NAMESPACE free1_slave
+#define PAIR_BOX_ROLE RADIO_SLAVE
+#define PAIR_BOX_SLOT_ID 1
+#include "box_pair.h"
@@ -0,0 +1,10 @@
+/* MASTER of pair 2 on the channel of master/slave, without slots (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_MASTER and RADIO_SLOT_ID 2 (own addresses) in namespace free2_master,
+ *    see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "free2-master"
+#define PAIR_BOX_NAMESPACE free2_master
+#define PAIR_BOX_ROLE RADIO_MASTER
+#define PAIR_BOX_SLOT_ID 2
+#include "box_pair.h"
@@ -0,0 +1,11 @@
+/* SLAVE of slotted pair 0 (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE, RADIO_SLOT_COUNT SLOT_PAIRS and RADIO_SLOT_ID 0 in namespace
+ *    slot0_slave, see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "slot0-slave"
+#define PAIR_BOX_NAMESPACE slot0_slave
+#define PAIR_BOX_ROLE RADIO_SLAVE
+#define PAIR_BOX_SLOT_COUNT SLOT_PAIRS
+#define PAIR_BOX_SLOT_ID 0
+#include "box_pair.h"
@@ -0,0 +1,11 @@
+/* MASTER of slotted pair 1 (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_MASTER, RADIO_SLOT_COUNT SLOT_PAIRS and RADIO_SLOT_ID 1 in namespace
+ *    slot1_master, see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "slot1-master"
+#define PAIR_BOX_NAMESPACE slot1_master
+#define PAIR_BOX_ROLE RADIO_MASTER
+#define PAIR_BOX_SLOT_COUNT SLOT_PAIRS
+#define PAIR_BOX_SLOT_ID 1
+#include "box_pair.h"
@@ -0,0 +1,11 @@
+/* SLAVE of slotted pair 1 (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE, RADIO_SLOT_COUNT SLOT_PAIRS and RADIO_SLOT_ID 1 in namespace
+ *    slot1_slave, see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "slot1-slave"
+#define PAIR_BOX_NAMESPACE slot1_slave
+#define PAIR_BOX_ROLE RADIO_SLAVE
+#define PAIR_BOX_SLOT_COUNT SLOT_PAIRS
+#define PAIR_BOX_SLOT_ID 1
+#include "box_pair.h"
@@ -0,0 +1,11 @@
+/* MASTER of slotted pair 2 (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_MASTER, RADIO_SLOT_COUNT SLOT_PAIRS and RADIO_SLOT_ID 2 in namespace
+ *    slot2_master, see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "slot2-master"
+#define PAIR_BOX_NAMESPACE slot2_master
+#define PAIR_BOX_ROLE RADIO_MASTER
+#define PAIR_BOX_SLOT_COUNT SLOT_PAIRS
+#define PAIR_BOX_SLOT_ID 2
+#include "box_pair.h"
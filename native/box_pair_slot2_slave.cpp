@@ -0,0 +1,11 @@
+/* SLAVE of slotted pair 2 (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE, RADIO_SLOT_COUNT SLOT_PAIRS and RADIO_SLOT_ID 2 in namespace
+ *    slot2_slave, see box_pair.h
+ */
+
+#define PAIR_BOX_NAME "slot2-slave"
+#define PAIR_BOX_NAMESPACE slot2_slave
+#define PAIR_BOX_ROLE RADIO_SLAVE
+#define PAIR_BOX_SLOT_COUNT SLOT_PAIRS
+#define PAIR_BOX_SLOT_ID 2
+#include "box_pair.h"
@@ -0,0 +1,118 @@
+/* Session settings of the boxes (native HAL)
+ *  - Defaults from settings.h, HAL_SETTINGS="synch=3e6 iti=5e6 long=120e6 pullmax=12 count1=1 count2=3 count3=6
+ *    trace=1 events=0 loop=250" overrides any of them (micros, counts, TRACE_ENABLED, EVENT_LOG_ENABLED,
+ *    hal::loopMicros)
+ *  - The radio channel (hal::channel) as well: "loss=0.1 burst=0.001 burstlen=20 burstloss=0.9 ackloss=0.05
+ *    latency=2000 jitter=500 offevery=600e6 offfor=10e6" (probabilities, packets, micros)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Hal.h"
+#include "settings.h"
+
+namespace hal
+{
+Settings settings = {SYNCH_MICROS, ITI_MICROS, LONG_TIMEOUT_MICROS, SYNCH_PULL_MAX,
+                     {MODE_TEST_ONE_COUNT, MODE_TEST_TWO_COUNT, MODE_TEST_THREE_COUNT}, TRACE_ENABLED,
+                     EVENT_LOG_ENABLED};
+
+bool loadSettings()
+{
+    static bool loaded = false;
+    const char *text = getenv("HAL_SETTINGS");
+    if (loaded || !text)
+    {
+        return loaded = true;
+    }
+    loaded = true;
+    char key[16];
+    double value;
+    int length;
+    while (sscanf(text, " %15[a-z0-9]=%lf%n", key, &value, &length) == 2)
+    {
+        text += length;
+        if (!strcmp(key, "synch"))
+        {
+            settings.synchMicros = value;
+        }
+        else if (!strcmp(key, "iti"))
+        {
+            settings.itiMicros = value;
+        }
+        else if (!strcmp(key, "long"))
+        {
+            settings.longTimeoutMicros = value;
+        }
+        else if (!strcmp(key, "pullmax"))
+        {
+            settings.synchPullMax = value;
+        }
+        else if (!strncmp(key, "count", 5) && key[5] >= '1' && key[5] <= '3' && !key[6])
+        {
+            settings.modeTestCount[key[5] - '1'] = value;
+        }
+        else if (!strcmp(key, "trace"))
+        {
+            settings.trace = value;
+        }
+        else if (!strcmp(key, "events"))
+        {
+            settings.events = value;
+        }
+        else if (!strcmp(key, "loop"))
+        {
+            loopMicros = value;
+        }
+        else if (!strcmp(key, "loss"))
+        {
+            channel.loss = value;
+        }
+        else if (!strcmp(key, "burst"))
+        {
+            channel.burst = value;
+        }
+        else if (!strcmp(key, "burstlen"))
+        {
+            channel.burstLength = value;
+        }
+        else if (!strcmp(key, "burstloss"))
+        {
+            channel.burstLoss = value;
+        }
+        else if (!strcmp(key, "ackloss"))
+        {
+            channel.ackLoss = value;
+        }
+        else if (!strcmp(key, "latency"))
+        {
+            channel.latencyMicros = value;
+        }
+        else if (!strcmp(key, "jitter"))
+        {
+            channel.jitterMicros = value;
+        }
+        else if (!strcmp(key, "offevery"))
+        {
+            channel.offEveryMicros = value;
+        }
+        else if (!strcmp(key, "offfor"))
+        {
+            channel.offMicros = value;
+        }
+        else
+        {
+            fprintf(stderr, "HAL_SETTINGS: unknown setting %s\n", key);
+            exit(2);
+        }
+    }
+    if (text[strspn(text, " ")])
+    {
+        fprintf(stderr, "HAL_SETTINGS: cannot parse \"%s\"\n", text);
+        exit(2);
+    }
+    return true;
+}
+} // namespace hal
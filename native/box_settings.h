@@ -0,0 +1,41 @@
+/* Session settings of the boxes (native HAL)
+ *  - Included by the boxes after settings.h: the settings a parameter sweep varies, TRACE_ENABLED and
+ *    EVENT_LOG_ENABLED are read from hal::settings at runtime instead of being compiled in, so one build runs every
+ *    combination (native/sweep.cpp), replays traces (native/replay.cpp) and runs with and without the event log
+ *  - hal::settings holds the values of settings.h unless the HAL_SETTINGS environment variable overrides them
+ *  - Size and quorum of the group boxes (native/box_group.h) and the slots of the slotted pairs (native/box_pair.h),
+ *    fixed at compile time like on the boxes
+ */
+
+#ifndef BOX_SETTINGS_H
+#define BOX_SETTINGS_H
+
+#include "Hal.h"
+#include "settings.h"
+
+static const bool settingsLoaded = hal::loadSettings(); // before the global objects of the firmware are constructed
+
+#undef SYNCH_MICROS
+#undef ITI_MICROS
+#undef LONG_TIMEOUT_MICROS
+#undef SYNCH_PULL_MAX
+#undef MODE_TEST_ONE_COUNT
+#undef MODE_TEST_TWO_COUNT
+#undef MODE_TEST_THREE_COUNT
+#undef TRACE_ENABLED
+#undef EVENT_LOG_ENABLED
+#define SYNCH_MICROS (hal::settings.synchMicros)
+#define ITI_MICROS (hal::settings.itiMicros)
+#define LONG_TIMEOUT_MICROS (hal::settings.longTimeoutMicros)
+#define SYNCH_PULL_MAX (hal::settings.synchPullMax)
+#define MODE_TEST_ONE_COUNT (hal::settings.modeTestCount[0])
+#define MODE_TEST_TWO_COUNT (hal::settings.modeTestCount[1])
+#define MODE_TEST_THREE_COUNT (hal::settings.modeTestCount[2])
+#define TRACE_ENABLED (hal::settings.trace)
+#define EVENT_LOG_ENABLED (hal::settings.events)
+
+#define GROUP_BOXES 4      // group boxes (box_group.h): master and three members
+#define GROUP_BOX_QUORUM 3 // levers of the group that have to be pulled together
+#define SLOT_PAIRS 3       // slotted pairs (box_pair_slot*.cpp), RADIO_SLOT_COUNT of their boxes
+
+#endif
@@ -0,0 +1,21 @@
+/* SLAVE box (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_SLAVE in namespace slave, settings.h as it is otherwise (session settings at
+ *    runtime, box_settings.h)
+ */
+
+#include "box_headers.h"
+
+#include "settings.h"
+#undef RADIO_ROLE
+#define RADIO_ROLE RADIO_SLAVE
+#include "box_settings.h"
+
+static hal::Box box("slave", RADIO_IRQ_PIN); // current while the global objects of the firmware are constructed
+
+namespace slave
+{
+#include "box_sources.h"
+}
+
+static const bool programmed = box.program(slave::setup, slave::loop, slave::PCINT0_vect, slave::PCINT1_vect,
+                                           slave::PCINT2_vect);
@@ -0,0 +1,22 @@
+// firmware sources of one box, included inside its namespace (remote.cpp last, its using directive stays in there)
+#include "../src/Apparatus.cpp"
+#include "../src/ChannelSurvey.cpp"
+#include "../src/ClockSync.cpp"
+#include "../src/EventLog.cpp"
+#include "../src/Frame.cpp"
+#include "../src/Group.cpp"
+#include "../src/Heartbeat.cpp"
+#include "../src/LeverEvents.cpp"
+#include "../src/LinkControl.cpp"
+#include "../src/LinkStats.cpp"
+#include "../src/LoopProfiler.cpp"
+#include "../src/Messages.cpp"
+#include "../src/Pairing.cpp"
+#include "../src/RadioLink.cpp"
+#include "../src/SlotClock.cpp"
+#include "../src/Sniffer.cpp"
+#include "../src/StackMonitor.cpp"
+#include "../src/Trace.cpp"
+#include "../src/Watchdog.cpp"
+#include "../src/main.cpp"
+#include "../src/remote.cpp"
@@ -0,0 +1,21 @@
+/* TRAINING box (native HAL)
+ *  - The firmware built with RADIO_ROLE RADIO_TRAINING in namespace training, settings.h as it is otherwise (session settings at
+ *    runtime, box_settings.h)
+ */
+
+#include "box_headers.h"
+
+#include "settings.h"
+#undef RADIO_ROLE
+#define RADIO_ROLE RADIO_TRAINING
+#include "box_settings.h"
+
+static hal::Box box("training", RADIO_IRQ_PIN); // current while the global objects of the firmware are constructed
+
+namespace training
+{
+#include "box_sources.h"
+}
+
+static const bool programmed = box.program(training::setup, training::loop, training::PCINT0_vect, training::PCINT1_vect,
+                                           training::PCINT2_vect);
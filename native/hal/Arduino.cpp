@@ -0,0 +1,193 @@
+/* Arduino core (native HAL)
+ *  - Print formats numbers like the Arduino core (no leading zeros, negative numbers only in base 10)
+ */
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+
+unsigned long micros()
+{
+    return hal::current()->micros();
+}
+
+unsigned long millis()
+{
+    return hal::current()->micros() / 1000;
+}
+
+void delay(unsigned long ms)
+{
+    hal::current()->spend(ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    hal::current()->spend(us);
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode; // inputs are pulled up until the environment drives them
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    hal::current()->setPin(pin, val);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin < HAL_PINS ? hal::current()->level[pin] : LOW;
+}
+
+// unconnected input: noise
+int analogRead(uint8_t pin)
+{
+    hal::Box *box = hal::current();
+    return pin < HAL_PINS && box->analog[pin] >= 0 ? box->analog[pin] : box->random() & 0x3FF;
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+    hal::Box *box = hal::current();
+    if (pin >= HAL_PINS || box->pwm[pin] == val)
+    {
+        return;
+    }
+    box->pwm[pin] = val;
+    if (hal::listener)
+    {
+        hal::listener->pwm(box, pin, val);
+    }
+}
+
+// avr-libc random(): Park-Miller minimal standard generator
+long random(long howbig)
+{
+    uint32_t &context = hal::current()->randomContext;
+    int32_t x = context ? context : 123459876;
+    int32_t hi = x / 127773, lo = x % 127773;
+    x = 16807 * lo - 2836 * hi;
+    if (x < 0)
+    {
+        x += 0x7FFFFFFF;
+    }
+    context = x;
+    return howbig > 0 ? (uint32_t)x % (uint32_t)howbig : 0;
+}
+
+long random(long howsmall, long howbig)
+{
+    return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed)
+    {
+        hal::current()->randomContext = seed;
+    }
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        n += this->write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::print(long n, int base)
+{
+    if (base == 0)
+    {
+        return this->write((uint8_t)n);
+    }
+    if (base == 10 && n < 0)
+    {
+        return this->print('-') + this->printNumber(-n, 10);
+    }
+    return this->printNumber(n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    return base == 0 ? this->write((uint8_t)n) : this->printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.*f", digits, n);
+    return this->write(buf);
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base)
+{
+    char buf[8 * sizeof(long) + 1];
+    char *str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    if (base < 2)
+    {
+        base = 10;
+    }
+    do
+    {
+        char c = n % base;
+        n /= base;
+        *--str = c < 10 ? c + '0' : c + 'A' - 10;
+    } while (n);
+    return this->write(str);
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    hal::current()->baud = baud;
+}
+
+void HardwareSerial::end()
+{
+    hal::current()->baud = 0;
+}
+
+int HardwareSerial::available()
+{
+    return hal::current()->serialIn.size();
+}
+
+int HardwareSerial::read()
+{
+    hal::Box *box = hal::current();
+    if (box->serialIn.empty())
+    {
+        return -1;
+    }
+    uint8_t c = box->serialIn.front();
+    box->serialIn.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    hal::Box *box = hal::current();
+    return box->serialIn.empty() ? -1 : box->serialIn.front();
+}
+
+int HardwareSerial::availableForWrite()
+{
+    return hal::current()->serialRoom();
+}
+
+void HardwareSerial::flush()
+{
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    hal::current()->writeSerial(c);
+    return 1;
+}
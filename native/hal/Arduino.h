@@ -0,0 +1,136 @@
+/* Arduino core (native HAL)
+ *  - The part of the Arduino AVR core the firmware uses, acting on the box whose code runs (hal::current())
+ *  - int is 32 and long 64 bit wide on the host (16 and 32 bit on the ATmega328); micros() still wraps at 2^32
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Hal.h"
+#include "avr/interrupt.h"
+#include "avr/io.h"
+#include "avr/pgmspace.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define LED_BUILTIN 13
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define __malloc_heap_start (hal::current()->heapStart()) // avr-libc, start of the heap in the box SRAM
+
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return str ? this->write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return this->write((const uint8_t *)buffer, size); }
+
+    size_t print(const __FlashStringHelper *str) { return this->write((const char *)str); }
+    size_t print(const char *str) { return this->write(str); }
+    size_t print(char c) { return this->write((uint8_t)c); }
+    size_t print(unsigned char n, int base = DEC) { return this->print((unsigned long)n, base); }
+    size_t print(int n, int base = DEC) { return this->print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return this->print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    template <typename T>
+    size_t println(T value)
+    {
+        size_t n = this->print(value);
+        return n + this->println();
+    }
+    template <typename T>
+    size_t println(T value, int format)
+    {
+        size_t n = this->print(value, format);
+        return n + this->println();
+    }
+    size_t println() { return this->write("\r\n"); }
+
+private:
+    size_t printNumber(unsigned long n, uint8_t base);
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// hardware serial port of the running box (output goes to hal::Listener::serialLine())
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud);
+    void end();
+    int available() override;
+    int read() override;
+    int peek() override;
+    int availableForWrite();
+    void flush();
+    size_t write(uint8_t c) override;
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif
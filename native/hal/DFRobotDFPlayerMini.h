@@ -0,0 +1,19 @@
+/* DFRobotDFPlayerMini (native HAL)
+ *  - The player always answers, played files go to hal::Listener::audio()
+ */
+
+#ifndef DFRobotDFPlayerMini_cpp
+#define DFRobotDFPlayerMini_cpp
+
+#include "Arduino.h"
+
+class DFRobotDFPlayerMini
+{
+public:
+    bool begin(Stream &stream, bool isACK = true, bool doReset = true);
+    void volume(uint8_t volume);
+    void play(int fileNumber = 1);
+    void playFolder(uint8_t folderNumber, uint8_t fileNumber);
+};
+
+#endif
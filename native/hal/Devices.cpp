@@ -0,0 +1,102 @@
+/* Devices (native HAL)
+ *  - Servo, audio player and EEPROM of the box whose code runs (hal::current())
+ */
+
+#include "DFRobotDFPlayerMini.h"
+#include "EEPROM.h"
+#include "Servo.h"
+
+EEPROMClass EEPROM;
+
+uint8_t Servo::attach(int pin)
+{
+    this->pin = pin;
+    return 0;
+}
+
+uint8_t Servo::attach(int pin, int min, int max)
+{
+    (void)min;
+    (void)max;
+    return this->attach(pin);
+}
+
+void Servo::detach()
+{
+    this->pin = -1;
+}
+
+void Servo::write(int value)
+{
+    this->angle = constrain(value, 0, 180);
+    if (this->pin < 0 || this->pin >= HAL_PINS)
+    {
+        return;
+    }
+    hal::Box *box = hal::current();
+    box->servo[this->pin] = this->angle;
+    if (hal::listener)
+    {
+        hal::listener->servo(box, this->pin, this->angle);
+    }
+}
+
+int Servo::read()
+{
+    return this->angle;
+}
+
+bool Servo::attached()
+{
+    return this->pin >= 0;
+}
+
+bool DFRobotDFPlayerMini::begin(Stream &stream, bool isACK, bool doReset)
+{
+    (void)stream;
+    (void)isACK;
+    (void)doReset;
+    return true;
+}
+
+void DFRobotDFPlayerMini::volume(uint8_t volume)
+{
+    (void)volume;
+}
+
+void DFRobotDFPlayerMini::play(int fileNumber)
+{
+    this->playFolder(0, fileNumber);
+}
+
+void DFRobotDFPlayerMini::playFolder(uint8_t folderNumber, uint8_t fileNumber)
+{
+    if (hal::listener)
+    {
+        hal::listener->audio(hal::current(), folderNumber, fileNumber);
+    }
+}
+
+uint8_t EEPROMClass::read(int idx)
+{
+    return idx >= 0 && idx < HAL_EEPROM_SIZE ? hal::current()->eeprom[idx] : 0xFF;
+}
+
+void EEPROMClass::write(int idx, uint8_t val)
+{
+    if (idx < 0 || idx >= HAL_EEPROM_SIZE)
+    {
+        return;
+    }
+    hal::Box *box = hal::current();
+    box->eeprom[idx] = val;
+    box->spend(HAL_EEPROM_WRITE_MICROS);
+}
+
+void EEPROMClass::update(int idx, uint8_t val)
+{
+    if (this->read(idx) != val)
+    {
+        this->write(idx, val);
+    }
+}
@@ -0,0 +1,44 @@
+/* EEPROM (native HAL)
+ *  - The EEPROM of the running box (hal::Box::eeprom, erased = 0xFF), every byte actually written takes
+ *    HAL_EEPROM_WRITE_MICROS like on the ATmega328
+ */
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include "Arduino.h"
+
+class EEPROMClass
+{
+public:
+    uint8_t read(int idx);
+    void write(int idx, uint8_t val);
+    void update(int idx, uint8_t val);
+    uint16_t length() { return HAL_EEPROM_SIZE; }
+
+    template <typename T>
+    T &get(int idx, T &t)
+    {
+        uint8_t *ptr = (uint8_t *)&t;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            ptr[i] = this->read(idx + i);
+        }
+        return t;
+    }
+
+    template <typename T>
+    const T &put(int idx, const T &t)
+    {
+        const uint8_t *ptr = (const uint8_t *)&t;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            this->update(idx + i, ptr[i]);
+        }
+        return t;
+    }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
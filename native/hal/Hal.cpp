@@ -0,0 +1,370 @@
+/* Native HAL
+ *  - Scheduler: the earliest of the queued events and the next loop() of the running boxes goes next, events first
+ *    when both are due at the same time (an ISR fires before the loop that would see its flag)
+ *  - A pin change sets the AVR flag of its vector, the ISR runs right away unless interrupts are disabled or the
+ *    vector isn't enabled in PCICR (then it runs once they are, like the pending flag on the AVR)
+ */
+
+#include "Hal.h"
+
+#include <map>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "EventFormat.h"
+
+namespace hal
+{
+Listener *listener = NULL;
+Time loopMicros = HAL_LOOP_MICROS;
+
+static Listener silent;
+static Time currentTime = 0;
+static Box *currentBox = NULL;
+static std::multimap<Time, std::function<void()>> events;
+static uint32_t randomState = 1;
+
+Box::Box(const char *name, uint8_t irqPin) : name(name), irqPin(irqPin)
+{
+    memset(this->level, 1, sizeof(this->level)); // pull-ups
+    memset(this->pwm, 0, sizeof(this->pwm));
+    memset(this->servo, -1, sizeof(this->servo));
+    memset(this->analog, -1, sizeof(this->analog));
+    memset(this->eeprom, 0xFF, sizeof(this->eeprom)); // erased
+    memset(this->sram, 0, sizeof(this->sram));
+    memset(this->vectors, 0, sizeof(this->vectors));
+    this->seed = boxes().size() + 1;
+    boxes().push_back(this);
+    currentBox = this;
+}
+
+bool Box::program(void (*setup)(), void (*loop)(), void (*pcint0)(), void (*pcint1)(), void (*pcint2)())
+{
+    this->setupFunction = setup;
+    this->loopFunction = loop;
+    this->vectors[0] = pcint0;
+    this->vectors[1] = pcint1;
+    this->vectors[2] = pcint2;
+    return true;
+}
+
+void Box::start(Time time)
+{
+    this->running = true;
+    this->setupDone = false;
+    this->mcusr = 1; // PORF
+    this->watchdogMicros = 0;
+    this->nextRun = time;
+}
+
+void Box::step()
+{
+    Scope scope(this);
+    this->spent = 0;
+    if (this->setupDone)
+    {
+        memset((uint8_t *)this->stackPointer() - HAL_STACK_LOOP_BYTES, 0, HAL_STACK_LOOP_BYTES);
+        this->loopFunction();
+    }
+    else
+    {
+        this->setupFunction();
+        this->setupDone = true;
+    }
+    this->checkWatchdog();
+    this->nextRun = currentTime + this->spent + loopMicros;
+}
+
+void Box::watchdogEnable(uint8_t timeout)
+{
+    this->watchdogMicros = (Time)HAL_WATCHDOG_MICROS << timeout;
+    this->watchdogKicked = this->time();
+}
+
+void Box::watchdogDisable()
+{
+    this->watchdogMicros = 0;
+}
+
+void Box::watchdogReset()
+{
+    this->checkWatchdog();
+    this->watchdogKicked = this->time();
+}
+
+void Box::checkWatchdog()
+{
+    if (this->watchdogMicros && this->time() - this->watchdogKicked > this->watchdogMicros)
+    {
+        fprintf(stderr, "hal: watchdog of %s fired at %.6f s (%llu micros without wdt_reset())\n", this->name,
+                this->time() / 1e6, (unsigned long long)(this->time() - this->watchdogKicked));
+        abort();
+    }
+}
+
+Time Box::time()
+{
+    return currentTime + this->spent;
+}
+
+uint32_t Box::micros()
+{
+    Time time = this->time();
+    return this->clockOffset + time + (int64_t)time * this->clockPpm / 1000000;
+}
+
+void Box::spend(Time micros)
+{
+    this->spent += micros;
+}
+
+void Box::setPin(uint8_t pin, uint8_t level)
+{
+    level = level ? 1 : 0;
+    if (pin >= HAL_PINS || this->level[pin] == level)
+    {
+        return;
+    }
+    this->level[pin] = level;
+
+    // port D = pins 0-7 (PCINT2), port B = pins 8-13 (PCINT0), port C = A0-A5 (PCINT1), A6/A7 are analog only
+    uint8_t vector = pin < 8 ? 2 : pin < 14 ? 0 : 1;
+    uint8_t bit = pin < 8 ? pin : pin < 14 ? pin - 8 : pin - 14;
+    if (pin < 20 && (this->pcmsk[vector] & 1 << bit))
+    {
+        this->pcifr.value |= 1 << vector;
+        this->dispatch();
+    }
+}
+
+uint8_t Box::port(uint8_t firstPin)
+{
+    uint8_t value = 0;
+    for (uint8_t bit = 0; bit < 8 && firstPin + bit < HAL_PINS; bit++)
+    {
+        value |= this->level[firstPin + bit] << bit;
+    }
+    return value;
+}
+
+void Box::setInterrupts(bool enable)
+{
+    this->interruptsEnabled = enable;
+    this->dispatch();
+}
+
+// run the ISRs of the pending and enabled vectors (ISRs run with interrupts disabled, like on the AVR)
+void Box::dispatch()
+{
+    if (!this->interruptsEnabled || !this->running)
+    {
+        return;
+    }
+    Scope scope(this);
+    for (uint8_t vector = 0; vector < HAL_VECTORS; vector++)
+    {
+        if ((this->pcifr.value & this->pcicr & 1 << vector) && this->vectors[vector])
+        {
+            this->pcifr.value &= ~(1 << vector);
+            this->interruptsEnabled = false;
+            this->vectors[vector]();
+            this->interruptsEnabled = true;
+        }
+    }
+}
+
+// 10 bits per character, print() waits for a free place once HAL_SERIAL_BUFFER characters are queued
+void Box::writeSerial(uint8_t c)
+{
+    if (!this->baud)
+    {
+        return;
+    }
+    Time now = this->time();
+    Time charMicros = 10000000 / this->baud;
+    if (this->serialBusyUntil < now)
+    {
+        this->serialBusyUntil = now;
+    }
+    if (this->serialBusyUntil - now >= HAL_SERIAL_BUFFER * charMicros)
+    {
+        this->spend(this->serialBusyUntil - now - (HAL_SERIAL_BUFFER - 1) * charMicros);
+    }
+    this->serialBusyUntil += charMicros;
+
+    if (this->record.size() || c == EVENT_LOG_SYNC) // never part of a text line
+    {
+        this->record.push_back(c);
+        if (this->record.size() < EVENT_LOG_WIRE_LEN)
+        {
+            return;
+        }
+        EventRecord event;
+        if (!eventParse(this->record.data(), &event))
+        {
+            fprintf(stderr, "hal: %s wrote a corrupt event record\n", this->name);
+            abort();
+        }
+        this->record.clear();
+        (listener ? listener : &silent)->serialLine(this, eventLine(event).c_str());
+    }
+    else if (c == '\n')
+    {
+        (listener ? listener : &silent)->serialLine(this, this->line.c_str());
+        this->line.clear();
+    }
+    else if (c != '\r')
+    {
+        this->line += (char)c;
+    }
+}
+
+int Box::serialRoom()
+{
+    if (!this->baud)
+    {
+        return HAL_SERIAL_BUFFER - 1;
+    }
+    Time now = this->time();
+    Time charMicros = 10000000 / this->baud;
+    Time queued = this->serialBusyUntil > now ? (this->serialBusyUntil - now + charMicros - 1) / charMicros : 0;
+    return queued < HAL_SERIAL_BUFFER - 1 ? HAL_SERIAL_BUFFER - 1 - queued : 0;
+}
+
+void Box::serialInput(const char *text)
+{
+    while (*text)
+    {
+        this->serialIn.push_back(*text++);
+    }
+}
+
+// xorshift32, one sequence per box (analogRead() noise)
+uint32_t Box::random()
+{
+    this->seed ^= this->seed << 13;
+    this->seed ^= this->seed >> 17;
+    this->seed ^= this->seed << 5;
+    return this->seed;
+}
+
+Scope::Scope(Box *box) : box(box), previous(currentBox), spent(box->spent)
+{
+    if (this->previous != box)
+    {
+        box->spent = 0; // ISR or radio event: the box clock is the event time
+    }
+    currentBox = box;
+}
+
+Scope::~Scope()
+{
+    if (this->previous != this->box)
+    {
+        this->box->spent = this->spent;
+    }
+    currentBox = this->previous;
+}
+
+Time now()
+{
+    return currentTime;
+}
+
+void at(Time time, std::function<void()> action)
+{
+    events.insert(std::make_pair(time < currentTime ? currentTime : time, action));
+}
+
+void run(Time until)
+{
+    while (true)
+    {
+        Box *next = NULL;
+        for (Box *box : boxes())
+        {
+            if (box->running && (!next || box->nextRun < next->nextRun))
+            {
+                next = box;
+            }
+        }
+        bool event = !events.empty() && (!next || events.begin()->first <= next->nextRun);
+        Time time = event ? events.begin()->first : next ? next->nextRun : until;
+        if (time > until)
+        {
+            currentTime = until;
+            return;
+        }
+        currentTime = time;
+        if (event)
+        {
+            std::function<void()> action = events.begin()->second;
+            events.erase(events.begin());
+            action();
+        }
+        else
+        {
+            next->step();
+        }
+    }
+}
+
+Box *current()
+{
+    if (!currentBox)
+    {
+        fprintf(stderr, "hal: firmware code called outside of a box\n");
+        abort();
+    }
+    return currentBox;
+}
+
+Box *find(const char *name)
+{
+    for (Box *box : boxes())
+    {
+        if (!strcmp(box->name, name))
+        {
+            return box;
+        }
+    }
+    return NULL;
+}
+
+std::vector<Box *> &boxes()
+{
+    static std::vector<Box *> list; // constructed on first use, boxes register from static constructors
+    return list;
+}
+
+void seed(uint32_t seed)
+{
+    randomState = seed ? seed : 1;
+    for (Box *box : boxes())
+    {
+        box->seed = seed * 2654435761u + box->seed;
+        box->seed = box->seed ? box->seed : 1;
+    }
+}
+
+uint32_t random()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+bool chance(double probability)
+{
+    return random() < probability * 4294967296.0;
+}
+
+Time exponential(double meanMicros)
+{
+    double uniform = (random() + 1.0) / 4294967297.0;
+    return (Time)(-meanMicros * log(uniform));
+}
+} // namespace hal
@@ -0,0 +1,222 @@
+/* Native HAL
+ *  - Runs the unmodified firmware on the host (PlatformIO env:native): every box is a unity build of src/ in its own
+ *    namespace (native/box_*.cpp), the Arduino core and the libraries in this directory act on the box whose code runs
+ *  - Virtual clock: one global time in micros, each box reads it through its own clock offset and drift; loop() is
+ *    called every hal::loopMicros, time spent in blocking calls (delay(), full serial buffer, EEPROM writes) comes on top
+ *  - Events (radio packets, lever and remote inputs) run in time order between two loop() calls of the boxes, so
+ *    virtual time runs as fast as the host executes the loops
+ *  - Virtual pins with the AVR pin-change interrupts (PCINT0-2), PWM, servos, audio player and EEPROM per box
+ *  - Watchdog per box: a loop() or setup() that would let it fire aborts the session (a reset can't be simulated,
+ *    the firmware's globals would keep their values), MCUSR always reads a power-on reset
+ *  - SRAM model per box for the stack monitor: SP and __malloc_heap_start point into it, every loop() writes
+ *    HAL_STACK_LOOP_BYTES below SP like a real call chain would
+ *  - Serial output reaches the session driver line by line, binary event records (EVENT_LOG_ENABLED) as the text line
+ *    they stand for
+ *  - In-process radio medium (RF24.cpp): air time, auto-ACK with retries, ACK payloads, collisions and a channel model
+ *    (hal::channel) with packet loss, loss bursts, ACK loss, latency and radio-off periods
+ */
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+class RF24;
+
+#define HAL_PINS 22               // D0-D13, A0-A7
+#define HAL_VECTORS 3             // pin-change interrupt vectors PCINT0 (port B), PCINT1 (port C), PCINT2 (port D)
+#define HAL_LOOP_MICROS 250       // Duration of one loop() without blocking calls (ATmega328 at 16 MHz), default of hal::loopMicros
+#define HAL_SPI_MICROS 12         // Duration of one radio command over SPI
+#define HAL_SERIAL_BUFFER 64      // HardwareSerial TX buffer, print() blocks once it is full
+#define HAL_EEPROM_SIZE 1024      // ATmega328
+#define HAL_EEPROM_WRITE_MICROS 3300 // Duration of one EEPROM byte write
+#define HAL_WATCHDOG_MICROS 16000 // Shortest watchdog timeout (WDTO_15MS, doubled per step), nominal
+#define HAL_SRAM_BYTES 2048       // ATmega328
+#define HAL_SRAM_STATIC 1024      // .data and .bss in front of the heap (the real ones live in host memory)
+#define HAL_STACK_MAIN_BYTES 16   // Stack below the top of SRAM when setup() and loop() start
+#define HAL_STACK_LOOP_BYTES 160  // Stack every loop() writes below its start (the host stack isn't in the box SRAM)
+
+namespace hal
+{
+typedef uint64_t Time; // virtual micros since the start of the simulation
+
+class Box;
+
+// outputs of the boxes, implemented by the environment (session driver)
+class Listener
+{
+public:
+    virtual ~Listener() {}
+    virtual void serialLine(Box *, const char *) {}
+    virtual void audio(Box *, uint8_t, uint8_t) {}
+    virtual void pwm(Box *, uint8_t, int) {}
+    virtual void servo(Box *, uint8_t, int) {}
+};
+
+// AVR interrupt flag register: writing a 1 clears the flag
+struct FlagRegister
+{
+    uint8_t value = 0;
+    FlagRegister &operator=(uint8_t bits)
+    {
+        this->value &= ~bits;
+        return *this;
+    }
+    operator uint8_t() const { return this->value; }
+};
+
+class Box
+{
+public:
+    Box(const char *name, uint8_t irqPin); // makes the box current, the firmware's global objects are constructed next
+    bool program(void (*setup)(), void (*loop)(), void (*pcint0)(), void (*pcint1)(), void (*pcint2)());
+
+    // environment
+    void start(Time time);                   // power on: setup() at time, loop() from then on
+    void setPin(uint8_t pin, uint8_t level); // drive an input (lever, remote), fires pin-change interrupts
+    void serialInput(const char *text);      // characters for Serial.read()
+    const char *name;
+    uint8_t irqPin;             // pin the radio IRQ line is wired to
+    int32_t clockPpm = 0;       // drift of the box clock
+    uint32_t clockOffset = 0;   // box clock at time 0
+    bool radioMuted = false;    // radio neither sends nor receives (out of range, switched off)
+    bool radioScripted = false; // radio in scripted mode from RF24::begin() on (replay of a trace)
+    bool running = false;
+    uint8_t level[HAL_PINS];    // pin levels (inputs are pulled up)
+    int16_t pwm[HAL_PINS];      // analogWrite() values
+    int16_t servo[HAL_PINS];    // last servo angle written, -1 = never
+    int16_t analog[HAL_PINS];   // analogRead() values, -1 = noise (unconnected)
+    uint8_t eeprom[HAL_EEPROM_SIZE];
+    uint8_t sram[HAL_SRAM_BYTES];
+
+    // fake core and libraries
+    Time time();                    // now() plus the time spent in the running setup()/loop()
+    uint32_t micros();              // box clock
+    void spend(Time micros);        // blocking call in the running setup()/loop()
+    uint8_t port(uint8_t firstPin); // PINB, PINC, PIND
+    void setInterrupts(bool enable);
+    void writeSerial(uint8_t c);
+    int serialRoom(); // free places in the serial TX buffer
+    void watchdogEnable(uint8_t timeout);
+    void watchdogDisable();
+    void watchdogReset();
+    uintptr_t stackPointer() { return (uintptr_t)(this->sram + HAL_SRAM_BYTES - HAL_STACK_MAIN_BYTES); }
+    char *heapStart() { return (char *)this->sram + HAL_SRAM_STATIC; }
+    uint32_t random();
+    uint8_t pcicr = 0;
+    FlagRegister pcifr;
+    uint8_t pcmsk[HAL_VECTORS] = {0, 0, 0};
+    uint32_t baud = 0;
+    uint8_t mcusr = 1; // PORF
+    std::deque<uint8_t> serialIn;
+    uint32_t seed;
+    uint32_t randomContext = 1; // random() of avr-libc, same sequence as on the Nano after the same randomSeed()
+    RF24 *radio = NULL;         // set by RF24::begin()
+
+private:
+    friend void run(Time until);
+    friend class Scope;
+    void step(); // setup() or one loop()
+    void checkWatchdog();
+    void dispatch();
+
+    void (*setupFunction)() = NULL;
+    void (*loopFunction)() = NULL;
+    void (*vectors[HAL_VECTORS])();
+    bool setupDone = false;
+    bool interruptsEnabled = true;
+    Time spent = 0;
+    Time nextRun = 0;
+    Time serialBusyUntil = 0; // last character queued leaves the serial TX buffer
+    Time watchdogMicros = 0;  // timeout, 0 = off
+    Time watchdogKicked = 0;
+    std::string line;
+    std::vector<uint8_t> record; // binary event record being written (include/EventLog.h)
+};
+
+// makes box current (ISR, radio event) for its lifetime, unless its code already runs
+class Scope
+{
+public:
+    Scope(Box *box);
+    ~Scope();
+
+private:
+    Box *box;
+    Box *previous;
+    Time spent;
+};
+
+Time now();
+void at(Time time, std::function<void()> action); // event (radio, environment), runs between two loop() calls
+void run(Time until);
+Box *current(); // box whose code runs (setup(), loop(), ISR, radio event)
+Box *find(const char *name);
+std::vector<Box *> &boxes();
+void seed(uint32_t seed);
+uint32_t random(); // environment and radio medium
+bool chance(double probability);
+Time exponential(double meanMicros); // exponentially distributed wait with the given mean
+
+// channel between every two radios, drawn separately for every receiver of a frame and for its ACK
+//  - loss: independent loss of a packet, burst: Gilbert-Elliott model, the link enters a bad state with this
+//    probability per packet, leaves it after burstLength packets on average and loses burstLoss of them meanwhile
+//  - ackLoss on top of the loss: the receiver got the frame, the sender retransmits it (a duplicate)
+//  - latency: RX_DR at the receiver this long after the end of the frame, plus an exponential jitter with the mean
+//    jitterMicros (later frames can overtake earlier ones), the ACK itself isn't delayed
+//  - radio-off periods of every box: offMicros long, exponential gaps with the mean offEveryMicros (0 = never)
+struct Channel
+{
+    double loss = 0;
+    double burst = 0;
+    double burstLength = 10;
+    double burstLoss = 1;
+    double ackLoss = 0;
+    Time latencyMicros = 0;
+    double jitterMicros = 0;
+    double offEveryMicros = 0;
+    Time offMicros = 0;
+};
+
+// traffic of the radio medium
+struct RadioStats
+{
+    uint32_t packets = 0;    // frames put on air (every retransmission counts)
+    uint32_t acks = 0;       // ACKs put on air
+    Time airMicros = 0;      // frames and ACKs
+    uint32_t collisions = 0; // receptions lost to an overlapping packet
+    uint32_t lost = 0;       // frames lost to the channel (loss, bursts)
+    uint32_t acksLost = 0;   // ACKs lost to the channel (loss, bursts, ackLoss)
+    uint32_t bursts = 0;     // bad states entered
+    uint32_t duplicates = 0; // retransmissions of a frame already received, dropped by the receiver
+    uint32_t reordered = 0;  // frames that reached RX_DR before an earlier frame of the same link
+    uint32_t offPeriods = 0; // radio-off periods started
+};
+
+// session settings of settings.h the boxes read at runtime (native/box_settings.h), defaults from settings.h
+struct Settings
+{
+    double synchMicros;
+    double itiMicros;
+    double longTimeoutMicros;
+    uint8_t synchPullMax;
+    uint8_t modeTestCount[3];
+    bool trace;
+    bool events;
+};
+
+bool loadSettings(); // from the HAL_SETTINGS environment variable, before the firmware's global objects are constructed
+
+extern Listener *listener;
+extern Time loopMicros;   // a coarser loop runs long sessions faster (lever edges and radio events keep their times)
+extern Channel channel;
+extern RadioStats radioStats;
+extern Settings settings;
+} // namespace hal
+
+#endif
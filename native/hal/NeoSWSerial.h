@@ -0,0 +1,25 @@
+/* NeoSWSerial (native HAL)
+ *  - Only carries the audio player commands, which DFRobotDFPlayerMini hands to the environment directly
+ */
+
+#ifndef NeoSWSerial_h
+#define NeoSWSerial_h
+
+#include "Arduino.h"
+
+class NeoSWSerial : public Stream
+{
+public:
+    NeoSWSerial(uint8_t, uint8_t) {}
+    void begin(uint16_t = 9600) {}
+    void listen() {}
+    void ignore() {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t) override { return 1; }
+    using Print::write;
+    static void rxISR(uint8_t) {}
+};
+
+#endif
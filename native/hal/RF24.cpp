@@ -0,0 +1,819 @@
+/* RF24 (native HAL)
+ *  - Radio medium: all radios that called begin(), the packets of the last few milliseconds on air
+ *  - A packet is received by every listening radio on the same channel with a matching open pipe, unless it overlaps
+ *    another packet on that channel (collision, both are lost), the receiver was transmitting itself, one of the radios
+ *    is off or the channel loses it (hal::channel, a Gilbert-Elliott state per direction of every pair of radios)
+ *  - Several receivers ACKing the same packet collide, the sender retransmits as if no ACK came back
+ *  - Retransmissions start (retry delay + 1) * 250 micros after the end of the previous one, MAX_RT is raised one retry
+ *    delay after the last one
+ *  - Channel latency holds a received frame back from the RX FIFO (it takes its FIFO level right away)
+ */
+
+#include "RF24.h"
+
+#include <map>
+
+#define RF24_RX_DR 0x40
+#define RF24_TX_DS 0x20
+#define RF24_MAX_RT 0x10
+
+namespace hal
+{
+Channel channel;
+RadioStats radioStats;
+}
+
+struct Air
+{
+    hal::Time start;
+    hal::Time end;
+    uint8_t channel;
+    const RF24 *sender;
+};
+
+static std::vector<RF24 *> radios;
+static std::vector<Air> onAir;
+static std::map<std::pair<const RF24 *, const RF24 *>, bool> badLinks; // Gilbert-Elliott state from sender to receiver
+
+// stands in for the packet CRC in the duplicate detection
+static uint16_t checksum(const uint8_t *data, uint8_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < len; i++)
+    {
+        crc = (crc << 5 | crc >> 11) ^ data[i];
+    }
+    return crc;
+}
+
+// packet from one radio to another lost by the channel (the burst state only moves when bursts are configured, so
+// the draws of a channel without them stay the same)
+static bool lostOnAir(const RF24 *from, const RF24 *to)
+{
+    bool &bad = badLinks[std::make_pair(from, to)];
+    if (hal::channel.burst > 0)
+    {
+        bool wasBad = bad;
+        bad = bad ? !hal::chance(1 / hal::channel.burstLength) : hal::chance(hal::channel.burst);
+        hal::radioStats.bursts += bad && !wasBad;
+    }
+    return hal::chance(bad ? hal::channel.burstLoss : hal::channel.loss);
+}
+
+// radio-off periods of a box, one after the other
+static void switchOffLater(hal::Box *box)
+{
+    hal::at(hal::now() + hal::exponential(hal::channel.offEveryMicros), [box]() {
+        box->radioMuted = true;
+        hal::radioStats.offPeriods++;
+        hal::at(hal::now() + hal::channel.offMicros, [box]() {
+            box->radioMuted = false;
+            switchOffLater(box);
+        });
+    });
+}
+
+RF24::RF24(uint16_t cePin, uint16_t csnPin)
+{
+    (void)cePin;
+    (void)csnPin;
+    memset(this->pipes, 0, sizeof(this->pipes));
+    memset(this->pipe0Reading, 0, sizeof(this->pipe0Reading));
+    memset(this->txAddress, 0, sizeof(this->txAddress));
+    memset(this->lastPid, 0xFF, sizeof(this->lastPid));
+    memset(this->lastCrc, 0, sizeof(this->lastCrc));
+}
+
+// registers the radio of the running box with the medium, same defaults as RF24::begin() on the chip
+bool RF24::begin()
+{
+    this->box = hal::current();
+    bool known = false;
+    for (RF24 *radio : radios)
+    {
+        known |= radio == this;
+    }
+    if (!known)
+    {
+        radios.push_back(this);
+        if (hal::channel.offEveryMicros > 0)
+        {
+            switchOffLater(this->box);
+        }
+    }
+    this->box->radio = this;
+    this->scripted = this->box->radioScripted;
+    this->command();
+    this->channel = 76;
+    this->listening = false;
+    this->pipesOpen = 0x03;
+    this->pipe0ReadingOpen = false;
+    this->dynamicPayloads = false;
+    this->ackPayloads = false;
+    this->dynamicAck = false;
+    this->autoAck = 0x3F;
+    this->dataRate = RF24_1MBPS;
+    this->paLevel = RF24_PA_MAX;
+    this->retryDelay = 5;
+    this->retryCount = 15;
+    this->generation++;
+    this->transmitting = false;
+    this->txFifo.clear();
+    this->rxFifo.clear();
+    this->status = 0;
+    this->updateIrq();
+    return true;
+}
+
+bool RF24::isChipConnected()
+{
+    this->command();
+    return true;
+}
+
+void RF24::startListening()
+{
+    this->command();
+    if (this->transmitting) // CE low ends the transmission
+    {
+        this->generation++;
+        this->transmitting = false;
+    }
+    this->listening = true;
+    this->rxReadyTime = this->box->time() + HAL_RADIO_SETTLE_MICROS;
+    if (this->pipe0ReadingOpen)
+    {
+        memcpy(this->pipes[0], this->pipe0Reading, 5);
+        this->pipesOpen |= 0x01;
+    }
+    else
+    {
+        this->pipesOpen &= ~0x01;
+    }
+    if (this->ackPayloads)
+    {
+        this->flush_tx();
+    }
+}
+
+void RF24::stopListening()
+{
+    this->command();
+    this->listening = false;
+    if (this->ackPayloads)
+    {
+        this->flush_tx();
+    }
+    this->pipesOpen |= 0x01; // pipe 0 receives the ACKs
+}
+
+bool RF24::available()
+{
+    return this->available(NULL);
+}
+
+bool RF24::available(uint8_t *pipe)
+{
+    this->command();
+    if (this->rxFifo.empty())
+    {
+        return false;
+    }
+    if (pipe)
+    {
+        *pipe = this->rxFifo.front().pipe;
+    }
+    return true;
+}
+
+void RF24::read(void *buf, uint8_t len)
+{
+    this->command();
+    memset(buf, 0, len);
+    if (!this->rxFifo.empty())
+    {
+        memcpy(buf, this->rxFifo.front().data, min(len, (uint8_t)32));
+        this->rxFifo.pop_front();
+    }
+    this->status &= ~RF24_RX_DR;
+    this->updateIrq();
+}
+
+void RF24::startWrite(const void *buf, uint8_t len, const bool multicast)
+{
+    this->command();
+    if (this->txFifo.size() >= HAL_RADIO_FIFO)
+    {
+        return;
+    }
+    Payload payload;
+    memset(payload.data, 0, sizeof(payload.data));
+    memcpy(payload.data, buf, min(len, (uint8_t)32));
+    payload.len = this->dynamicPayloads ? min(len, (uint8_t)32) : this->payloadSize;
+    payload.pipe = 0;
+    payload.ackPayload = false;
+    payload.noAck = multicast && this->dynamicAck;
+    this->txFifo.push_back(payload);
+
+    if (!this->listening && !this->transmitting)
+    {
+        this->pid = (this->pid + 1) & 3;
+        this->attempt = 0;
+        this->transmit(this->box->time());
+    }
+}
+
+bool RF24::writeAckPayload(uint8_t pipe, const void *buf, uint8_t len)
+{
+    this->command();
+    if (this->txFifo.size() >= HAL_RADIO_FIFO)
+    {
+        return false;
+    }
+    Payload payload;
+    memset(payload.data, 0, sizeof(payload.data));
+    memcpy(payload.data, buf, min(len, (uint8_t)32));
+    payload.len = min(len, (uint8_t)32);
+    payload.pipe = pipe;
+    payload.ackPayload = true;
+    payload.noAck = false;
+    this->txFifo.push_back(payload);
+    return true;
+}
+
+void RF24::whatHappened(bool &tx_ok, bool &tx_fail, bool &rx_ready)
+{
+    this->command();
+    tx_ok = this->status & RF24_TX_DS;
+    tx_fail = this->status & RF24_MAX_RT;
+    rx_ready = this->status & RF24_RX_DR;
+    this->status = 0;
+    this->updateIrq();
+}
+
+void RF24::maskIRQ(bool tx_ok, bool tx_fail, bool rx_ready)
+{
+    this->command();
+    this->irqMask = (tx_ok ? RF24_TX_DS : 0) | (tx_fail ? RF24_MAX_RT : 0) | (rx_ready ? RF24_RX_DR : 0);
+    this->updateIrq();
+}
+
+uint8_t RF24::flush_tx()
+{
+    this->command();
+    this->txFifo.clear();
+    if (this->transmitting)
+    {
+        this->generation++;
+        this->transmitting = false;
+    }
+    return this->status;
+}
+
+uint8_t RF24::flush_rx()
+{
+    this->command();
+    this->rxFifo.clear();
+    return this->status;
+}
+
+bool RF24::isFifo(bool about_tx, bool check_empty)
+{
+    this->command();
+    std::deque<Payload> &fifo = about_tx ? this->txFifo : this->rxFifo;
+    return check_empty ? fifo.empty() : fifo.size() >= HAL_RADIO_FIFO;
+}
+
+// carrier on the channel right now (another radio on air within the last 40 micros)
+bool RF24::testRPD()
+{
+    this->command();
+    hal::Time now = this->box->time();
+    for (const Air &air : onAir)
+    {
+        if (air.sender != this && air.channel == this->channel && air.start <= now && air.end + 40 >= now)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void RF24::setChannel(uint8_t channel)
+{
+    this->command();
+    this->channel = min(channel, (uint8_t)125);
+    if (this->listening)
+    {
+        this->rxReadyTime = this->box->time() + HAL_RADIO_SETTLE_MICROS;
+    }
+}
+
+uint8_t RF24::getChannel()
+{
+    this->command();
+    return this->channel;
+}
+
+void RF24::setPayloadSize(uint8_t size)
+{
+    this->command();
+    this->payloadSize = constrain(size, 1, 32);
+}
+
+uint8_t RF24::getPayloadSize()
+{
+    return this->payloadSize;
+}
+
+uint8_t RF24::getDynamicPayloadSize()
+{
+    this->command();
+    return this->rxFifo.empty() ? 0 : this->rxFifo.front().len;
+}
+
+void RF24::enableAckPayload()
+{
+    this->command();
+    this->ackPayloads = true;
+    this->dynamicPayloads = true;
+}
+
+void RF24::disableAckPayload()
+{
+    this->command();
+    this->ackPayloads = false;
+}
+
+void RF24::enableDynamicPayloads()
+{
+    this->command();
+    this->dynamicPayloads = true;
+}
+
+void RF24::disableDynamicPayloads()
+{
+    this->command();
+    this->dynamicPayloads = false;
+    this->ackPayloads = false;
+}
+
+void RF24::enableDynamicAck()
+{
+    this->command();
+    this->dynamicAck = true;
+}
+
+void RF24::setAutoAck(bool enable)
+{
+    this->command();
+    this->autoAck = enable ? 0x3F : 0;
+}
+
+void RF24::setAutoAck(uint8_t pipe, bool enable)
+{
+    this->command();
+    if (pipe < 6)
+    {
+        this->autoAck = enable ? this->autoAck | 1 << pipe : this->autoAck & ~(1 << pipe);
+    }
+}
+
+void RF24::setPALevel(uint8_t level, bool lnaEnable)
+{
+    (void)lnaEnable;
+    this->command();
+    this->paLevel = min(level, (uint8_t)RF24_PA_MAX);
+}
+
+uint8_t RF24::getPALevel()
+{
+    this->command();
+    return this->paLevel;
+}
+
+bool RF24::setDataRate(rf24_datarate_e speed)
+{
+    this->command();
+    this->dataRate = speed;
+    return true;
+}
+
+rf24_datarate_e RF24::getDataRate()
+{
+    this->command();
+    return this->dataRate;
+}
+
+void RF24::setRetries(uint8_t delay, uint8_t count)
+{
+    this->command();
+    this->retryDelay = min(delay, (uint8_t)15);
+    this->retryCount = min(count, (uint8_t)15);
+}
+
+uint8_t RF24::getARC()
+{
+    this->command();
+    return this->arc;
+}
+
+void RF24::setCRCLength(rf24_crclength_e length)
+{
+    (void)length;
+    this->command();
+}
+
+void RF24::disableCRC()
+{
+    this->command();
+}
+
+void RF24::openWritingPipe(const uint8_t *address)
+{
+    this->command();
+    memcpy(this->txAddress, address, 5);
+    memcpy(this->pipes[0], address, 5); // the ACKs come back on pipe 0
+}
+
+// pipes 2-5 only have their own first byte, the other four are those of pipe 1
+void RF24::openReadingPipe(uint8_t pipe, const uint8_t *address)
+{
+    this->command();
+    if (pipe >= 6)
+    {
+        return;
+    }
+    if (pipe == 0)
+    {
+        memcpy(this->pipe0Reading, address, 5);
+        this->pipe0ReadingOpen = true;
+    }
+    memcpy(this->pipes[pipe], address, pipe < 2 ? 5 : 1);
+    this->pipesOpen |= 1 << pipe;
+}
+
+void RF24::closeReadingPipe(uint8_t pipe)
+{
+    this->command();
+    if (pipe == 0)
+    {
+        this->pipe0ReadingOpen = false;
+    }
+    if (pipe < 6)
+    {
+        this->pipesOpen &= ~(1 << pipe);
+    }
+}
+
+// SPI transaction of the running loop
+void RF24::command()
+{
+    if (this->box)
+    {
+        this->box->spend(HAL_SPI_MICROS);
+    }
+}
+
+// IRQ pin is active low while an unmasked status flag is set
+void RF24::updateIrq()
+{
+    if (this->box)
+    {
+        this->box->setPin(this->box->irqPin, !(this->status & ~this->irqMask & (RF24_RX_DR | RF24_TX_DS | RF24_MAX_RT)));
+    }
+}
+
+// TX settling, preamble, address, packet control field, payload and CRC
+hal::Time RF24::airMicros(uint8_t len)
+{
+    uint32_t bits = 8 + 40 + 9 + 8 * len + 16;
+    uint32_t bitsPerMilli = this->dataRate == RF24_250KBPS ? 250 : this->dataRate == RF24_1MBPS ? 1000 : 2000;
+    return HAL_RADIO_SETTLE_MICROS + (bits * 1000 + bitsPerMilli - 1) / bitsPerMilli;
+}
+
+// put the first TX FIFO payload (ACK payloads wait for their packet) on air
+void RF24::transmit(hal::Time start)
+{
+    const Payload *payload = NULL;
+    for (const Payload &entry : this->txFifo)
+    {
+        if (!entry.ackPayload)
+        {
+            payload = &entry;
+            break;
+        }
+    }
+    if (!payload)
+    {
+        this->transmitting = false;
+        return;
+    }
+
+    size_t kept = 0; // forget packets that can't overlap anything anymore
+    for (const Air &air : onAir)
+    {
+        if (air.end + 100000 > start)
+        {
+            onAir[kept++] = air;
+        }
+    }
+    onAir.resize(kept);
+
+    hal::Time end = start + this->airMicros(payload->len);
+    onAir.push_back({start, end, this->channel, this});
+    hal::radioStats.packets++;
+    hal::radioStats.airMicros += end - start;
+    this->busyUntil = end;
+    this->transmitting = true;
+    uint32_t generation = this->generation;
+    if (this->scripted)
+    {
+        hal::at(end, [this, generation]() {
+            if (generation == this->generation && !this->outcomes.empty())
+            {
+                this->completed();
+            }
+        });
+        return;
+    }
+    hal::at(end, [this, generation, start, end]() {
+        if (generation == this->generation)
+        {
+            this->transmitted(start, end);
+        }
+    });
+}
+
+void RF24::transmitted(hal::Time start, hal::Time end)
+{
+    std::deque<Payload>::iterator payload = this->txFifo.begin();
+    while (payload != this->txFifo.end() && payload->ackPayload)
+    {
+        payload++;
+    }
+    if (payload == this->txFifo.end())
+    {
+        this->transmitting = false;
+        return;
+    }
+
+    std::vector<RF24 *> ackers;
+    std::vector<uint8_t> ackPipes;
+    for (RF24 *radio : radios)
+    {
+        uint8_t pipe;
+        if (radio == this || !radio->receives(this, start, end, &pipe))
+        {
+            continue;
+        }
+        if (lostOnAir(this, radio))
+        {
+            hal::radioStats.lost++;
+            continue;
+        }
+        if (radio->deliver(pipe, *payload, this->pid) && !payload->noAck && (radio->autoAck & 1 << pipe))
+        {
+            ackers.push_back(radio);
+            ackPipes.push_back(pipe);
+        }
+    }
+
+    if (payload->noAck)
+    {
+        this->txFifo.erase(payload);
+        this->arc = 0;
+        this->transmitting = false;
+        this->status |= RF24_TX_DS;
+        this->updateIrq();
+        return;
+    }
+
+    uint32_t generation = this->generation;
+    bool ackReceived = false;
+    Payload ack;
+    bool ackHasPayload = false;
+    hal::Time ackEnd = end;
+    for (size_t i = 0; i < ackers.size(); i++)
+    {
+        ackHasPayload = ackers[i]->takeAckPayload(ackPipes[i], &ack);
+        ackEnd = end + ackers[i]->airMicros(ackHasPayload ? ack.len : 0);
+        onAir.push_back({end, ackEnd, this->channel, ackers[i]});
+        ackers[i]->busyUntil = ackEnd;
+        hal::radioStats.acks++;
+        hal::radioStats.airMicros += ackEnd - end;
+    }
+    if (ackers.size() == 1) // several ACKs collide
+    {
+        ackReceived = !lostOnAir(ackers[0], this) && !(hal::channel.ackLoss > 0 && hal::chance(hal::channel.ackLoss));
+        hal::radioStats.acksLost += !ackReceived;
+    }
+    if (ackReceived)
+    {
+        hal::at(ackEnd, [this, generation, ack, ackHasPayload]() {
+            if (generation == this->generation)
+            {
+                this->acked(ackHasPayload ? &ack : NULL);
+            }
+        });
+        return;
+    }
+
+    hal::Time retry = end + 250 * (this->retryDelay + 1);
+    if (this->attempt < this->retryCount)
+    {
+        this->attempt++;
+        hal::at(retry, [this, generation]() {
+            if (generation == this->generation)
+            {
+                this->transmit(hal::now());
+            }
+        });
+    }
+    else
+    {
+        hal::at(retry, [this, generation]() {
+            if (generation == this->generation)
+            {
+                this->arc = this->retryCount;
+                this->transmitting = false;
+                this->status |= RF24_MAX_RT; // payload stays in the TX FIFO
+                this->updateIrq();
+            }
+        });
+    }
+}
+
+void RF24::acked(const Payload *ack)
+{
+    for (std::deque<Payload>::iterator payload = this->txFifo.begin(); payload != this->txFifo.end(); payload++)
+    {
+        if (!payload->ackPayload)
+        {
+            this->txFifo.erase(payload);
+            break;
+        }
+    }
+    this->arc = this->attempt;
+    this->transmitting = false;
+    this->status |= RF24_TX_DS;
+    if (ack && this->rxFifo.size() < HAL_RADIO_FIFO)
+    {
+        this->rxFifo.push_back(*ack);
+        this->rxFifo.back().pipe = 0;
+        this->status |= RF24_RX_DR;
+    }
+    this->updateIrq();
+}
+
+void RF24::inject(uint8_t pipe, const void *buf, uint8_t len)
+{
+    Payload payload;
+    memset(payload.data, 0, sizeof(payload.data));
+    memcpy(payload.data, buf, min(len, (uint8_t)32));
+    payload.len = min(len, (uint8_t)32);
+    if (this->rxFifo.size() < HAL_RADIO_FIFO)
+    {
+        this->rxFifo.push_back(payload);
+        this->rxFifo.back().pipe = pipe;
+    }
+    Payload ack;
+    this->takeAckPayload(pipe, &ack);
+    this->status |= RF24_RX_DR;
+    this->updateIrq();
+}
+
+void RF24::complete(bool delivered, uint8_t arc, const void *ack, uint8_t ackLen)
+{
+    Outcome outcome;
+    outcome.delivered = delivered;
+    outcome.arc = arc;
+    outcome.hasAck = ack != NULL;
+    memset(outcome.ack.data, 0, sizeof(outcome.ack.data));
+    if (ack)
+    {
+        memcpy(outcome.ack.data, ack, min(ackLen, (uint8_t)32));
+        outcome.ack.len = min(ackLen, (uint8_t)32);
+    }
+    this->outcomes.push_back(outcome);
+    if (this->transmitting)
+    {
+        this->completed();
+    }
+}
+
+// scripted: the first outcome ends the attempt on air
+void RF24::completed()
+{
+    Outcome outcome = this->outcomes.front();
+    this->outcomes.pop_front();
+    this->generation++;
+    if (outcome.delivered)
+    {
+        this->acked(outcome.hasAck ? &outcome.ack : NULL);
+        this->arc = outcome.arc;
+        return;
+    }
+    this->arc = this->retryCount;
+    this->transmitting = false;
+    this->status |= RF24_MAX_RT; // payload stays in the TX FIFO
+    this->updateIrq();
+}
+
+bool RF24::receives(const RF24 *sender, hal::Time start, hal::Time end, uint8_t *pipe)
+{
+    if (!this->box || !this->box->running || this->box->radioMuted || sender->box->radioMuted)
+    {
+        return false;
+    }
+    if (!this->listening || this->channel != sender->channel || this->rxReadyTime > start || this->busyUntil > start)
+    {
+        return false;
+    }
+    bool addressed = false;
+    for (uint8_t p = 0; p < 6 && !addressed; p++)
+    {
+        addressed = (this->pipesOpen & 1 << p) &&
+                    (p < 2 ? !memcmp(this->pipes[p], sender->txAddress, 5)
+                           : this->pipes[p][0] == sender->txAddress[0] && !memcmp(&this->pipes[1][1], &sender->txAddress[1], 4));
+        *pipe = p;
+    }
+    if (!addressed)
+    {
+        return false;
+    }
+    for (const Air &air : onAir)
+    {
+        if (air.sender != sender && !air.sender->box->radioMuted && air.channel == sender->channel && air.start < end &&
+            air.end > start) // a muted radio isn't on the air
+        {
+            hal::radioStats.collisions++;
+            return false;
+        }
+    }
+    return true;
+}
+
+// store a received packet (after the channel latency), false if the RX FIFO is full (the packet isn't ACKed then)
+bool RF24::deliver(uint8_t pipe, const Payload &payload, uint8_t pid)
+{
+    uint16_t crc = checksum(payload.data, payload.len);
+    if (this->lastPid[pipe] == pid && this->lastCrc[pipe] == crc)
+    {
+        hal::radioStats.duplicates++;
+        return true; // retransmission of a packet already received (its ACK was lost)
+    }
+    if (this->rxFifo.size() + this->rxPending >= HAL_RADIO_FIFO)
+    {
+        return false;
+    }
+    this->lastPid[pipe] = pid;
+    this->lastCrc[pipe] = crc;
+    Payload received = payload;
+    received.pipe = pipe;
+    if (!this->dynamicPayloads)
+    {
+        received.len = this->payloadSize;
+    }
+    uint32_t sequence = ++this->rxSequence;
+    hal::Time latency = hal::channel.latencyMicros;
+    latency += hal::channel.jitterMicros > 0 ? hal::exponential(hal::channel.jitterMicros) : 0;
+    if (!latency)
+    {
+        this->store(received, sequence);
+        return true;
+    }
+    this->rxPending++;
+    hal::at(hal::now() + latency, [this, received, sequence]() {
+        this->rxPending--;
+        this->store(received, sequence);
+    });
+    return true;
+}
+
+void RF24::store(const Payload &payload, uint32_t sequence)
+{
+    hal::radioStats.reordered += sequence < this->rxStored;
+    this->rxStored = max(this->rxStored, sequence);
+    this->rxFifo.push_back(payload);
+    this->status |= RF24_RX_DR;
+    this->updateIrq();
+}
+
+bool RF24::takeAckPayload(uint8_t pipe, Payload *ack)
+{
+    if (!this->ackPayloads)
+    {
+        return false;
+    }
+    for (std::deque<Payload>::iterator payload = this->txFifo.begin(); payload != this->txFifo.end(); payload++)
+    {
+        if (payload->ackPayload && payload->pipe == pipe)
+        {
+            *ack = *payload;
+            this->txFifo.erase(payload);
+            return true;
+        }
+    }
+    return false;
+}
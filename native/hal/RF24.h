@@ -0,0 +1,160 @@
+/* RF24 (native HAL)
+ *  - The RF24 API the firmware uses, on top of an in-process radio medium shared by all boxes (RF24.cpp)
+ *  - Enhanced ShockBurst as the nRF24L01+ does it: packet ID per payload, auto-ACK with ACK payloads, auto-retransmit
+ *    after the retry delay up to the retry count (ARC), duplicates (same packet ID and CRC) are ACKed but not stored,
+ *    3 level TX and RX FIFOs, status flags with the active low IRQ line on the box's irqPin
+ *  - Registers and SPI aren't simulated, every command costs the running loop HAL_SPI_MICROS
+ *  - Scripted mode (replay of a trace): received packets and the outcome of the own transmissions come from the
+ *    caller (inject(), complete()) instead of the medium
+ */
+
+#ifndef __RF24_H__
+#define __RF24_H__
+
+#include "Arduino.h"
+
+#define HAL_RADIO_FIFO 3           // nRF24L01+ TX and RX FIFO levels
+#define HAL_RADIO_SETTLE_MICROS 130 // PLL settling before every packet (TX and RX mode)
+
+typedef enum
+{
+    RF24_PA_MIN = 0,
+    RF24_PA_LOW,
+    RF24_PA_HIGH,
+    RF24_PA_MAX,
+    RF24_PA_ERROR
+} rf24_pa_dbm_e;
+
+typedef enum
+{
+    RF24_1MBPS = 0,
+    RF24_2MBPS,
+    RF24_250KBPS
+} rf24_datarate_e;
+
+typedef enum
+{
+    RF24_CRC_DISABLED = 0,
+    RF24_CRC_8,
+    RF24_CRC_16
+} rf24_crclength_e;
+
+class RF24
+{
+public:
+    RF24(uint16_t cePin, uint16_t csnPin);
+    bool begin();
+    bool isChipConnected();
+    void startListening();
+    void stopListening();
+    bool available();
+    bool available(uint8_t *pipe);
+    void read(void *buf, uint8_t len);
+    void startWrite(const void *buf, uint8_t len, const bool multicast);
+    bool writeAckPayload(uint8_t pipe, const void *buf, uint8_t len);
+    void whatHappened(bool &tx_ok, bool &tx_fail, bool &rx_ready);
+    void maskIRQ(bool tx_ok, bool tx_fail, bool rx_ready);
+    uint8_t flush_tx();
+    uint8_t flush_rx();
+    bool isFifo(bool about_tx, bool check_empty);
+    bool testRPD();
+    bool testCarrier() { return this->testRPD(); }
+    void setChannel(uint8_t channel);
+    uint8_t getChannel();
+    void setPayloadSize(uint8_t size);
+    uint8_t getPayloadSize();
+    uint8_t getDynamicPayloadSize();
+    void enableAckPayload();
+    void disableAckPayload();
+    void enableDynamicPayloads();
+    void disableDynamicPayloads();
+    void enableDynamicAck();
+    void setAutoAck(bool enable);
+    void setAutoAck(uint8_t pipe, bool enable);
+    void setPALevel(uint8_t level, bool lnaEnable = 1);
+    uint8_t getPALevel();
+    bool setDataRate(rf24_datarate_e speed);
+    rf24_datarate_e getDataRate();
+    void setRetries(uint8_t delay, uint8_t count);
+    uint8_t getARC();
+    void setCRCLength(rf24_crclength_e length);
+    void disableCRC();
+    void openWritingPipe(const uint8_t *address);
+    void openReadingPipe(uint8_t pipe, const uint8_t *address);
+    void closeReadingPipe(uint8_t pipe);
+    void powerUp() {}
+    void powerDown() {}
+    bool failureDetected = false;
+
+    // scripted mode
+    void inject(uint8_t pipe, const void *buf, uint8_t len); // packet received now, an ACK payload for pipe goes out
+    void complete(bool delivered, uint8_t arc, const void *ack = NULL, uint8_t ackLen = 0); // attempt ends now
+    bool scripted = false;
+
+private:
+    struct Payload
+    {
+        uint8_t data[32];
+        uint8_t len;
+        uint8_t pipe;    // RX: reading pipe, TX: pipe of an ACK payload
+        bool ackPayload; // TX: only goes out with the ACK of a packet received on pipe
+        bool noAck;      // TX: multicast (sent once, no ACK expected)
+    };
+
+    void command();
+    void updateIrq();
+    void transmit(hal::Time start);
+    void transmitted(hal::Time start, hal::Time end);
+    void acked(const Payload *ack);
+    void completed();
+    bool receives(const RF24 *sender, hal::Time start, hal::Time end, uint8_t *pipe);
+    bool deliver(uint8_t pipe, const Payload &payload, uint8_t pid);
+    void store(const Payload &payload, uint32_t sequence);
+    bool takeAckPayload(uint8_t pipe, Payload *ack);
+    hal::Time airMicros(uint8_t len);
+
+    hal::Box *box = NULL;
+    uint8_t channel = 76;
+    bool listening = false;
+    hal::Time rxReadyTime = 0; // RX mode settled (packets starting earlier aren't received)
+    hal::Time busyUntil = 0;   // end of the last own packet on air (ACKs included)
+    uint8_t pipes[6][5];
+    uint8_t pipesOpen = 0;         // bitfield
+    uint8_t pipe0Reading[5];       // restored by startListening() (openWritingPipe() takes pipe 0 for the ACKs)
+    bool pipe0ReadingOpen = false;
+    uint8_t txAddress[5];
+    bool dynamicPayloads = false;
+    bool ackPayloads = false;
+    bool dynamicAck = false;
+    uint8_t autoAck = 0x3F; // bitfield of the pipes
+    uint8_t payloadSize = 32;
+    rf24_datarate_e dataRate = RF24_1MBPS;
+    uint8_t paLevel = RF24_PA_MAX;
+    uint8_t retryDelay = 5;
+    uint8_t retryCount = 15;
+    uint8_t irqMask = 0;
+    uint8_t status = 0;
+    uint8_t arc = 0;
+    std::deque<Payload> txFifo;
+    std::deque<Payload> rxFifo;
+    bool transmitting = false;
+    uint8_t attempt = 0;
+    uint8_t pid = 0;
+    uint32_t generation = 0; // a flush or mode change cancels the transmission events of the previous generation
+    uint8_t lastPid[6];
+    uint16_t lastCrc[6];
+    uint8_t rxPending = 0;    // received packets held back by the channel latency
+    uint32_t rxSequence = 0;  // received packets, in the order they ended on air
+    uint32_t rxStored = 0;    // highest sequence stored in the RX FIFO
+
+    struct Outcome
+    {
+        bool delivered;
+        uint8_t arc;
+        bool hasAck;
+        Payload ack;
+    };
+    std::deque<Outcome> outcomes; // scripted: attempt outcomes that came before the attempt itself
+};
+
+#endif
@@ -0,0 +1,8 @@
+/* SPI (native HAL)
+ *  - Nothing to do, the radio isn't accessed over SPI (see RF24.h)
+ */
+
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#endif
@@ -0,0 +1,25 @@
+/* Servo (native HAL)
+ *  - The angle written goes to the box (hal::Box::servo) and to hal::Listener::servo()
+ */
+
+#ifndef Servo_h
+#define Servo_h
+
+#include "Arduino.h"
+
+class Servo
+{
+public:
+    uint8_t attach(int pin);
+    uint8_t attach(int pin, int min, int max);
+    void detach();
+    void write(int value);
+    int read();
+    bool attached();
+
+private:
+    int pin = -1;
+    int angle = 90;
+};
+
+#endif
@@ -0,0 +1,15 @@
+/* AVR interrupts (native HAL)
+ *  - ISR(vector) defines a plain function in the box namespace, native/box_*.cpp hands PCINT0-2 to the box
+ */
+
+#ifndef _AVR_INTERRUPT_H_
+#define _AVR_INTERRUPT_H_
+
+#include "../Hal.h"
+
+#define ISR(vector, ...) void vector(void)
+
+#define sei() (hal::current()->setInterrupts(true))
+#define cli() (hal::current()->setInterrupts(false))
+
+#endif
@@ -0,0 +1,38 @@
+/* AVR registers (native HAL)
+ *  - Only the pin input, pin-change interrupt, reset flag and stack pointer registers the firmware uses, they belong
+ *    to the running box
+ */
+
+#ifndef _AVR_IO_H_
+#define _AVR_IO_H_
+
+#include "../Hal.h"
+
+#define _BV(bit) (1 << (bit))
+
+#define PINB (hal::current()->port(8))
+#define PINC (hal::current()->port(14))
+#define PIND (hal::current()->port(0))
+
+#define PCICR (hal::current()->pcicr)
+#define PCIFR (hal::current()->pcifr)
+#define PCMSK0 (hal::current()->pcmsk[0])
+#define PCMSK1 (hal::current()->pcmsk[1])
+#define PCMSK2 (hal::current()->pcmsk[2])
+
+#define SP (hal::current()->stackPointer())
+#define MCUSR (hal::current()->mcusr)
+
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+
+#endif
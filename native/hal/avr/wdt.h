@@ -0,0 +1,25 @@
+/* AVR watchdog (native HAL)
+ *  - Acts on the watchdog of the running box, see hal::Box::checkWatchdog()
+ */
+
+#ifndef _AVR_WDT_H_
+#define _AVR_WDT_H_
+
+#include "../Hal.h"
+
+#define WDTO_15MS 0
+#define WDTO_30MS 1
+#define WDTO_60MS 2
+#define WDTO_120MS 3
+#define WDTO_250MS 4
+#define WDTO_500MS 5
+#define WDTO_1S 6
+#define WDTO_2S 7
+#define WDTO_4S 8
+#define WDTO_8S 9
+
+#define wdt_enable(timeout) (hal::current()->watchdogEnable(timeout))
+#define wdt_disable() (hal::current()->watchdogDisable())
+#define wdt_reset() (hal::current()->watchdogReset())
+
+#endif
@@ -0,0 +1,10 @@
+/* printf (native HAL)
+ *  - stdout of the host is already there
+ */
+
+#ifndef __PRINTF_H__
+#define __PRINTF_H__
+
+inline void printf_begin() {}
+
+#endif
@@ -0,0 +1,317 @@
+/* Replay (native HAL)
+ *  - Replays the captured serial log of a box built with TRACE_ENABLED (include/Trace.h) through the firmware of the
+ *    same role: lever edges, remote levels, received payloads, the outcome of every transmission attempt and serial
+ *    input at their recorded times, the box clock, pairing record, randomSeed() value and session settings of its setup
+ *  - The box runs alone with a scripted radio (RF24.h), virtual time runs as fast as the host executes the loops
+ *  - Every line the replay prints is compared with the log in order, the first difference is reported; the inputs the
+ *    loop polls (~R, ~S) carry loop times and are left out of the comparison
+ *  - Settings other than the session settings have to be those of the recorded box (settings.h)
+ *  - usage: program replay <log> [--verbose] [--tail S]   (--tail: seconds replayed after the last input, default 150)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <RF24.h>
+
+#include "Pairing.h"
+#include "Session.h"
+#include "Trace.h"
+
+#define REPLAY_TAIL_SECONDS 150 // longer than LONG_TIMEOUT_MICROS, the unlock after it is still compared
+
+struct Input
+{
+    char type;
+    uint32_t time;
+    std::vector<uint8_t> data; // fields after the time
+    size_t line;               // in the log
+    bool ackPayload = false;   // ~F: came with the ACK of the preceding ~T, delivered by it
+    const Input *ack = NULL;   // ~T: the ACK payload
+};
+
+// the lines of the box, trace lines of the polled inputs left out
+class Replayer : public hal::Listener
+{
+public:
+    void serialLine(hal::Box *box, const char *line) override
+    {
+        if (this->verbose)
+        {
+            printf("%10.3f %-8s %s\n", hal::now() / 1e6, box->name, line);
+        }
+        if (compared(line))
+        {
+            this->lines.push_back(std::make_pair(hal::now(), std::string(line)));
+        }
+    }
+
+    static bool compared(const char *line)
+    {
+        return *line && !(line[0] == TRACE_MARK && (line[1] == 'R' || line[1] == 'S'));
+    }
+
+    std::vector<std::pair<hal::Time, std::string>> lines;
+    bool verbose = false;
+};
+
+static Replayer replayer;
+
+// "~Fhhhhhhhh..." into type, time and one byte per field (~F: pipe, then the payload bytes), the records without time
+// (~H, ~N, ~P) into 4 little-endian bytes per field
+static bool parseInput(const char *line, Input *input)
+{
+    static const char *layouts[] = {"H22828882222", "N8", "P82822", "L82", "R81", "F81", "T811", "S82"};
+    input->type = line[1];
+    const char *layout = NULL;
+    for (const char *candidate : layouts)
+    {
+        layout = candidate[0] == input->type ? candidate + 1 : layout;
+    }
+    if (!layout)
+    {
+        return false;
+    }
+    const char *text = line + 2;
+    std::vector<uint32_t> fields;
+    for (; *layout || (input->type == 'F' && *text); layout += *layout ? 1 : 0)
+    {
+        int digits = *layout ? *layout - '0' : 2; // ~F: payload bytes after the fields
+        char field[9] = {0};
+        if ((int)strlen(text) < digits)
+        {
+            return false;
+        }
+        memcpy(field, text, digits);
+        char *end;
+        fields.push_back(strtoul(field, &end, 16));
+        if (*end)
+        {
+            return false;
+        }
+        text += digits;
+    }
+    if (*text)
+    {
+        return false;
+    }
+    bool timed = strchr("LRFTS", input->type);
+    input->time = timed ? fields[0] : 0;
+    for (size_t i = timed; i < fields.size(); i++)
+    {
+        for (uint8_t byte = 0; byte < (timed ? 1 : 4); byte++)
+        {
+            input->data.push_back(fields[i] >> (8 * byte));
+        }
+    }
+    return true;
+}
+
+static uint32_t field(const Input &input, size_t index)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        value |= (uint32_t)input.data[4 * index + i] << (8 * i);
+    }
+    return value;
+}
+
+// one input at its time (box clock of the recording = box clock of the replay)
+static void schedule(hal::Box *box, const Input &input, hal::Time time)
+{
+    const Input *in = &input;
+    switch (input.type)
+    {
+    case 'L':
+        hal::at(time, [box, in]() {
+            uint8_t pins = in->data[0];
+            box->setPin(LEVER_UP_PIN, pins >> LEVER_UP_PIN & 1);
+            box->setPin(LEVER_DOWN_PIN, pins >> LEVER_DOWN_PIN & 1);
+        });
+        break;
+    case 'R':
+        hal::at(time, [box, in]() { box->setPin(REMOTE_PIN, in->data[0]); });
+        break;
+    case 'F':
+        if (!input.ackPayload)
+        {
+            hal::at(time, [box, in]() {
+                if (box->radio)
+                {
+                    box->radio->inject(in->data[0], &in->data[1], in->data.size() - 1);
+                }
+            });
+        }
+        break;
+    case 'T':
+        hal::at(time, [box, in]() {
+            const Input *ack = in->ack;
+            if (!box->radio)
+            {
+                return;
+            }
+            box->radio->complete(in->data[0], in->data[1], ack ? &ack->data[1] : NULL, ack ? ack->data.size() - 1 : 0);
+        });
+        break;
+    case 'S':
+        hal::at(time, [box, in]() {
+            char text[2] = {(char)in->data[0], 0};
+            box->serialInput(text);
+        });
+        break;
+    }
+}
+
+int replay(int argc, char **argv)
+{
+    const char *path = NULL;
+    double tail = REPLAY_TAIL_SECONDS;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--verbose"))
+        {
+            replayer.verbose = true;
+        }
+        else if (!strcmp(argv[i], "--tail") && i + 1 < argc)
+        {
+            tail = atof(argv[++i]);
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    FILE *file = path ? fopen(path, "r") : NULL;
+    if (!file)
+    {
+        fprintf(stderr, "replay: cannot open %s\n", path ? path : "(no log given)");
+        return 2;
+    }
+
+    // log: inputs and the lines to compare
+    std::vector<Input> inputs;
+    std::vector<std::pair<size_t, std::string>> expected;
+    char buffer[512];
+    for (size_t number = 1; fgets(buffer, sizeof(buffer), file); number++)
+    {
+        buffer[strcspn(buffer, "\r\n")] = 0;
+        Input input;
+        input.line = number;
+        if (buffer[0] == TRACE_MARK && !parseInput(buffer, &input))
+        {
+            fprintf(stderr, "replay: line %zu: cannot parse \"%s\"\n", number, buffer);
+            return 2;
+        }
+        if (buffer[0] == TRACE_MARK)
+        {
+            inputs.push_back(input);
+        }
+        if (Replayer::compared(buffer))
+        {
+            expected.push_back(std::make_pair(number, std::string(buffer)));
+        }
+    }
+    fclose(file);
+    if (inputs.empty() || inputs[0].type != 'H' || field(inputs[0], 0) != TRACE_VERSION)
+    {
+        fprintf(stderr, "replay: %s has no trace of version %d (TRACE_ENABLED)\n", path, TRACE_VERSION);
+        return 2;
+    }
+
+    // setup: role, clock, pins, session settings
+    const Input &header = inputs[0];
+    uint8_t role = field(header, 1);
+    hal::Box *box = hal::find(role == RADIO_MASTER ? "master" : role == RADIO_SLAVE ? "slave" : "training");
+    uint32_t start = field(header, 2);
+    uint8_t pins = field(header, 3);
+    hal::settings.synchMicros = field(header, 4);
+    hal::settings.itiMicros = field(header, 5);
+    hal::settings.longTimeoutMicros = field(header, 6);
+    hal::settings.synchPullMax = field(header, 7);
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        hal::settings.modeTestCount[i] = field(header, 8 + i);
+    }
+    hal::settings.trace = true;
+    box->clockOffset = start;
+    box->radioScripted = true;
+    box->setPin(REMOTE_PIN, pins >> REMOTE_PIN & 1);
+    box->setPin(LEVER_UP_PIN, pins >> LEVER_UP_PIN & 1);
+    box->setPin(LEVER_DOWN_PIN, pins >> LEVER_DOWN_PIN & 1);
+
+    // inputs at their times (micros() wraps after 71 min), ACK payloads with the attempt they came with
+    hal::Time epoch = 0, last = 0;
+    uint32_t previous = start;
+    for (size_t i = 1; i < inputs.size(); i++)
+    {
+        Input &input = inputs[i];
+        if (input.type == 'N')
+        {
+            box->analog[A7] = field(input, 0) & 0x3FF;
+        }
+        else if (input.type == 'P')
+        {
+            uint32_t id = field(input, 0);
+            PairingRecord record = {(uint8_t)field(input, 1), field(input, 2), (uint8_t)field(input, 3),
+                                    (uint8_t)field(input, 4)};
+            memcpy(&box->eeprom[PAIRING_EEPROM_ADDRESS], &id, sizeof(id));
+            memcpy(&box->eeprom[PAIRING_EEPROM_ADDRESS + sizeof(id)], &record, sizeof(record));
+        }
+        if (input.type == 'T' && input.data[0])
+        {
+            for (size_t j = i + 1; j < inputs.size() && inputs[j].type != 'T'; j++)
+            {
+                if (inputs[j].type == 'F' && inputs[j].time == input.time && inputs[j].data[0] == 0)
+                {
+                    inputs[j].ackPayload = true;
+                    input.ack = &inputs[j];
+                    break;
+                }
+            }
+        }
+        if (!strchr("LRFTS", input.type))
+        {
+            continue;
+        }
+        if ((int32_t)(input.time - previous) < 0 && previous - input.time > 0x80000000u)
+        {
+            epoch += 0x100000000ULL; // wrapped
+        }
+        previous = input.time;
+        hal::Time time = epoch + input.time - start;
+        last = time > last ? time : last;
+        schedule(box, input, time);
+    }
+
+    hal::listener = &replayer;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    box->start(0);
+    hal::run(last + (hal::Time)(tail * SESSION_SECOND));
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    size_t compared = expected.size() < replayer.lines.size() ? expected.size() : replayer.lines.size();
+    for (size_t i = 0; i < compared; i++)
+    {
+        if (expected[i].second != replayer.lines[i].second)
+        {
+            printf("replay differs at line %zu of %s (%.6f s):\n  log:    %s\n  replay: %s\n", expected[i].first, path,
+                   replayer.lines[i].first / 1e6, expected[i].second.c_str(), replayer.lines[i].second.c_str());
+            return 1;
+        }
+    }
+    if (compared < expected.size())
+    {
+        printf("replay ended before line %zu of %s: %s\n", expected[compared].first, path,
+               expected[compared].second.c_str());
+        return 1;
+    }
+    printf("%zu inputs replayed, %zu lines identical, %.1f s of session in %.2f s\n", inputs.size(), compared,
+           hal::now() / 1e6, elapsed);
+    return 0;
+}
@@ -0,0 +1,698 @@
+/* Session driver (native HAL)
+ *  - Runs the boxes of native/box_*.cpp through whole sessions: animals pulling the levers, remote gestures, packet
+ *    loss and radio cuts, then checks what the boxes did (rewards, lever lock, serial output)
+ *  - Every scenario runs in its own process (the globals of the firmware can't be reset), without a scenario name the
+ *    program runs all of them one after the other and prints a summary
+ *  - usage: program [scenario] [--verbose] [--seed N]   (--verbose prints the serial output of the boxes)
+ *           program scenario --log BOX FILE             (serial output of BOX into FILE, see replay.cpp)
+ *           program sweep [options]                     (parameter sweep, see sweep.cpp)
+ *           program replay FILE                         (replay of a trace, see replay.cpp)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "LinkStats.h"
+#include "Session.h"
+
+static bool failed = false;
+
+Recorder recorder;
+
+void check(bool condition, const char *what)
+{
+    printf("  %s %s\n", condition ? "ok  " : "FAIL", what);
+    failed |= !condition;
+}
+
+// master reward explained by a master pull and a slave pull less than SYNCH_MICROS (plus margin) apart
+static bool justified(hal::Time reward, const Animal &master, const Animal &slave)
+{
+    for (hal::Time masterPull : master.pulls)
+    {
+        if (masterPull > reward || reward - masterPull > SYNCH_MICROS + SESSION_SYNCH_MARGIN_MICROS)
+        {
+            continue;
+        }
+        for (hal::Time slavePull : slave.pulls)
+        {
+            hal::Time apart = slavePull > masterPull ? slavePull - masterPull : masterPull - slavePull;
+            if (slavePull <= reward && apart <= SYNCH_MICROS + SESSION_SYNCH_MARGIN_MICROS)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// rewards of a pair session: as many on both boxes, every one explained by two pulls
+static void checkPairRewards(hal::Box *master, hal::Box *slave, const Animal &masterAnimal, const Animal &slaveAnimal)
+{
+    std::vector<hal::Time> &rewards = recorder.records[master].rewards;
+    bool allJustified = true;
+    for (hal::Time reward : rewards)
+    {
+        allJustified &= justified(reward, masterAnimal, slaveAnimal);
+    }
+    printf("  %zu pulls master, %zu pulls slave, %zu rewards master, %zu rewards slave\n", masterAnimal.pulls.size(),
+           slaveAnimal.pulls.size(), rewards.size(), recorder.records[slave].rewards.size());
+    check(rewards.size() >= 5, "rewards were given");
+    check(rewards.size() == recorder.records[slave].rewards.size(), "master and slave gave as many rewards");
+    check(allJustified, "every reward follows a synchronous pull");
+}
+
+// master reward explained by the quorum: a master pull and GROUP_BOX_QUORUM - 1 members pulling less than
+// SYNCH_MICROS (plus margin) from it, all before the reward
+static bool quorumMet(hal::Time reward, const std::vector<Animal *> &animals)
+{
+    hal::Time window = SYNCH_MICROS + SESSION_SYNCH_MARGIN_MICROS;
+    for (hal::Time masterPull : animals[0]->pulls)
+    {
+        if (masterPull > reward || reward - masterPull > window)
+        {
+            continue;
+        }
+        int levers = 1;
+        for (size_t member = 1; member < animals.size(); member++)
+        {
+            for (hal::Time pull : animals[member]->pulls)
+            {
+                if (pull <= reward && (pull > masterPull ? pull - masterPull : masterPull - pull) <= window)
+                {
+                    levers++;
+                    break;
+                }
+            }
+        }
+        if (levers >= GROUP_BOX_QUORUM)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// rewards of box at or after from
+static int rewardsSince(hal::Box *box, hal::Time from)
+{
+    int count = 0;
+    for (hal::Time reward : recorder.records[box].rewards)
+    {
+        count += reward >= from;
+    }
+    return count;
+}
+
+// asks box for its loop profile at time (LOOP_PROFILE_REQUEST)
+static void requestProfile(hal::Box *box, hal::Time time)
+{
+    hal::at(time, [box]() { box->serialInput("P"); });
+}
+
+// slowest loop() of the box in micros from its last loop profile, -1 without one
+static long worstLoop(hal::Box *box)
+{
+    long worst = -1;
+    for (const std::pair<hal::Time, std::string> &line : recorder.records[box].lines)
+    {
+        size_t at = line.second.find(" worst=");
+        if (!line.second.compare(0, 8, "Loop: n=") && at != std::string::npos)
+        {
+            worst = atol(line.second.c_str() + line.second.rfind('/') + 1);
+        }
+    }
+    return worst;
+}
+
+// the whole loop stays short while frames are retransmitted or given up (no blocking radio call), text output at
+// 9600 bps (events=0) blocks once the serial buffer is full and isn't checked
+static void checkWorstLoops(hal::Box *master, hal::Box *slave)
+{
+    long masterWorst = worstLoop(master), slaveWorst = worstLoop(slave);
+    printf("  slowest loop %ld us master, %ld us slave\n", masterWorst, slaveWorst);
+    check(!LOOP_PROFILE_ENABLED || !EVENT_LOG_ENABLED || (masterWorst >= 0 && masterWorst < SESSION_LOOP_MICROS && slaveWorst >= 0 &&
+                                    slaveWorst < SESSION_LOOP_MICROS),
+          "no loop longer than SESSION_LOOP_MICROS");
+}
+
+// own transmissions of boxes, summed from their last link record (LINK_STATS_REQUEST, LinkStats.h)
+struct LinkRecord
+{
+    long delivered = 0;       // payloads
+    long lost = 0;            // payloads given up
+    long failedAttempts = 0;  // MAX_RT
+    long retransmissions = 0; // ARC sum of the ACKed payloads
+    long acked = 0;
+    std::vector<long> rtt; // round-trip time histogram of the ACKed payloads
+};
+
+static void addLinkRecord(LinkRecord &record, hal::Box *box)
+{
+    const char *line = NULL;
+    for (const std::pair<hal::Time, std::string> &printed : recorder.records[box].lines)
+    {
+        line = !printed.second.compare(0, 6, "Link: ") ? printed.second.c_str() : line;
+    }
+    long delivered, lost, failed, retransmissions;
+    const char *tx = line ? strstr(line, " tx=") : NULL, *rtt = line ? strstr(line, " rtt=") : NULL;
+    if (!tx || !rtt || sscanf(tx, " tx=%ld,%ld,%ld arc=%ld", &delivered, &lost, &failed, &retransmissions) != 4)
+    {
+        return;
+    }
+    record.delivered += delivered;
+    record.lost += lost;
+    record.failedAttempts += failed;
+    record.retransmissions += retransmissions;
+    rtt += 5;
+    for (size_t bucket = 0; *rtt && *rtt != ' '; bucket++)
+    {
+        char *end;
+        long count = strtol(rtt, &end, 10);
+        record.rtt.resize(max(record.rtt.size(), bucket + 1), 0);
+        record.rtt[bucket] += count;
+        record.acked += count;
+        rtt = *end == '/' ? end + 1 : end;
+    }
+}
+
+// upper limit of the round-trip time of the given share of the ACKed payloads (histogram bucket it falls into)
+static long rttQuantile(const LinkRecord &record, double share)
+{
+    long count = 0;
+    for (size_t bucket = 0; bucket < record.rtt.size(); bucket++)
+    {
+        count += record.rtt[bucket];
+        if (count >= share * record.acked)
+        {
+            return 1L << (LINK_STATS_RTT_SHIFT + bucket);
+        }
+    }
+    return -1;
+}
+
+// SCENARIOS ======================================================================
+
+static void training()
+{
+    hal::Box *box = hal::find("training");
+    Animal animal(box, 3 * SESSION_SECOND);
+    hal::Time end = 10 * SESSION_MINUTE;
+    rest(box);
+    box->start(0);
+    animal.start(SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    hal::at(end - SESSION_SECOND, [box]() { box->serialInput("P"); });
+    hal::at(end - SESSION_SECOND / 2, [box]() { box->serialInput("M"); });
+    hal::run(end);
+
+    printf("  %zu pulls, %zu rewards\n", animal.pulls.size(), recorder.records[box].rewards.size());
+    check(animal.pulls.size() >= 20, "the animal pulled");
+    check(recorder.records[box].rewards.size() == animal.pulls.size(), "every pull was rewarded (mode 1)");
+    check(!LOOP_PROFILE_ENABLED || recorder.printed(box, "Loop: n=") == 1, "P prints the loop profile");
+    check(recorder.printed(box, "Events dropped") == 0, "no event record was dropped");
+    check(recorder.printed(box, "Stack: free=1008 gap=848 depth=160") == 1, "M prints the SRAM model of the HAL");
+}
+
+static void trainingRemote()
+{
+    hal::Box *box = hal::find("training");
+    Animal animal(box, 3 * SESSION_SECOND);
+    hal::Time end = 10 * SESSION_MINUTE;
+    int lockedAngle = -1, unlockedAngle = -1;
+    rest(box);
+    box->start(0);
+    animal.start(SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    press(box, 60 * SESSION_SECOND, "S");
+    sample(box, 80 * SESSION_SECOND, &lockedAngle);
+    press(box, 90 * SESSION_SECOND, "S");
+    sample(box, 91 * SESSION_SECOND, &unlockedAngle);
+    press(box, 120 * SESSION_SECOND, "L");
+    hal::run(end);
+
+    hal::Time modeTwo = 122 * SESSION_SECOND;
+    int pulls = animal.pullsSince(modeTwo);
+    int rewards = 0;
+    for (hal::Time reward : recorder.records[box].rewards)
+    {
+        rewards += reward >= modeTwo;
+    }
+    printf("  mode 2: %d pulls, %d rewards\n", pulls, rewards);
+    int lockedPulls = animal.pullsSince(62 * SESSION_SECOND) - animal.pullsSince(90 * SESSION_SECOND);
+    check(lockedAngle == 180 && !lockedPulls, "SHORT locks the lever");
+    check(unlockedAngle == 0, "SHORT unlocks it again");
+    check(recorder.printed(box, "Mode: MD_TWO") == 1, "LONG switches to mode 2");
+    check(pulls >= 20 && rewards > 0 && 2 * rewards <= pulls, "mode 2 rewards every 2-5 pulls");
+}
+
+static void pair()
+{
+    hal::Box *master = hal::find("master"), *slave = hal::find("slave");
+    Animal masterAnimal(master, 2 * SESSION_SECOND), slaveAnimal(slave, 2 * SESSION_SECOND);
+    hal::Time end = 10 * SESSION_MINUTE;
+    startPair(master, slave);
+    masterAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    slaveAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    hal::run(end);
+
+    checkPairRewards(master, slave, masterAnimal, slaveAnimal);
+    Synchrony synch = synchrony(master, slave, slaveAnimal);
+    printf("  %d synchronous pulls, %d not rewarded\n", synch.pulls, synch.missed);
+    check(synch.pulls > 0 && !synch.missed, "every synchronous pull rewarded (slave pull times mapped across 2^31)");
+    printf("  %d frames of the master and %d of the slave given up\n", recorder.records[master].txFailures,
+           recorder.records[slave].txFailures);
+    check(!recorder.printed(master, "link lost") && !recorder.printed(slave, "link lost"), "the link stayed up");
+}
+
+static void pairLossy()
+{
+    hal::Box *master = hal::find("master"), *slave = hal::find("slave");
+    Animal masterAnimal(master, 2 * SESSION_SECOND), slaveAnimal(slave, 2 * SESSION_SECOND);
+    hal::Time end = 10 * SESSION_MINUTE;
+    hal::channel.loss = 0.3;
+    startPair(master, slave);
+    masterAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    slaveAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    requestProfile(master, end - SESSION_SECOND);
+    requestProfile(slave, end - SESSION_SECOND);
+    hal::run(end);
+
+    // a reward command can still fail definitively (both boxes retransmitting at once don't hear each other)
+    size_t masterRewards = recorder.records[master].rewards.size(), slaveRewards = recorder.records[slave].rewards.size();
+    bool allJustified = true;
+    for (hal::Time reward : recorder.records[master].rewards)
+    {
+        allJustified &= justified(reward, masterAnimal, slaveAnimal);
+    }
+    printf("  %zu rewards master, %zu rewards slave\n", masterRewards, slaveRewards);
+    check(masterRewards >= 5 && allJustified, "every reward follows a synchronous pull");
+    check(slaveRewards <= masterRewards, "the slave only rewards together with the master");
+    check(4 * slaveRewards >= 3 * masterRewards, "most rewards reach the slave");
+    checkWorstLoops(master, slave);
+}
+
+static void pairRemote()
+{
+    hal::Box *master = hal::find("master"), *slave = hal::find("slave");
+    Animal masterAnimal(master, 2 * SESSION_SECOND), slaveAnimal(slave, 2 * SESSION_SECOND);
+    hal::Time end = 5 * SESSION_MINUTE;
+    int masterLocked = -1, slaveLocked = -1, masterUnlocked = -1, slaveUnlocked = -1;
+    startPair(master, slave);
+    masterAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    slaveAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    press(master, 60 * SESSION_SECOND, "S");
+    sample(master, 85 * SESSION_SECOND, &masterLocked);
+    sample(slave, 85 * SESSION_SECOND, &slaveLocked);
+    press(master, 90 * SESSION_SECOND, "S");
+    sample(master, 91 * SESSION_SECOND, &masterUnlocked);
+    sample(slave, 91 * SESSION_SECOND, &slaveUnlocked);
+    hal::run(end);
+
+    check(masterLocked == 180 && slaveLocked == 180, "SHORT on the master locks both levers");
+    check(masterUnlocked == 0 && slaveUnlocked == 0, "SHORT on the master unlocks both levers");
+    check(recorder.records[master].rewards.size() == recorder.records[slave].rewards.size(),
+          "master and slave gave as many rewards");
+}
+
+static void pairCut()
+{
+    hal::Box *master = hal::find("master"), *slave = hal::find("slave");
+    Animal masterAnimal(master, 2 * SESSION_SECOND), slaveAnimal(slave, 2 * SESSION_SECOND);
+    hal::Time end = 5 * SESSION_MINUTE;
+    int masterLocked = -1, slaveLocked = -1, masterUnlocked = -1, slaveUnlocked = -1;
+    startPair(master, slave);
+    masterAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    slaveAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    hal::at(60 * SESSION_SECOND, [slave]() { slave->radioMuted = true; });
+    press(master, 70 * SESSION_SECOND, "S"); // the lock command can't reach the slave
+    hal::at(90 * SESSION_SECOND, [slave]() { slave->radioMuted = false; });
+    sample(master, 100 * SESSION_SECOND, &masterLocked);
+    sample(slave, 100 * SESSION_SECOND, &slaveLocked);
+    press(master, 110 * SESSION_SECOND, "S");
+    sample(master, 111 * SESSION_SECOND, &masterUnlocked);
+    sample(slave, 111 * SESSION_SECOND, &slaveUnlocked);
+    requestProfile(master, end - SESSION_SECOND);
+    requestProfile(slave, end - SESSION_SECOND);
+    hal::run(end);
+
+    check(recorder.printed(master, "link lost", 60 * SESSION_SECOND) == 1 &&
+              recorder.printed(slave, "link lost", 60 * SESSION_SECOND) == 1,
+          "both boxes report the link lost");
+    check(recorder.printed(master, "link back", 90 * SESSION_SECOND) == 1 &&
+              recorder.printed(slave, "link back", 90 * SESSION_SECOND) == 1,
+          "both boxes report the link back");
+    check(recorder.printed(slave, "resynchronised", 90 * SESSION_SECOND) >= 1 && masterLocked == 180 &&
+              slaveLocked == 180,
+          "the slave takes over the lock it missed");
+    check(masterUnlocked == 0 && slaveUnlocked == 0, "both levers unlock together again");
+    checkWorstLoops(master, slave);
+}
+
+static void group()
+{
+    std::vector<hal::Box *> boxes = {hal::find("group-master")};
+    std::vector<Animal *> animals;
+    hal::Time end = 10 * SESSION_MINUTE, cut = 4 * SESSION_MINUTE;
+    for (int member = 1; member < GROUP_BOXES; member++)
+    {
+        boxes.push_back(hal::find(("member-" + std::to_string(member)).c_str()));
+    }
+    hal::Box *master = boxes[0], *lost = boxes.back();
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+        animals.push_back(new Animal(boxes[i], 2 * SESSION_SECOND));
+        boxes[i]->clockPpm = 20 * (int32_t)i;
+        boxes[i]->clockOffset = 0x40000000 * (uint32_t)i;
+        rest(boxes[i]);
+        boxes[i]->start(100000 * i);
+        animals[i]->start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    }
+    hal::at(cut, [lost]() { lost->radioMuted = true; }); // the last member is lost for the rest of the session
+    hal::run(end);
+
+    bool quorum = true;
+    for (hal::Time reward : recorder.records[master].rewards)
+    {
+        quorum &= quorumMet(reward, animals);
+    }
+    size_t rewards = recorder.records[master].rewards.size();
+    bool together = true;
+    int duplicates = 0, givenUp = 0;
+    printf("  %d of %d levers, %zu rewards master, %d after member %d was lost,", GROUP_BOX_QUORUM, GROUP_BOXES, rewards,
+           rewardsSince(master, cut), GROUP_BOXES - 1);
+    for (size_t i = 1; i < boxes.size(); i++)
+    {
+        printf(" %zu member %zu", recorder.records[boxes[i]].rewards.size(), i);
+        if (boxes[i] != lost)
+        {
+            together &= recorder.records[boxes[i]].rewards.size() == rewards;
+            duplicates += recorder.printed(boxes[i], "Duplicate frame dropped");
+            givenUp += recorder.records[boxes[i]].txFailures;
+        }
+    }
+    printf("\n  %d repeated broadcasts dropped, %d member frames given up, %d collisions\n", duplicates, givenUp,
+           hal::radioStats.collisions);
+    std::string lostAlert = "Slave " + std::to_string(GROUP_BOXES - 1) + ": link lost";
+    check(rewards >= 5 && rewardsSince(master, cut) > 0, "the group rewards, also without the lost member");
+    check(quorum, "every reward follows GROUP_BOX_QUORUM synchronous pulls");
+    check(together && duplicates > 0, "the reachable members reward once per master reward (repeated broadcasts dropped)");
+    check(recorder.printed(master, lostAlert.c_str(), cut) == 1 &&
+              rewardsSince(lost, cut + SESSION_REWARD_MICROS) == 0,
+          "the master reports the lost member, which rewards no more");
+    check(hal::radioStats.collisions > 0 && givenUp == 0,
+          "member frames that collided get through on their staggered retries");
+    for (Animal *animal : animals)
+    {
+        delete animal;
+    }
+}
+
+// pairs on one channel from the boxes <pair>-master and <pair>-slave (the first pair "": master and slave), each with
+// its own animals and clocks, every pair rewards on its own; prints the own transmissions of all boxes
+static void sharedChannel(const std::vector<std::string> &pairs, LinkRecord &link)
+{
+    std::vector<hal::Box *> boxes;
+    std::vector<Animal *> animals;
+    hal::Time end = 10 * SESSION_MINUTE;
+    for (size_t i = 0; i < pairs.size(); i++)
+    {
+        std::string prefix = pairs[i].empty() ? "" : pairs[i] + "-";
+        hal::Box *master = hal::find((prefix + "master").c_str()), *slave = hal::find((prefix + "slave").c_str());
+        boxes.push_back(master);
+        boxes.push_back(slave);
+        for (hal::Box *box : {master, slave})
+        {
+            animals.push_back(new Animal(box, 2 * SESSION_SECOND));
+            box->clockPpm = 40 * (int32_t)(boxes.size() % 3) - 40;
+            box->clockOffset = 0x30000000 * (uint32_t)boxes.size();
+            rest(box);
+            box->start(170000 * (boxes.size() - 1));
+            animals.back()->start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+            hal::at(end - SESSION_SECOND, [box]() { box->serialInput("L"); });
+        }
+    }
+    hal::run(end);
+
+    bool together = true, rewarded = true;
+    for (size_t i = 0; i < pairs.size(); i++)
+    {
+        hal::Box *master = boxes[2 * i], *slave = boxes[2 * i + 1];
+        Synchrony synch = synchrony(master, slave, *animals[2 * i + 1]);
+        printf("  %-8s %3zu rewards, %d synchronous pulls, %d not rewarded, %d rewards the slave missed\n",
+               pairs[i].empty() ? "pair" : pairs[i].c_str(), recorder.records[master].rewards.size(), synch.pulls,
+               synch.missed, synch.slaveMissed);
+        rewarded &= recorder.records[master].rewards.size() >= 5 && 10 * synch.missed <= synch.pulls;
+        together &= !synch.slaveMissed && !synch.duplicated;
+        addLinkRecord(link, master);
+        addLinkRecord(link, slave);
+    }
+    printf("  %ld payloads, %.3f retransmissions each, %ld attempts failed, %ld given up, %d collisions\n",
+           link.delivered, link.acked ? (double)link.retransmissions / link.acked : 0, link.failedAttempts, link.lost,
+           hal::radioStats.collisions);
+    printf("  round trip: median below %.1f ms, 99 %% below %.1f ms\n", rttQuantile(link, 0.5) / 1e3,
+           rttQuantile(link, 0.99) / 1e3);
+    check(rewarded, "every pair rewards its synchronous pulls");
+    check(together, "the slaves reward together with their masters");
+    check(link.lost == 0, "no payload is given up");
+    for (Animal *animal : animals)
+    {
+        delete animal;
+    }
+}
+
+static void slots()
+{
+    std::vector<std::string> pairs;
+    for (int slot = 0; slot < SLOT_PAIRS; slot++)
+    {
+        pairs.push_back("slot" + std::to_string(slot));
+    }
+    LinkRecord link;
+    sharedChannel(pairs, link);
+    check(hal::radioStats.collisions * 100 < link.delivered,
+          "the pairs keep to their slots and the beacon (collisions below 1 % of the payloads)");
+}
+
+static void sharedFree()
+{
+    LinkRecord link;
+    sharedChannel({"", "free1", "free2"}, link);
+}
+
+// radio settings LinkControl arrived at, from the box's last link record ("ard=... loss=...%")
+static std::string linkSettings(hal::Box *box)
+{
+    std::string settings;
+    for (const std::pair<hal::Time, std::string> &printed : recorder.records[box].lines)
+    {
+        size_t from = printed.second.find(" ard=");
+        if (!printed.second.compare(0, 6, "Link: ") && from != std::string::npos)
+        {
+            settings = printed.second.substr(from + 1, printed.second.find(" rx", from) - from - 1);
+        }
+    }
+    return settings;
+}
+
+// the adaptive pair (master/slave, RADIO_ADAPTIVE_ENABLED) next to the fixed pair (fixed-master/fixed-slave, retries
+// (15, 15)) on a channel of their own each, with the same losses; the HAL loses packets regardless of the PA level, so
+// only the retry delay and count make a difference here; with independent losses the adaptive pair fails fewer attempts
+// (shorter overlaps of both sides transmitting), in bursts it answers faster
+static void linkPolicies(bool independentLoss)
+{
+    const char *names[] = {"adaptive", "fixed"};
+    hal::Box *boxes[] = {hal::find("master"), hal::find("slave"), hal::find("fixed-master"), hal::find("fixed-slave")};
+    LinkRecord links[2];
+    bool rewarded = true;
+    std::vector<Animal *> animals;
+    hal::Time end = 10 * SESSION_MINUTE;
+    for (int pair = 0; pair < 2; pair++)
+    {
+        startPair(boxes[2 * pair], boxes[2 * pair + 1]);
+        for (int i = 2 * pair; i < 2 * pair + 2; i++)
+        {
+            animals.push_back(new Animal(boxes[i], 2 * SESSION_SECOND));
+            animals.back()->start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+            hal::Box *box = boxes[i];
+            hal::at(end - SESSION_SECOND, [box]() { box->serialInput("L"); });
+        }
+    }
+    hal::run(end);
+
+    for (int pair = 0; pair < 2; pair++)
+    {
+        hal::Box *master = boxes[2 * pair], *slave = boxes[2 * pair + 1];
+        LinkRecord &link = links[pair];
+        Synchrony synch = synchrony(master, slave, *animals[2 * pair + 1]);
+        rewarded &= recorder.records[master].rewards.size() >= 5 && 10 * synch.missed <= synch.pulls;
+        addLinkRecord(link, master);
+        addLinkRecord(link, slave);
+        printf("  %-8s %3zu rewards, %d synchronous pulls, %d not rewarded, %d rewards the slave missed\n", names[pair],
+               recorder.records[master].rewards.size(), synch.pulls, synch.missed, synch.slaveMissed);
+        printf("           %ld payloads, %ld given up, %.3f retransmissions each, %ld attempts failed, round trip median "
+               "below %.1f ms, 99 %% below %.1f ms\n",
+               link.delivered, link.lost, link.acked ? (double)link.retransmissions / link.acked : 0,
+               link.failedAttempts, rttQuantile(link, 0.5) / 1e3, rttQuantile(link, 0.99) / 1e3);
+    }
+    printf("  adaptive settings at the end: master %s, slave %s\n", linkSettings(boxes[0]).c_str(),
+           linkSettings(boxes[1]).c_str());
+    check(rewarded, "both pairs reward most of their synchronous pulls");
+    if (independentLoss)
+    {
+        check(links[0].failedAttempts <= links[1].failedAttempts, "the adaptive pair fails no more attempts than the fixed one");
+    }
+    else
+    {
+        check(rttQuantile(links[0], 0.5) <= rttQuantile(links[1], 0.5),
+              "the adaptive pair's round trip (median) is no longer than the fixed one's");
+    }
+    for (Animal *animal : animals)
+    {
+        delete animal;
+    }
+}
+
+static void adaptiveLossy()
+{
+    hal::channel.loss = 0.3;
+    linkPolicies(true);
+}
+
+static void adaptiveBursts()
+{
+    hal::channel.loss = 0.02;
+    hal::channel.burst = 0.01;
+    hal::channel.burstLength = 20;
+    hal::channel.burstLoss = 0.95;
+    linkPolicies(false);
+}
+
+static void pairing()
+{
+    hal::Box *master = hal::find("master"), *slave = hal::find("slave");
+    Animal masterAnimal(master, 2 * SESSION_SECOND), slaveAnimal(slave, 2 * SESSION_SECOND);
+    hal::Time end = 5 * SESSION_MINUTE;
+    rest(master);
+    rest(slave);
+    slave->setPin(LEVER_UP_PIN, !LEVER_UP_STATE); // switched on with the lever pulled down
+    slave->setPin(LEVER_DOWN_PIN, LEVER_DOWN_STATE);
+    slave->clockPpm = -30;
+    master->start(0);
+    slave->start(200000);
+    hal::at(SESSION_SECOND, [slave]() { rest(slave); });
+    press(master, 10 * SESSION_SECOND, "LLL");
+    masterAnimal.start(60 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    slaveAnimal.start(60 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    hal::run(end);
+
+    check(recorder.printed(slave, "Pairing: waiting for the master") == 1, "the slave waits for an offer");
+    check(recorder.printed(master, "Pairing: started") == 1, "LONG LONG LONG starts the pairing");
+    check(recorder.printed(master, "is member 1") == 1 && recorder.printed(slave, "Pairing: member 1") == 1,
+          "the slave becomes member 1");
+    check(recorder.records[master].rewards.size() > 0 &&
+              recorder.records[master].rewards.size() == recorder.records[slave].rewards.size(),
+          "the paired boxes reward together");
+}
+
+struct Scenario
+{
+    const char *name;
+    const char *description;
+    void (*run)();
+};
+
+static const Scenario scenarios[] = {
+    {"training", "training box, mode 1", training},
+    {"training-remote", "training box, remote lock and mode 2", trainingRemote},
+    {"pair", "master and slave, clean link", pair},
+    {"pair-lossy", "master and slave, 30 % packet loss", pairLossy},
+    {"pair-remote", "master and slave, remote lock", pairRemote},
+    {"pair-cut", "master and slave, slave radio cut for 30 s", pairCut},
+    {"group", "group of four, three levers together, one member lost", group},
+    {"slots", "three pairs on one channel, slotted mode", slots},
+    {"shared", "three pairs on one channel, no slots", sharedFree},
+    {"adaptive-lossy", "adaptive and fixed radio settings, 30 % loss", adaptiveLossy},
+    {"adaptive-bursts", "adaptive and fixed radio settings, loss bursts", adaptiveBursts},
+    {"pairing", "pairing with the remote, then a session", pairing},
+    {"lever-ring", "lever edge ring, bursts and wraparound", leverRing},
+    {"debounce", "lever debouncer against the sampling one on bounce traces", debounce},
+    {"frames", "frame air time and sequence numbers", frames},
+    {"profiler", "loop profiler on loops stalled for seconds", profiler},
+    {"clock-sync", "clock offset and drift over asymmetric delays", clockSync},
+};
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && !strcmp(argv[1], "sweep"))
+    {
+        return sweep(argv[0], argc - 1, argv + 1);
+    }
+    if (argc > 1 && !strcmp(argv[1], "sweep-session"))
+    {
+        return sweepSession(argc - 1, argv + 1);
+    }
+    if (argc > 1 && !strcmp(argv[1], "replay"))
+    {
+        return replay(argc - 1, argv + 1);
+    }
+
+    const char *name = NULL;
+    unsigned long seed = 1;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--verbose"))
+        {
+            recorder.verbose = true;
+        }
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+        {
+            seed = strtoul(argv[++i], NULL, 0);
+        }
+        else if (!strcmp(argv[i], "--log") && i + 2 < argc)
+        {
+            recorder.logBox = argv[++i];
+            recorder.log = fopen(argv[++i], "w");
+            if (!recorder.log)
+            {
+                perror(argv[i]);
+                return 2;
+            }
+        }
+        else
+        {
+            name = argv[i];
+        }
+    }
+
+    if (!name) // every scenario in a process of its own
+    {
+        int failures = 0;
+        for (const Scenario &scenario : scenarios)
+        {
+            std::string command = std::string(argv[0]) + " " + scenario.name + " --seed " + std::to_string(seed);
+            command += recorder.verbose ? " --verbose" : "";
+            fflush(stdout);
+            int status = system(command.c_str());
+            failures += status != 0;
+        }
+        printf("%d of %zu scenarios failed\n", failures, sizeof(scenarios) / sizeof(scenarios[0]));
+        return failures ? 1 : 0;
+    }
+
+    for (const Scenario &scenario : scenarios)
+    {
+        if (!strcmp(scenario.name, name))
+        {
+            printf("%s (%s, seed %lu)\n", scenario.name, scenario.description, seed);
+            hal::listener = &recorder;
+            hal::seed(seed);
+            scenario.run();
+            printf("  %s\n", failed ? "FAILED" : "passed");
+            return failed ? 1 : 0;
+        }
+    }
+    fprintf(stderr, "unknown scenario %s\n", name);
+    return 2;
+}
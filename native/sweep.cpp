@@ -0,0 +1,400 @@
+/* Parameter sweep (native HAL)
+ *  - Runs master/slave pair sessions for every combination of the session settings, radio channels and animal
+ *    behaviours given as comma separated lists, every combination with the same seeds, and prints one line of
+ *    averages per combination
+ *  - Every session is a process of its own (HAL_SETTINGS carries the settings, box_settings.h), --jobs of them at once
+ *  - usage: program sweep [--synch S,..] [--iti S,..] [--long S,..] [--pull-max N,..] [--goal N,..] [--mean S,..]
+ *           [--follow P,..] [--loss P,..] [--burst P,..] [--burst-length N,..] [--burst-loss P,..] [--ack-loss P,..]
+ *           [--latency MS,..] [--jitter MS,..] [--off-every S,..] [--off-for S,..]
+ *           [--sessions N] [--hours H] [--loop US] [--jobs N] [--seed N] [--csv]
+ *      synch, iti, long: SYNCH_MICROS, ITI_MICROS, LONG_TIMEOUT_MICROS in seconds
+ *      pull-max, goal: SYNCH_PULL_MAX, MODE_TEST_ONE_COUNT
+ *      mean: mean wait of the animals for their next pull in seconds, follow: chance an animal answers a pull of the
+ *      other one within about a second
+ *      loss .. off-for: radio channel (hal::channel in native/hal/Hal.h), the table shows them once one is given
+ *      loop: virtual duration of one loop() (hal::loopMicros), the default trades loop timing for speed
+ *  - Synchronous pulls the master missed and rewards the slave missed or duplicated are counted by synchrony()
+ *    (Session.h)
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Session.h"
+
+#define SWEEP_HOURS 24      // default session length
+#define SWEEP_LOOP_MICROS 10000 // default hal::loopMicros (a 24 h pair session takes about 2 s instead of 70 s)
+
+// one list option: a HAL_SETTINGS key (value times scale) or an argument of sweepSession()
+struct Parameter
+{
+    const char *option;
+    const char *setting; // NULL: passed to sweepSession() as the option itself
+    double scale;
+    const char *column;
+    bool channel; // shown in the table only once given
+    std::vector<double> values;
+};
+
+// numbers of one session, the line sweepSession() prints
+enum
+{
+    OUT_MASTER_REWARDS,
+    OUT_SLAVE_REWARDS,
+    OUT_SYNCH_PULLS,
+    OUT_SYNCH_MISSED,
+    OUT_SLAVE_MISSED,
+    OUT_DUPLICATED,
+    OUT_LOCKED_MICROS,
+    OUT_WINDOW_TIMEOUTS,
+    OUT_LONG_TIMEOUTS,
+    OUT_PACKETS,
+    OUT_AIR_MICROS,
+    OUT_LOST,
+    OUT_ACKS_LOST,
+    OUT_DUPLICATES,
+    OUT_REORDERED,
+    OUT_COLLISIONS,
+    OUT_DURATION_MICROS,
+    OUT_COUNT
+};
+
+typedef std::vector<double> Outcome;
+
+struct Combination
+{
+    std::vector<double> values; // one per parameter
+    std::vector<Outcome> outcomes;
+};
+
+static std::vector<double> parseList(const char *text)
+{
+    std::vector<double> values;
+    for (char *end; *text; text = *end ? end + 1 : end)
+    {
+        values.push_back(strtod(text, &end));
+        if (end == text || (*end && *end != ','))
+        {
+            fprintf(stderr, "sweep: cannot parse the list \"%s\"\n", text);
+            exit(2);
+        }
+    }
+    return values;
+}
+
+static double mean(const std::vector<double> &values)
+{
+    double sum = 0;
+    for (double value : values)
+    {
+        sum += value;
+    }
+    return values.empty() ? 0 : sum / values.size();
+}
+
+static double deviation(const std::vector<double> &values)
+{
+    double average = mean(values), sum = 0;
+    for (double value : values)
+    {
+        sum += (value - average) * (value - average);
+    }
+    return values.size() < 2 ? 0 : sqrt(sum / (values.size() - 1));
+}
+
+// one session of a sweep: settings and channel from HAL_SETTINGS, animals from the arguments
+int sweepSession(int argc, char **argv)
+{
+    double hours = SWEEP_HOURS, meanSeconds = 2, follow = 0;
+    unsigned long seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--hours"))
+        {
+            hours = atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--mean"))
+        {
+            meanSeconds = atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--follow"))
+        {
+            follow = atof(argv[i + 1]);
+        }
+        else if (!strcmp(argv[i], "--seed"))
+        {
+            seed = strtoul(argv[i + 1], NULL, 0);
+        }
+    }
+
+    hal::Box *master = hal::find("master"), *slave = hal::find("slave");
+    Animal masterAnimal(master, meanSeconds * SESSION_SECOND), slaveAnimal(slave, meanSeconds * SESSION_SECOND);
+    hal::Time end = (hal::Time)(hours * 60 * SESSION_MINUTE);
+    masterAnimal.follower = &slaveAnimal;
+    slaveAnimal.follower = &masterAnimal;
+    masterAnimal.followChance = slaveAnimal.followChance = follow;
+    recorder.keepLines = false;
+    hal::listener = &recorder;
+    hal::seed(seed);
+    startPair(master, slave);
+    masterAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    slaveAnimal.start(5 * SESSION_SECOND, end - SESSION_SETTLE_MICROS);
+    hal::run(end);
+
+    Recorder::Record &record = recorder.records[master];
+    Synchrony synch = synchrony(master, slave, slaveAnimal);
+    Outcome outcome(OUT_COUNT);
+    outcome[OUT_MASTER_REWARDS] = record.rewards.size();
+    outcome[OUT_SLAVE_REWARDS] = recorder.records[slave].rewards.size();
+    outcome[OUT_SYNCH_PULLS] = synch.pulls;
+    outcome[OUT_SYNCH_MISSED] = synch.missed;
+    outcome[OUT_SLAVE_MISSED] = synch.slaveMissed;
+    outcome[OUT_DUPLICATED] = synch.duplicated;
+    outcome[OUT_LOCKED_MICROS] = recorder.lockedMicros(master);
+    outcome[OUT_WINDOW_TIMEOUTS] = record.windowTimeouts;
+    outcome[OUT_LONG_TIMEOUTS] = record.longTimeouts;
+    outcome[OUT_PACKETS] = hal::radioStats.packets;
+    outcome[OUT_AIR_MICROS] = hal::radioStats.airMicros;
+    outcome[OUT_LOST] = hal::radioStats.lost;
+    outcome[OUT_ACKS_LOST] = hal::radioStats.acksLost;
+    outcome[OUT_DUPLICATES] = hal::radioStats.duplicates;
+    outcome[OUT_REORDERED] = hal::radioStats.reordered;
+    outcome[OUT_COLLISIONS] = hal::radioStats.collisions;
+    outcome[OUT_DURATION_MICROS] = end;
+    for (double value : outcome)
+    {
+        printf("%.0f ", value);
+    }
+    printf("\n");
+    return 0;
+}
+
+int sweep(const char *program, int argc, char **argv)
+{
+    std::vector<Parameter> parameters = {
+        {"--synch", "synch", 1e6, "synch", false, {hal::settings.synchMicros / 1e6}},
+        {"--iti", "iti", 1e6, "iti", false, {hal::settings.itiMicros / 1e6}},
+        {"--long", "long", 1e6, "long", false, {hal::settings.longTimeoutMicros / 1e6}},
+        {"--pull-max", "pullmax", 1, "pmax", false, {(double)hal::settings.synchPullMax}},
+        {"--goal", "count1", 1, "goal", false, {(double)hal::settings.modeTestCount[0]}},
+        {"--mean", NULL, 1, "mean", false, {2}},
+        {"--follow", NULL, 1, "follow", false, {0}},
+        {"--loss", "loss", 1, "loss", true, {hal::channel.loss}},
+        {"--burst", "burst", 1, "burst", true, {hal::channel.burst}},
+        {"--burst-length", "burstlen", 1, "blen", true, {hal::channel.burstLength}},
+        {"--burst-loss", "burstloss", 1, "bloss", true, {hal::channel.burstLoss}},
+        {"--ack-loss", "ackloss", 1, "ackloss", true, {hal::channel.ackLoss}},
+        {"--latency", "latency", 1e3, "lat ms", true, {hal::channel.latencyMicros / 1e3}},
+        {"--jitter", "jitter", 1e3, "jit ms", true, {hal::channel.jitterMicros / 1e3}},
+        {"--off-every", "offevery", 1e6, "off ev", true, {hal::channel.offEveryMicros / 1e6}},
+        {"--off-for", "offfor", 1e6, "off s", true, {hal::channel.offMicros / 1e6}},
+    };
+    enum
+    {
+        PULL_MAX = 3,
+        GOAL = 4
+    };
+    int sessions = 4, jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    double hours = SWEEP_HOURS, loopMicros = SWEEP_LOOP_MICROS;
+    unsigned long seed = 1;
+    bool csv = false, channel = false;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *value = i + 1 < argc ? argv[i + 1] : "";
+        if (!strcmp(argv[i], "--csv"))
+        {
+            csv = true;
+            continue;
+        }
+        Parameter *parameter = NULL;
+        for (Parameter &candidate : parameters)
+        {
+            parameter = !strcmp(argv[i], candidate.option) ? &candidate : parameter;
+        }
+        if (parameter)
+        {
+            parameter->values = parseList(value);
+            channel |= parameter->channel;
+        }
+        else if (!strcmp(argv[i], "--sessions"))
+        {
+            sessions = atoi(value);
+        }
+        else if (!strcmp(argv[i], "--hours"))
+        {
+            hours = atof(value);
+        }
+        else if (!strcmp(argv[i], "--loop"))
+        {
+            loopMicros = atof(value);
+        }
+        else if (!strcmp(argv[i], "--jobs"))
+        {
+            jobs = atoi(value);
+        }
+        else if (!strcmp(argv[i], "--seed"))
+        {
+            seed = strtoul(value, NULL, 0);
+        }
+        else
+        {
+            fprintf(stderr, "sweep: unknown option %s\n", argv[i]);
+            return 2;
+        }
+        i++;
+    }
+    jobs = jobs < 1 ? 1 : jobs;
+
+    // every combination of the values, the last parameter changing fastest
+    std::vector<Combination> combinations;
+    std::vector<size_t> index(parameters.size(), 0);
+    for (bool done = false; !done;)
+    {
+        Combination combination;
+        for (size_t p = 0; p < parameters.size(); p++)
+        {
+            combination.values.push_back(parameters[p].values[index[p]]);
+        }
+        double pullMax = combination.values[PULL_MAX], goal = combination.values[GOAL];
+        if (goal < 1 || (int)pullMax % (int)goal) // the firmware refuses to start (setup())
+        {
+            fprintf(stderr, "sweep: skipped pull-max %g with goal %g (not divisible)\n", pullMax, goal);
+        }
+        else
+        {
+            combinations.push_back(combination);
+        }
+        size_t p = parameters.size();
+        while (p > 0 && ++index[p - 1] == parameters[p - 1].values.size())
+        {
+            index[--p] = 0;
+        }
+        done = p == 0;
+    }
+
+    // sessions in processes of their own, at most jobs at once, results read in the order they were started
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::deque<std::pair<FILE *, Outcome *>> running;
+    int failures = 0;
+    for (Combination &combination : combinations)
+    {
+        combination.outcomes.resize(sessions, Outcome(OUT_COUNT));
+    }
+    for (size_t next = 0, total = combinations.size() * sessions; next < total || !running.empty();)
+    {
+        if (next < total && running.size() < (size_t)jobs)
+        {
+            Combination &c = combinations[next / sessions];
+            std::string settings, arguments;
+            char text[64];
+            for (size_t p = 0; p < parameters.size(); p++)
+            {
+                snprintf(text, sizeof(text), parameters[p].setting ? "%s=%g " : "%s %g ",
+                         parameters[p].setting ? parameters[p].setting : parameters[p].option,
+                         c.values[p] * parameters[p].scale);
+                (parameters[p].setting ? settings : arguments) += text;
+            }
+            char command[1024];
+            snprintf(command, sizeof(command),
+                     "HAL_SETTINGS='%sloop=%g' '%s' sweep-session %s--hours %g --seed %lu", settings.c_str(),
+                     loopMicros, program, arguments.c_str(), hours, seed + next % sessions);
+            FILE *pipe = popen(command, "r");
+            if (!pipe)
+            {
+                perror("sweep");
+                return 1;
+            }
+            running.push_back(std::make_pair(pipe, &c.outcomes[next % sessions]));
+            next++;
+            continue;
+        }
+        Outcome &outcome = *running.front().second;
+        int fields = 0;
+        while (fields < OUT_COUNT && fscanf(running.front().first, "%lf", &outcome[fields]) == 1)
+        {
+            fields++;
+        }
+        failures += pclose(running.front().first) != 0 || fields != OUT_COUNT;
+        running.pop_front();
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    for (const Parameter &parameter : parameters)
+    {
+        if (csv)
+        {
+            std::string name = parameter.option + 2;
+            std::replace(name.begin(), name.end(), '-', '_');
+            printf("%s,", name.c_str());
+        }
+        else if (!parameter.channel || channel)
+        {
+            printf("%*s ", (int)max(strlen(parameter.column), (size_t)5), parameter.column);
+        }
+    }
+    printf(csv ? "rewards_h,rewards_h_sd,synch_missed_pct,slave_missed_h,duplicated_h,locked_pct,window_timeouts_h,"
+                 "long_timeouts_h,frames_min,air_pct,lost_min,acks_lost_min,duplicates_min,reordered_min,"
+                 "collisions_min\n"
+               : "| rewards/h (sd)    synch missed %% slave missed/h dup/h locked %% timeouts/h  long/h frames/min  "
+                 "air %%\n");
+    for (const Combination &c : combinations)
+    {
+        for (size_t p = 0; p < parameters.size(); p++)
+        {
+            if (csv)
+            {
+                printf("%g,", c.values[p]);
+            }
+            else if (!parameters[p].channel || channel)
+            {
+                printf("%*g ", (int)max(strlen(parameters[p].column), (size_t)5), c.values[p]);
+            }
+        }
+        std::vector<double> rewards, missed, slaveMissed, duplicated, locked, windowTimeouts, longTimeouts, frames, air,
+            lost, acksLost, duplicates, reordered, collisions;
+        for (const Outcome &outcome : c.outcomes)
+        {
+            double duration = outcome[OUT_DURATION_MICROS];
+            double perHour = duration ? 3600e6 / duration : 0;
+            rewards.push_back(outcome[OUT_MASTER_REWARDS] * perHour);
+            missed.push_back(outcome[OUT_SYNCH_PULLS] ? 100 * outcome[OUT_SYNCH_MISSED] / outcome[OUT_SYNCH_PULLS] : 0);
+            slaveMissed.push_back(outcome[OUT_SLAVE_MISSED] * perHour);
+            duplicated.push_back(outcome[OUT_DUPLICATED] * perHour);
+            locked.push_back(duration ? 100 * outcome[OUT_LOCKED_MICROS] / duration : 0);
+            windowTimeouts.push_back(outcome[OUT_WINDOW_TIMEOUTS] * perHour);
+            longTimeouts.push_back(outcome[OUT_LONG_TIMEOUTS] * perHour);
+            frames.push_back(outcome[OUT_PACKETS] * perHour / 60);
+            air.push_back(duration ? 100 * outcome[OUT_AIR_MICROS] / duration : 0);
+            lost.push_back(outcome[OUT_LOST] * perHour / 60);
+            acksLost.push_back(outcome[OUT_ACKS_LOST] * perHour / 60);
+            duplicates.push_back(outcome[OUT_DUPLICATES] * perHour / 60);
+            reordered.push_back(outcome[OUT_REORDERED] * perHour / 60);
+            collisions.push_back(outcome[OUT_COLLISIONS] * perHour / 60);
+        }
+        if (csv)
+        {
+            printf("%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.1f,%.3f,%.2f,%.2f,%.2f,%.2f,%.2f\n", mean(rewards),
+                   deviation(rewards), mean(missed), mean(slaveMissed), mean(duplicated), mean(locked),
+                   mean(windowTimeouts), mean(longTimeouts), mean(frames), mean(air), mean(lost), mean(acksLost),
+                   mean(duplicates), mean(reordered), mean(collisions));
+            continue;
+        }
+        printf("| %9.2f (%6.2f) %14.2f %14.2f %5.2f %8.2f %10.2f %7.2f %10.1f %6.3f\n", mean(rewards),
+               deviation(rewards), mean(missed), mean(slaveMissed), mean(duplicated), mean(locked),
+               mean(windowTimeouts), mean(longTimeouts), mean(frames), mean(air));
+    }
+    fflush(stdout);
+    double simulated = combinations.size() * sessions * hours * 3600;
+    fprintf(stderr, "%zu sessions of %g h in %.1f s (%d jobs, %.0fx real time), %d failed\n",
+            combinations.size() * sessions, hours, elapsed, jobs, elapsed > 0 ? simulated / elapsed : 0, failures);
+    return failures ? 1 : 0;
+}
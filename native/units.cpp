@@ -0,0 +1,551 @@
+/* Unit checks (native HAL)
+ *  - Single classes of the firmware driven on their own with made-up inputs, where a whole session can't reach the
+ *    corner cases: the lever edge ring (include/LeverEvents.h) and the lever debouncer (include/Apparatus.h), which is
+ *    measured against the sampling debouncer it replaced on the same bounce traces, the frame air time and the
+ *    sequence numbers of the radio frames (include/Frame.h), the loop profiler on stalled loops
+ *    (include/LoopProfiler.h) and the clock offset and drift estimate on simulated ping/pong round trips
+ *    (include/ClockSync.h)
+ *  - They use the code of the training box (native/box_training.cpp): its headers are included into its namespace
+ *    here, the box is current but never started, so no setup() or loop() runs in between
+ *  - Part of the scenario list of session.cpp: program lever-ring | debounce | frames | profiler | clock-sync
+ */
+
+#include <algorithm>
+
+#include "box_headers.h"
+
+#include "settings.h"
+#undef RADIO_ROLE
+#define RADIO_ROLE RADIO_TRAINING
+#include "box_settings.h"
+
+#include "Session.h"
+
+namespace training
+{
+#include "Apparatus.h"
+#include "ClockSync.h"
+#include "Frame.h"
+#include "LeverEvents.h"
+#include "LoopProfiler.h"
+void PCINT2_vect(); // LeverEvents.cpp
+}
+
+#define UNITS_RING_EDGES 20000   // edges through the ring with the consumer popping at random points
+#define UNITS_EDGE_MICROS 7      // between two edges of a burst (faster than a bouncing switch)
+#define UNITS_PRESSES 300        // presses per bounce trace
+#define UNITS_BOUNCES 6          // most bounces after one transition
+#define UNITS_PINGS 1200         // ping/pong round trips per clock case (one per CLOCK_SYNC_INTERVAL_MICROS)
+#define UNITS_SETTLE_PINGS 60    // round trips before the estimate is checked
+
+// LEVER EDGE RING ================================================================
+
+// one lever edge: the pin changes, then the pin-change ISR of the firmware runs (the box isn't running, so the HAL
+// doesn't dispatch it itself)
+static void leverEdge(hal::Box *box, uint8_t pin, uint8_t level)
+{
+    box->setPin(pin, level);
+    training::PCINT2_vect();
+    box->spend(UNITS_EDGE_MICROS);
+}
+
+// pops everything queued, false if an edge is missing, out of order or has the wrong snapshot
+static bool drain(std::deque<training::LeverEvent> &expected, int *popped)
+{
+    bool inOrder = true;
+    training::LeverEvent event;
+    while (training::leverEvents.pop(&event))
+    {
+        (*popped)++;
+        inOrder &= !expected.empty() && event.time == expected.front().time && event.pins == expected.front().pins;
+        if (!expected.empty())
+        {
+            expected.pop_front();
+        }
+    }
+    return inOrder && expected.empty();
+}
+
+void leverRing()
+{
+    hal::Box *box = hal::find("training");
+    hal::Scope scope(box);
+    rest(box);
+    training::leverEvents.init();
+    const uint8_t pins[2] = {LEVER_UP_PIN, LEVER_DOWN_PIN};
+    const int capacity = LEVER_EVENT_QUEUE_LEN - 1; // one slot stays free to tell full from empty
+
+    // bursts of every length between two loop() calls: up to the capacity nothing is lost, beyond it the newest
+    // edges are dropped and counted, the queued ones keep their order
+    bool burstsKept = true, overflowCounted = true;
+    for (int length = 1; length <= capacity + 5; length++)
+    {
+        std::deque<training::LeverEvent> expected;
+        uint8_t droppedBefore = training::leverEvents.dropped;
+        for (int i = 0; i < length; i++)
+        {
+            uint8_t pin = pins[hal::random() & 1];
+            uint32_t time = box->micros();
+            leverEdge(box, pin, !box->level[pin]);
+            if (i < capacity)
+            {
+                expected.push_back({time, (uint8_t)(box->port(0) & LEVER_EVENT_PIN_MASK)});
+            }
+        }
+        int popped = 0;
+        bool kept = drain(expected, &popped);
+        uint8_t dropped = training::leverEvents.dropped - droppedBefore;
+        if (length <= capacity)
+        {
+            burstsKept &= kept && dropped == 0;
+        }
+        else
+        {
+            overflowCounted &= kept && dropped == length - capacity;
+        }
+    }
+    check(burstsKept, "bursts up to the ring size arrive complete and in order");
+    check(overflowCounted, "longer bursts drop only the newest edges and count them");
+
+    // the consumer pops at random points while the ring never runs full: head and tail wrap around many times
+    std::deque<training::LeverEvent> expected;
+    uint8_t droppedBefore = training::leverEvents.dropped;
+    bool inOrder = true;
+    int pushed = 0, popped = 0;
+    while (pushed < UNITS_RING_EDGES)
+    {
+        int burst = hal::random() % (capacity - (int)expected.size() + 1);
+        for (int i = 0; i < burst && pushed < UNITS_RING_EDGES; i++, pushed++)
+        {
+            uint8_t pin = pins[hal::random() & 1];
+            uint32_t time = box->micros();
+            leverEdge(box, pin, !box->level[pin]);
+            expected.push_back({time, (uint8_t)(box->port(0) & LEVER_EVENT_PIN_MASK)});
+        }
+        int take = hal::random() % (expected.size() + 1);
+        training::LeverEvent event;
+        for (int i = 0; i < take && training::leverEvents.pop(&event); i++, popped++)
+        {
+            inOrder &= event.time == expected.front().time && event.pins == expected.front().pins;
+            expected.pop_front();
+        }
+    }
+    inOrder &= drain(expected, &popped);
+    printf("  %d edges pushed, %d popped\n", pushed, popped);
+    check(inOrder && popped == pushed && training::leverEvents.dropped == droppedBefore,
+          "interleaved edges arrive complete and in order across the ring wraparound");
+}
+
+// LEVER DEBOUNCER ================================================================
+
+// switch signal: the transitions the animal made and the raw pin levels with bounces and glitches on top
+struct BounceTrace
+{
+    const char *name;
+    uint64_t settleMicros;                 // bounces end this long after a transition
+    uint64_t pressMin, pressMax;           // lever held down
+    uint64_t releaseMin, releaseMax;       // lever back up until the next press
+    uint64_t glitchMicros;                 // mean time between two glitches (short spikes while steady), 0 = none
+    std::vector<std::pair<uint64_t, uint8_t>> truth; // transitions (time, level)
+    std::vector<std::pair<uint64_t, uint8_t>> raw;   // pin edges
+
+    uint8_t levelAt(uint64_t time, size_t *next) const // raw level, next walks along raw with time
+    {
+        while (*next < this->raw.size() && this->raw[*next].first <= time)
+        {
+            (*next)++;
+        }
+        return *next ? this->raw[*next - 1].second : 0;
+    }
+};
+
+static uint64_t between(uint64_t low, uint64_t high)
+{
+    return low + (high > low ? hal::random() % (high - low + 1) : 0);
+}
+
+static void makeTrace(BounceTrace &trace)
+{
+    uint64_t time = 1000000;
+    uint8_t level = 0;
+    for (int press = 0; press < 2 * UNITS_PRESSES; press++)
+    {
+        level = !level;
+        trace.truth.push_back(std::make_pair(time, level));
+        trace.raw.push_back(std::make_pair(time, level));
+        std::vector<uint64_t> bounces;
+        for (uint32_t i = 2 * (hal::random() % (UNITS_BOUNCES + 1)); i && trace.settleMicros; i--)
+        {
+            bounces.push_back(time + between(1, trace.settleMicros));
+        }
+        std::sort(bounces.begin(), bounces.end());
+        for (size_t i = 0; i < bounces.size(); i++)
+        {
+            trace.raw.push_back(std::make_pair(bounces[i], i % 2 ? level : !level));
+        }
+        uint64_t next = time + (level ? between(trace.pressMin, trace.pressMax) : between(trace.releaseMin, trace.releaseMax));
+        for (uint64_t glitch = time + trace.settleMicros; trace.glitchMicros;)
+        {
+            glitch += 100 + hal::exponential(trace.glitchMicros);
+            uint64_t width = between(10, 100);
+            if (glitch + width + 100 > next)
+            {
+                break;
+            }
+            trace.raw.push_back(std::make_pair(glitch, !level));
+            trace.raw.push_back(std::make_pair(glitch + width, level));
+        }
+        time = next;
+    }
+}
+
+// what a debouncer reported: loop time, new state, edge time it gave
+struct Report
+{
+    uint64_t loopTime;
+    uint8_t state;
+    uint64_t edgeTime;
+};
+
+// the debouncer of the firmware, fed like Apparatus::update(): the ISR edges of the loop first, then the loop sample
+// (micros() starts near its wraparound, every comparison of the debouncer must be wrap-safe)
+static std::vector<Report> edgeFirst(const BounceTrace &trace, uint64_t loopMicros)
+{
+    const uint32_t base = 0xFFF00000;
+    std::vector<Report> reports;
+    training::LeverDebouncer debouncer;
+    size_t edge = 0, sampled = 0;
+    for (uint64_t time = 0; time < trace.raw.back().first + 2 * LEVER_DEBOUNCING_MICROS; time += loopMicros)
+    {
+        bool changed = false;
+        for (; edge < trace.raw.size() && trace.raw[edge].first <= time; edge++)
+        {
+            changed |= debouncer.update(trace.raw[edge].second, base + (uint32_t)trace.raw[edge].first);
+        }
+        changed |= debouncer.update(trace.levelAt(time, &sampled), base + (uint32_t)time);
+        if (changed && (reports.empty() ? debouncer.state != 0 : debouncer.state != reports.back().state))
+        {
+            reports.push_back({time, debouncer.state, (uint32_t)(debouncer.edgeTime - base)});
+        }
+    }
+    return reports;
+}
+
+// the debouncer Apparatus::update() had before: the pin is sampled once per LEVER_DEBOUNCING_MICROS window, the
+// first ISR edge towards the new state gives the edge time
+static std::vector<Report> sampling(const BounceTrace &trace, uint64_t loopMicros)
+{
+    std::vector<Report> reports;
+    uint8_t state = 0, pending = false;
+    uint64_t pendingTime = 0, windowEnd = 0;
+    size_t edge = 0, sampled = 0;
+    for (uint64_t time = 0; time < trace.raw.back().first + 2 * LEVER_DEBOUNCING_MICROS; time += loopMicros)
+    {
+        for (; edge < trace.raw.size() && trace.raw[edge].first <= time; edge++)
+        {
+            if (trace.raw[edge].second == state)
+            {
+                pending = false;
+            }
+            else if (!pending)
+            {
+                pending = true;
+                pendingTime = trace.raw[edge].first;
+            }
+        }
+        if (!windowEnd || time > windowEnd)
+        {
+            windowEnd = time + LEVER_DEBOUNCING_MICROS;
+            uint8_t level = trace.levelAt(time, &sampled);
+            if (level != state)
+            {
+                state = level;
+                reports.push_back({time, state, pending ? pendingTime : time});
+                pending = false;
+            }
+        }
+    }
+    return reports;
+}
+
+// reports against the transitions: a report of the state the lever is in counts for the last transition (its
+// first one), every other report is a false edge, a transition without a report is missed
+struct Score
+{
+    int falseEdges = 0;
+    int missed = 0;
+    double latencySum = 0; // report (loop) after the transition
+    uint64_t latencyMax = 0;
+    uint64_t timeErrorMax = 0; // edge time reported against the transition
+};
+
+static Score score(const BounceTrace &trace, const std::vector<Report> &reports)
+{
+    Score result;
+    std::vector<bool> hit(trace.truth.size(), false);
+    size_t transition = 0;
+    for (const Report &report : reports)
+    {
+        while (transition + 1 < trace.truth.size() && trace.truth[transition + 1].first <= report.loopTime)
+        {
+            transition++;
+        }
+        if (report.state != trace.truth[transition].second || hit[transition])
+        {
+            result.falseEdges++;
+            continue;
+        }
+        hit[transition] = true;
+        uint64_t latency = report.loopTime - trace.truth[transition].first;
+        uint64_t error = report.edgeTime > trace.truth[transition].first ? report.edgeTime - trace.truth[transition].first
+                                                                          : trace.truth[transition].first - report.edgeTime;
+        result.latencySum += latency;
+        result.latencyMax = max(result.latencyMax, latency);
+        result.timeErrorMax = max(result.timeErrorMax, error);
+    }
+    for (bool reported : hit)
+    {
+        result.missed += !reported;
+    }
+    return result;
+}
+
+static void printScore(const char *trace, const char *debouncer, uint64_t loopMicros, const Score &score, int transitions)
+{
+    int hits = transitions - score.missed;
+    printf("  %-16s %5.2f  %-10s %6d %5d %6d %8.2f %8.2f %8.2f\n", trace, loopMicros / 1e3, debouncer, transitions,
+           score.falseEdges, score.missed, hits ? score.latencySum / hits / 1e3 : 0, score.latencyMax / 1e3,
+           score.timeErrorMax / 1e3);
+}
+
+void debounce()
+{
+    BounceTrace traces[] = {
+        {"bounce 1 ms", 1000, 150000, 600000, 150000, 1000000, 0, {}, {}},
+        {"bounce 5 ms", 5000, 150000, 600000, 150000, 1000000, 0, {}, {}},
+        {"bounce 30 ms", 30000, 150000, 600000, 150000, 1000000, 0, {}, {}},
+        {"taps 20-90 ms", 2000, 20000, 90000, 150000, 1000000, 0, {}, {}},
+        {"glitches 1/s", 2000, 150000, 600000, 150000, 1000000, 1000000, {}, {}},
+    };
+    const uint64_t loops[] = {HAL_LOOP_MICROS, 10000};
+    printf("  hold-off %.0f ms, %d presses per trace, times in ms\n", LEVER_DEBOUNCING_MICROS / 1e3, UNITS_PRESSES);
+    printf("  %-16s %5s  %-10s %6s %5s %6s %8s %8s %8s\n", "trace", "loop", "debouncer", "edges", "false", "missed",
+           "latency", "max", "time err");
+    bool bounceClean = true, tapsKept = true, faster = true;
+    for (BounceTrace &trace : traces)
+    {
+        makeTrace(trace);
+        for (uint64_t loopMicros : loops)
+        {
+            Score first = score(trace, edgeFirst(trace, loopMicros));
+            Score sampled = score(trace, sampling(trace, loopMicros));
+            int transitions = trace.truth.size();
+            printScore(trace.name, "edge-first", loopMicros, first, transitions);
+            printScore("", "sampling", loopMicros, sampled, transitions);
+            if (!trace.glitchMicros && trace.pressMin >= LEVER_DEBOUNCING_MICROS)
+            {
+                bounceClean &= !first.falseEdges && !first.missed && first.latencyMax <= loopMicros && !first.timeErrorMax;
+                faster &= first.latencySum < sampled.latencySum;
+            }
+            else if (!trace.glitchMicros)
+            {
+                tapsKept &= !first.falseEdges && !first.missed;
+            }
+        }
+    }
+    check(bounceClean, "bounces shorter than the hold-off: no false or missed edge, reported within one loop, exact edge time");
+    check(faster, "the edge-first debouncer reports sooner than the sampling one");
+    check(tapsKept, "taps shorter than the hold-off are still reported (the release after the hold-off)");
+}
+
+// RADIO FRAMES ===================================================================
+
+// frames of one sender through a fresh tracker: seq and time of each, true if the acceptances were as expected
+struct SeqStep
+{
+    uint8_t seq;
+    uint32_t time;
+    bool accepted;
+};
+
+static bool feed(training::SeqTracker &tracker, const std::vector<SeqStep> &steps)
+{
+    bool asExpected = true;
+    for (const SeqStep &step : steps)
+    {
+        asExpected &= tracker.accept(step.seq, step.time) == step.accepted;
+    }
+    return asExpected;
+}
+
+void frames()
+{
+    // air time: every frame type encodes to its fixed length, one attempt is 8 bits per byte of preamble, address,
+    // payload and CRC plus the 9 bit control field, 4 us each
+    bool airTime = true;
+    for (uint8_t type = 0; type < training::FRAME_TYPE_COUNT; type++)
+    {
+        training::Frame frame, decoded;
+        frame.type = type;
+        uint8_t buf[FRAME_MAX_LEN];
+        uint8_t len = training::frameEncode(&frame, buf);
+        airTime &= len >= FRAME_HEADER_LEN && len <= FRAME_MAX_LEN && (len - FRAME_HEADER_LEN) % 4 == 0;
+        airTime &= training::frameDecode(buf, len, &decoded) && decoded.type == type;
+        airTime &= training::frameAirMicros(len) == (8 * (1 + 5 + len + 2) + 9) * 4;
+    }
+    airTime &= training::frameAirMicros(FRAME_HEADER_LEN) == 420 && training::frameAirMicros(FRAME_MAX_LEN) == 804;
+    printf("  air time %u-%u us\n", training::frameAirMicros(FRAME_HEADER_LEN), training::frameAirMicros(FRAME_MAX_LEN));
+    check(airTime, "frame air time of every type at 250 kbps");
+
+    const uint32_t ms = 1000, window = FRAME_DUPLICATE_MICROS;
+
+    // the sequence wraps from 255 to 0 without a gap, a gap across the wrap counts the frames in between
+    training::SeqTracker wrap;
+    bool wrapped = feed(wrap, {{253, 0, true}, {254, 10 * ms, true}, {255, 20 * ms, true}, {0, 30 * ms, true},
+                               {1, 40 * ms, true}, {5, 50 * ms, true}});
+    check(wrapped && wrap.received == 6 && wrap.missed == 3 && wrap.duplicates == 0,
+          "sequence wraparound: 255 -> 0 is no gap, 1 -> 5 misses three");
+
+    // a repeated seq is a duplicate within FRAME_DUPLICATE_MICROS of the frame it repeats, after that the sender has
+    // restarted (also across the micros() wraparound)
+    training::SeqTracker repeat;
+    bool repeated = feed(repeat, {{7, 0xFFFFFFFF - 5 * ms, true}, {7, 0xFFFFFFFF - 4 * ms, false}, {7, 10 * ms, false},
+                                  {7, 0xFFFFFFFF - 5 * ms + window - 1, false}, {7, 0xFFFFFFFF - 5 * ms + window, true}});
+    check(repeated && repeat.duplicates == 3 && repeat.received == 2 && repeat.missed == 0,
+          "duplicates inside FRAME_DUPLICATE_MICROS dropped, a repeat after it accepted without a gap");
+
+    // a frame repeated after newer ones (the master repeats an ACK payload after a ping) is still a duplicate while
+    // it is one of the last FRAME_SEQ_WINDOW, older ones mean a restarted sender
+    training::SeqTracker resent;
+    bool windowed = feed(resent, {{10, 0, true}, {11, ms, true}, {10, 2 * ms, false}, {12, 3 * ms, true},
+                                  {13, 4 * ms, true}, {14, 5 * ms, true}, {10, 6 * ms, true}});
+    check(windowed && resent.duplicates == 1 && resent.missed == 0,
+          "a repeat after newer frames dropped within the last FRAME_SEQ_WINDOW sequence numbers");
+
+    // gaps: up to 127 frames are missed ones, from 128 on (or an older seq) the sender has restarted
+    training::SeqTracker gaps;
+    bool gapped = feed(gaps, {{0, 0, true}, {128, 10 * ms, true}, {1, 20 * ms, true}, {130, 30 * ms, true},
+                              {125, 40 * ms, true}, {126, 50 * ms, true}});
+    check(gapped && gaps.missed == 127 && gaps.received == 6, "gaps below 128 counted as missed, 128 and more not");
+
+    // a reopened link starts a new sequence: the same seq is accepted again, the counters stay
+    training::SeqTracker reopened;
+    bool restarted = feed(reopened, {{42, 0, true}, {42, ms, false}});
+    reopened.restart();
+    restarted &= feed(reopened, {{42, 2 * ms, true}, {44, 3 * ms, true}});
+    check(restarted && reopened.received == 3 && reopened.duplicates == 1 && reopened.missed == 1,
+          "restart() accepts the same seq again and keeps the counters");
+}
+
+// LOOP PROFILER ==================================================================
+
+void profiler()
+{
+    hal::Box *box = hal::find("training");
+    hal::Scope scope(box);
+    box->clockOffset = 0xFFFFFFFF - 100000; // the stalls run across the micros() wraparound
+    training::LoopProfiler profiler;
+
+    // a radio phase of 300 ms and a lever phase of 5 s between fast loops, far beyond the 16 bit ticks (262 ms)
+    const hal::Time durations[][LOOP_PROFILE_PHASES] = {{0, 0, 300000, 0}, {0, 0, 0, 100}, {5000000, 0, 0, 0}};
+    for (const hal::Time *loop : durations)
+    {
+        profiler.start();
+        for (uint8_t phase = 0; phase < LOOP_PROFILE_PHASES; phase++)
+        {
+            box->spend(loop[phase]);
+            profiler.mark((training::loop_phase)phase);
+        }
+    }
+    profiler.start();
+    Serial.begin(EVENT_LOG_BAUD); // the box isn't started, print() needs the port open
+    profiler.print();
+
+    check(recorder.printed(box, "lever=0-5000000:") && recorder.printed(box, "radio=0-300000:") &&
+              recorder.printed(box, "loop=100-5000000:0/0/0/0/0/1/0/0/0/0/0/2"),
+          "phases and loops longer than 262 ms measured in full");
+    check(recorder.printed(box, ":5000000/0/0/0/5000000"), "the 5 s loop is the slowest one");
+}
+
+// CLOCK SYNC =====================================================================
+
+// two clocks on true time: the master (local) starts near its micros() wraparound, the slave (remote) is offset by
+// offset and runs ppm faster; the one-way delays (forward master -> slave, back slave -> master) differ, each has an
+// exponential jitter, and a round trip is sometimes held up by retransmissions
+struct ClockCase
+{
+    const char *name;
+    uint32_t offset; // remote - local at time 0
+    double ppm;
+    uint64_t forwardMicros, backMicros;
+};
+
+static uint32_t localClock(uint64_t time)
+{
+    return 0xFFF00000 + (uint32_t)time;
+}
+
+static uint32_t remoteClock(const ClockCase &clock, uint64_t time)
+{
+    return localClock(time) + clock.offset + (uint32_t)(int64_t)(time * clock.ppm / 1e6);
+}
+
+static uint64_t oneWay(uint64_t micros)
+{
+    uint64_t delay = micros + hal::exponential(100);
+    if (hal::chance(0.1))
+    {
+        delay += (1 + hal::random() % 3) * 4500; // retries of the frame (retry delay 15 plus air time)
+    }
+    return delay;
+}
+
+void clockSync()
+{
+    const ClockCase cases[] = {
+        {"symmetric", 0x12345678, 50, 800, 800},
+        {"asymmetric", 0x12345678, -3000, 1800, 600},
+        {"near +2^31", 0x80000000 - 300000, 1000, 1800, 600}, // crosses 2^31 after 5 minutes
+        {"near -2^31", 0x80000000 + 300000, -1000, 600, 1800},
+    };
+    printf("  %-12s %8s %6s %10s %10s %9s %9s\n", "clocks", "drift", "asym", "offset err", "max err", "drift est",
+           "drift err");
+    bool offsetKept = true, driftKept = true;
+    for (const ClockCase &clock : cases)
+    {
+        training::ClockSync sync;
+        double errorSum = 0, driftSum = 0;
+        int32_t errorMax = 0;
+        int checked = 0;
+        for (int ping = 0; ping < UNITS_PINGS; ping++)
+        {
+            uint64_t t1 = (ping + 1) * (uint64_t)CLOCK_SYNC_INTERVAL_MICROS;
+            uint64_t t2 = t1 + oneWay(clock.forwardMicros);
+            uint64_t t3 = t2 + 200 + hal::random() % 600; // slave loop until the pong is queued
+            uint64_t t4 = t3 + oneWay(clock.backMicros);
+            sync.addSample(localClock(t1), remoteClock(clock, t2), remoteClock(clock, t3), localClock(t4));
+            if (ping < UNITS_SETTLE_PINGS)
+            {
+                continue;
+            }
+
+            // a slave pull half way to the next ping, mapped onto the master clock: off by half the asymmetry
+            uint64_t pull = t1 + CLOCK_SYNC_INTERVAL_MICROS / 2;
+            int32_t error = (int32_t)(sync.toLocal(remoteClock(clock, pull)) - localClock(pull));
+            int32_t expected = -(int32_t)((int64_t)clock.forwardMicros - (int64_t)clock.backMicros) / 2;
+            errorSum += error - expected;
+            errorMax = max(errorMax, abs(error - expected));
+            driftSum += sync.drift * 1e6;
+            checked++;
+        }
+        double driftMean = driftSum / checked;
+        printf("  %-12s %8.0f %6d %10.0f %10d %9.1f %9.1f\n", clock.name, clock.ppm,
+               (int)((int64_t)clock.forwardMicros - (int64_t)clock.backMicros), errorSum / checked, errorMax, driftMean,
+               driftMean - clock.ppm);
+        offsetKept &= fabs(errorSum / checked) < 50 && errorMax < 500;
+        driftKept &= fabs(driftMean - clock.ppm) < 5;
+    }
+    printf("  offset err: slave time mapped onto the master clock minus the true time, beyond half the asymmetry (us)\n");
+    check(offsetKept, "offset within 50 us on average, 500 us at most, beyond half the delay asymmetry");
+    check(driftKept, "drift within 5 ppm on average, also across 2^31");
+}
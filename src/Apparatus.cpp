@@ -1,20 +1,22 @@
 /* Apparatus Class
  *  - Sets up lever, leverblock motor and reward deployer motor
- *  - update() checks if lever is up, down or neither
+ *  - update() checks if lever is up, down or neither (edge-first debouncing, edge times come from the LeverEvents ISR queue)
  *  - deployFood() activates reward deployer motor for the duration it takes to release one compartment worth of reward
  *    (and, if specified (deployFood(amount)), the number of compartments to be released)
  *  - openLever(bool) activates the leverblock motor to block (false) or unblock (true) the lever
  */
 
 #include "Apparatus.h"
+#include "EventLog.h"
+#include "LeverEvents.h"
+#include "Messages.h"
+#include "Trace.h"
 #include "settings.h"
 
 #include "printf.h"
 #include <SPI.h>
 #include <RF24.h>
 
-char apr_buffer[50];
-
 Apparatus::Apparatus()
 {
     // IO setup
@@ -25,8 +27,8 @@ Apparatus::Apparatus()
 
     pinMode(LED_BUILTIN, OUTPUT); // LED
 
-    this->leverUpDebouncingTime = 0;
-    this->leverDownDebouncingTime = 0;
+    this->leverUpTime = 0;
+    this->leverDownTime = 0;
 
     this->deployEndTime = 0;
     this->leverLockTimeoutTime = 0;
@@ -36,58 +38,119 @@ Apparatus::Apparatus()
 
     // this->deployer.attach(DEPLOYER_PIN, 0, 5000);
     this->deployCounter = 0;
+
+    leverEvents.init();
 }
 
-// check if remote was enabled and if lever is up, down or neither
-uint8_t Apparatus::update()
+// returns true if the debounced state changed with this input
+uint8_t LeverDebouncer::update(uint8_t level, uint32_t time)
 {
-    // # get current loop time
-    unsigned long time = micros();
+    // ignore the input during the hold-off after an accepted edge (bounce), but keep when it last left the state
+    if (this->holding && (uint32_t)(time - this->edgeTime) < LEVER_DEBOUNCING_MICROS)
+    {
+        if (level == this->state)
+        {
+            this->changed = false;
+        }
+        else if (!this->changed)
+        {
+            this->changed = true;
+            this->changeTime = time;
+        }
+        return false;
+    }
+    this->holding = false;
 
-    // # get IO states
+    if (level == this->state)
+    {
+        this->changed = false;
+        return false;
+    }
 
+    this->state = level;
+    this->edgeTime = this->changed ? this->changeTime : time;
+    this->changed = false;
+    this->holding = true;
+    return true;
+}
+
+// feed one port D snapshot to both lever debouncers, print (or log) only when status changes
+void Apparatus::updateLevers(uint8_t pins, uint32_t time)
+{
     // ## leverUp
-    uint8_t leverUp = this->debouncedLeverUp;
-    if (!this->leverUpDebouncingTime || time > this->leverUpDebouncingTime)
+    if (this->leverUpDebouncer.update(((pins & _BV(LEVER_UP_PIN)) ? HIGH : LOW) == LEVER_UP_STATE, time))
     {
-        this->leverUpDebouncingTime = time + LEVER_DEBOUNCING_MICROS;
-        leverUp = digitalRead(LEVER_UP_PIN) == LEVER_UP_STATE;
-
-        // ### detect rising/falling edge, print only when status changes
-        if (this->debouncedLeverUp != leverUp)
+        this->debouncedLeverUp = this->leverUpDebouncer.state;
+        this->leverUpTime = this->leverUpDebouncer.edgeTime;
+        if (EVENT_LOG_ENABLED)
+        {
+            eventLog.log(EVENT_LEVER_UP, this->debouncedLeverUp, this->leverUpTime);
+        }
+        else
         {
-            this->debouncedLeverUp = leverUp;
-            sprintf(apr_buffer, "leverUp: %u\n", leverUp);
-            Serial.print(apr_buffer);
+            Serial.print(message(MSG_LEVER_UP));
+            Serial.println(this->debouncedLeverUp);
         }
     }
 
     // ## leverDown
-    uint8_t leverDown = this->debouncedLeverDown;
-    if (!this->leverDownDebouncingTime || time > this->leverDownDebouncingTime)
+    if (this->leverDownDebouncer.update(((pins & _BV(LEVER_DOWN_PIN)) ? HIGH : LOW) == LEVER_DOWN_STATE, time))
     {
-        this->leverDownDebouncingTime = time + LEVER_DEBOUNCING_MICROS;
-        leverDown = digitalRead(LEVER_DOWN_PIN) == LEVER_DOWN_STATE;
+        this->debouncedLeverDown = this->leverDownDebouncer.state;
+        this->leverDownTime = this->leverDownDebouncer.edgeTime;
+        if (EVENT_LOG_ENABLED)
+        {
+            eventLog.log(EVENT_LEVER_DOWN, this->debouncedLeverDown, this->leverDownTime);
+        }
+        else
+        {
+            Serial.print(message(MSG_LEVER_DOWN));
+            Serial.println(this->debouncedLeverDown);
+        }
+    }
+}
 
-        // ### detect rising/falling edge, print only when status changes
-        if (this->debouncedLeverDown != leverDown)
+// check if remote was enabled and if lever is up, down or neither
+uint8_t Apparatus::update()
+{
+    // # get current loop time and all lever inputs with one port read (taken together so they match)
+    uint32_t time;
+    uint8_t pins;
+    noInterrupts();
+    time = micros();
+    pins = PIND;
+    interrupts();
+
+    // # get IO states
+    // edges captured by the ISR come first (exact edge times), the loop sample afterwards catches
+    // the state after a hold-off and anything the queue dropped
+    LeverEvent event;
+    uint8_t sampleIsNewest = true;
+    while (leverEvents.pop(&event))
+    {
+        trace.lever(event.time, event.pins);
+        this->updateLevers(event.pins, event.time);
+        if ((int32_t)(event.time - time) > 0)
         {
-            this->debouncedLeverDown = leverDown;
-            sprintf(apr_buffer, "leverDown: %u\n", leverDown);
-            Serial.print(apr_buffer);
+            sampleIsNewest = false; // edge arrived after the sample, its snapshot is more recent
         }
     }
+    if (sampleIsNewest)
+    {
+        this->updateLevers(pins, time);
+    }
 
     // # handle timeouts
 
     // ## deactivate deployment motor
-    if (time > this->deployEndTime)
+    if (this->deployEndTime && (int32_t)(time - this->deployEndTime) > 0) // wrap-safe, like the debouncer
     {
+        this->deployEndTime = 0;
         analogWrite(DEPLOYER_PIN, 0); /* Produce 0% duty cycle PWM on D3 */
     }
 
     // ## deactivate lever lock motor
-    if (this->leverLockTimeoutTime && time > this->leverLockTimeoutTime)
+    if (this->leverLockTimeoutTime && (int32_t)(time - this->leverLockTimeoutTime) > 0)
     {
         this->leverLockTimeoutTime = 0;
         this->leverLock.detach();
@@ -112,8 +175,15 @@ uint8_t Apparatus::deployFood(int amount)
     this->deployEndTime = micros() + DEPLOYER_DURATION_MICROS * amount;
 
     this->deployCounter += amount;
-    sprintf(apr_buffer, "deployCounter: %u\n", this->deployCounter);
-    Serial.print(apr_buffer);
+    if (EVENT_LOG_ENABLED)
+    {
+        eventLog.log(EVENT_DEPLOY, this->deployCounter);
+    }
+    else
+    {
+        Serial.print(message(MSG_DEPLOY_COUNTER));
+        Serial.println(this->deployCounter);
+    }
 
     return true;
 }
@@ -0,0 +1,134 @@
+/* ChannelSurvey Class
+ *  - Ties in the ranking go to the higher channel (above channel 72 no WiFi channel 1-13 is centered)
+ */
+
+#include "ChannelSurvey.h"
+#include "settings.h"
+
+void ChannelSurvey::scan()
+{
+    static_assert(SURVEY_PASSES <= 15, "SURVEY_PASSES must fit into 4 bits");
+    memset(this->counts, 0, sizeof(this->counts));
+
+    for (uint8_t pass = 0; pass < SURVEY_PASSES; pass++)
+    {
+        for (uint8_t channel = 0; channel < SURVEY_CHANNELS; channel++)
+        {
+            this->radio.setChannel(channel);
+            this->radio.startListening();
+            delayMicroseconds(SURVEY_DWELL_MICROS);
+            bool carrier = this->radio.testRPD();
+            this->radio.stopListening();
+            if (carrier)
+            {
+                this->counts[channel / 2] += (channel & 1) ? 0x10 : 0x01;
+            }
+        }
+    }
+    this->radio.flush_rx(); // frames picked up while sweeping
+}
+
+// spectrum as one hex digit per channel (hits out of SURVEY_PASSES), below a channel number header
+void ChannelSurvey::print()
+{
+    Serial.print(F("Channel survey (carrier hits of "));
+    Serial.print(SURVEY_PASSES);
+    Serial.println(F(" sweeps):"));
+    for (uint8_t digit = 100; digit; digit /= 10)
+    {
+        for (uint8_t channel = 0; channel < SURVEY_CHANNELS; channel++)
+        {
+            Serial.print((channel / digit) % 10);
+        }
+        Serial.println();
+    }
+    for (uint8_t channel = 0; channel < SURVEY_CHANNELS; channel++)
+    {
+        Serial.print(this->hits(channel), HEX);
+    }
+    Serial.println();
+}
+
+uint32_t ChannelSurvey::propose()
+{
+    uint8_t count = 0;
+    for (int16_t channel = RADIO_SURVEY_MAX_CHANNEL; channel >= 0; channel--) // insertion into the sorted candidate list
+    {
+        uint8_t channelScore = this->score(channel);
+        uint8_t i = count;
+        while (i > 0 && channelScore < this->score(this->candidates[i - 1]))
+        {
+            if (i < SURVEY_CANDIDATES)
+            {
+                this->candidates[i] = this->candidates[i - 1];
+            }
+            i--;
+        }
+        if (i < SURVEY_CANDIDATES)
+        {
+            this->candidates[i] = channel;
+            count += count < SURVEY_CANDIDATES;
+        }
+    }
+
+    uint32_t packed = 0;
+    for (uint8_t i = 0; i < SURVEY_CANDIDATES; i++)
+    {
+        this->totals[i] = this->score(this->candidates[i]);
+        packed |= (uint32_t)this->candidates[i] << (8 * i);
+    }
+    return packed;
+}
+
+uint32_t ChannelSurvey::noise(uint32_t candidates)
+{
+    uint32_t packed = 0;
+    for (uint8_t i = 0; i < SURVEY_CANDIDATES; i++)
+    {
+        uint8_t channel = candidates >> (8 * i);
+        packed |= (uint32_t)(channel < SURVEY_CHANNELS ? this->score(channel) : 0xFF) << (8 * i);
+    }
+    return packed;
+}
+
+void ChannelSurvey::vote(uint32_t noise)
+{
+    for (uint8_t i = 0; i < SURVEY_CANDIDATES; i++)
+    {
+        this->totals[i] += (uint8_t)(noise >> (8 * i));
+    }
+}
+
+uint8_t ChannelSurvey::decide()
+{
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < SURVEY_CANDIDATES; i++)
+    {
+        if (this->totals[i] < this->totals[best])
+        {
+            best = i;
+        }
+    }
+    return this->candidates[best];
+}
+
+uint8_t ChannelSurvey::hits(uint8_t channel)
+{
+    uint8_t pair = this->counts[channel / 2];
+    return (channel & 1) ? pair >> 4 : pair & 0x0F;
+}
+
+// own hits count double, neighbours once (max 60)
+uint8_t ChannelSurvey::score(uint8_t channel)
+{
+    uint8_t sum = 2 * this->hits(channel);
+    if (channel > 0)
+    {
+        sum += this->hits(channel - 1);
+    }
+    if (channel < SURVEY_CHANNELS - 1)
+    {
+        sum += this->hits(channel + 1);
+    }
+    return sum;
+}
@@ -0,0 +1,76 @@
+/* ClockSync Class
+ *  - offset = ((t2 - t1) + (t3 - t4)) / 2, rtt = (t4 - t1) - (t3 - t2) (NTP style, assumes symmetric air time, an
+ *    asymmetry of the one-way delays shifts the offset by half of it)
+ *  - The clocks are apart by anything up to 2^32 micros (both run from power-on): offsets are differences modulo 2^32,
+ *    only small differences (half the RTT, the offset change between two samples) are taken as signed
+ *  - The offset is taken from accepted samples directly, the drift is smoothed over successive accepted samples,
+ *    so between two pings the offset is extrapolated with the drift
+ */
+
+#include "ClockSync.h"
+
+// add one ping/pong round trip (t1, t4 local clock; t2, t3 remote clock)
+void ClockSync::addSample(uint32_t t1, uint32_t t2, uint32_t t3, uint32_t t4)
+{
+    int32_t sampleRtt = (int32_t)(t4 - t1) - (int32_t)(t3 - t2);
+    if (sampleRtt < 0)
+    {
+        return; // inconsistent timestamps
+    }
+
+    // # min RTT filter (re-learned every CLOCK_SYNC_RTT_WINDOW samples)
+    if (!this->windowCount || sampleRtt < this->windowMinRtt)
+    {
+        this->windowMinRtt = sampleRtt;
+    }
+    if (++this->windowCount >= CLOCK_SYNC_RTT_WINDOW)
+    {
+        this->minRtt = this->windowMinRtt;
+        this->windowCount = 0;
+    }
+    if (!this->synced || sampleRtt < this->minRtt)
+    {
+        this->minRtt = sampleRtt;
+    }
+    if (sampleRtt > this->minRtt + CLOCK_SYNC_RTT_TOLERANCE)
+    {
+        return; // delayed by queueing or retries, offset would be off by half the delay
+    }
+
+    int32_t a = (int32_t)(t2 - t1); // midpoint without adding the two halves (they overflow near 2^31)
+    int32_t sampleOffset = a + (int32_t)((t3 - t4) - (uint32_t)a) / 2;
+    uint32_t sampleTime = t1 + sampleRtt / 2;
+
+    // # drift from the offset change since the last accepted sample
+    int32_t elapsed = (int32_t)(sampleTime - this->offsetTime);
+    if (this->synced && elapsed < CLOCK_SYNC_DRIFT_MIN_MICROS)
+    {
+        return; // too close to measure drift, keep the older sample as reference
+    }
+    if (this->synced)
+    {
+        float sampleDrift = (float)(int32_t)((uint32_t)sampleOffset - (uint32_t)this->offset) / elapsed;
+        if (this->driftValid)
+        {
+            this->drift += CLOCK_SYNC_DRIFT_GAIN * (sampleDrift - this->drift);
+        }
+        else // first measurement, resonators can be 0.5 % apart, don't start smoothing from 0
+        {
+            this->drift = sampleDrift;
+            this->driftValid = true;
+        }
+    }
+
+    this->offset = sampleOffset;
+    this->offsetTime = sampleTime;
+    this->rtt = sampleRtt;
+    this->synced = true;
+}
+
+// map a remote timestamp onto the local clock (offset extrapolated with the drift)
+uint32_t ClockSync::toLocal(uint32_t remoteTime)
+{
+    uint32_t localTime = remoteTime - this->offset;
+    uint32_t offsetNow = (uint32_t)this->offset + (int32_t)(this->drift * (int32_t)(localTime - this->offsetTime));
+    return remoteTime - offsetNow;
+}
@@ -0,0 +1,64 @@
+/* EventLog Class
+ *  - Records are written out whole: drain() starts one only with room for all of its bytes in the TX buffer
+ */
+
+#include "EventLog.h"
+
+EventLog eventLog;
+
+void EventLog::log(uint8_t event, uint32_t value)
+{
+    this->log(event, value, micros());
+}
+
+void EventLog::log(uint8_t event, uint32_t value, uint32_t time)
+{
+    if (this->count == EVENT_LOG_RECORDS)
+    {
+        if (this->dropped < 0xFFFF)
+        {
+            this->dropped++;
+        }
+        return;
+    }
+    Record &record = this->ring[(this->head + this->count) % EVENT_LOG_RECORDS];
+    record.event = event;
+    record.time = time;
+    record.value = value;
+    this->count++;
+}
+
+void EventLog::drain()
+{
+    while (this->count && Serial.availableForWrite() >= EVENT_LOG_WIRE_LEN)
+    {
+        this->write(this->ring[this->head]);
+        this->head = (this->head + 1) % EVENT_LOG_RECORDS;
+        this->count--;
+    }
+    if (!this->count && this->dropped != this->reported && Serial.availableForWrite() >= EVENT_LOG_WIRE_LEN)
+    {
+        this->reported = this->dropped;
+        Record record = {EVENT_DROPPED, (uint32_t)micros(), this->dropped};
+        this->write(record);
+    }
+}
+
+void EventLog::write(const Record &record)
+{
+    uint8_t bytes[EVENT_LOG_RECORD_LEN];
+    bytes[0] = record.event;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        bytes[1 + i] = record.time >> (8 * i);
+        bytes[5 + i] = record.value >> (8 * i);
+    }
+    uint8_t checksum = 0;
+    for (uint8_t i = 0; i < EVENT_LOG_RECORD_LEN; i++)
+    {
+        checksum += bytes[i];
+    }
+    Serial.write(EVENT_LOG_SYNC);
+    Serial.write(bytes, EVENT_LOG_RECORD_LEN);
+    Serial.write(checksum);
+}
@@ -0,0 +1,113 @@
+/* Frame
+ *  - frameEncode()/frameDecode() (de)serialize byte by byte so the layout doesn't depend on struct packing
+ *  - SeqTracker keeps the last accepted sequence numbers per sender
+ */
+
+#include "Frame.h"
+
+// number of timestamps carried by each frame type
+static const uint8_t frameTimeCount[FRAME_TYPE_COUNT] = {0, 1, 2, 3, 1, 1, 2, 1};
+
+uint8_t frameEncode(const Frame *frame, uint8_t *buf)
+{
+    uint8_t len = 0;
+    buf[len++] = FRAME_VERSION;
+    buf[len++] = frame->type;
+    buf[len++] = frame->seq;
+    buf[len++] = frame->flags;
+
+    for (uint8_t i = 0; i < frameTimeCount[frame->type]; i++)
+    {
+        uint32_t time = frame->time[i];
+        for (uint8_t b = 0; b < 4; b++)
+        {
+            buf[len++] = time & 0xFF;
+            time >>= 8;
+        }
+    }
+    return len;
+}
+
+bool frameDecode(const uint8_t *buf, uint8_t len, Frame *frame)
+{
+    if (len < FRAME_HEADER_LEN || buf[0] != FRAME_VERSION || buf[1] >= FRAME_TYPE_COUNT)
+    {
+        return false;
+    }
+    if (len != FRAME_HEADER_LEN + 4 * frameTimeCount[buf[1]])
+    {
+        return false;
+    }
+
+    frame->type = buf[1];
+    frame->seq = buf[2];
+    frame->flags = buf[3];
+    for (uint8_t i = 0; i < frameTimeCount[frame->type]; i++)
+    {
+        const uint8_t *b = &buf[FRAME_HEADER_LEN + 4 * i];
+        frame->time[i] = (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+    }
+    return true;
+}
+
+// preamble (1) + address (5) + packet control field (9 bit) + payload + CRC (2), 4 micros per bit at 250 kbps
+uint16_t frameAirMicros(uint8_t len)
+{
+    return (8 * (1 + 5 + len + 2) + 9) * 4;
+}
+
+bool SeqTracker::accept(uint8_t seq, uint32_t time)
+{
+    if (this->valid && this->seen(seq) && (uint32_t)(time - this->lastTime) < FRAME_DUPLICATE_MICROS)
+    {
+        this->duplicates++;
+        return false;
+    }
+
+    if (!this->valid)
+    {
+        this->recentCount = 0;
+    }
+    else
+    {
+        uint8_t gap = seq - this->lastSeq - 1;
+        if (gap < 128)
+        {
+            this->missed += gap;
+        }
+        else // older sequence numbers mean the sender restarted, not a gap
+        {
+            this->recentCount = 0;
+        }
+    }
+
+    for (uint8_t i = min(this->recentCount, FRAME_SEQ_WINDOW - 1); i > 0; i--)
+    {
+        this->recent[i] = this->recent[i - 1];
+    }
+    this->recent[0] = seq;
+    this->recentCount = min(this->recentCount + 1, FRAME_SEQ_WINDOW);
+
+    this->valid = true;
+    this->lastSeq = seq;
+    this->lastTime = time;
+    this->received++;
+    return true;
+}
+
+void SeqTracker::restart()
+{
+    this->valid = false;
+}
+
+bool SeqTracker::seen(uint8_t seq)
+{
+    for (uint8_t i = 0; i < this->recentCount; i++)
+    {
+        if (this->recent[i] == seq)
+        {
+            return true;
+        }
+    }
+    return false;
+}
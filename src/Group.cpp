@@ -0,0 +1,38 @@
+/* Group Class
+ *  - A member only holds its most recent pull, so a pull counts for at most one synch pull (clear() after success)
+ */
+
+#include "Group.h"
+
+void Group::pull(uint8_t member, uint32_t time)
+{
+    if (member >= this->size)
+    {
+        return;
+    }
+    this->pullTime[member] = time;
+    this->pulled |= _BV(member);
+}
+
+uint8_t Group::count(uint32_t reference, uint32_t window)
+{
+    uint8_t n = 0;
+    for (uint8_t member = 0; member < this->size; member++)
+    {
+        if (!(this->pulled & _BV(member)))
+        {
+            continue;
+        }
+        int32_t delta = (int32_t)(this->pullTime[member] - reference);
+        if (delta <= (int32_t)window && delta >= -(int32_t)window)
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+void Group::clear()
+{
+    this->pulled = 0;
+}
@@ -0,0 +1,39 @@
+/* Heartbeat Class
+ *  - A partner never seen since startup isn't reported as lost (e.g. slave switched on before the master)
+ */
+
+#include "Heartbeat.h"
+
+bool Heartbeat::seen(uint32_t now)
+{
+    bool back = !this->alive && this->lastTime;
+    this->alive = true;
+    this->lastTime = now | 1; // 0 = never seen
+    return back;
+}
+
+bool Heartbeat::expired(uint32_t now)
+{
+    if (!this->alive || (uint32_t)(now - this->lastTime) <= HEARTBEAT_TIMEOUT_MICROS)
+    {
+        return false;
+    }
+    this->alive = false;
+    return true;
+}
+
+bool Heartbeat::differs(uint32_t local, uint32_t remote)
+{
+    uint32_t difference = local ^ remote;
+    if (difference != this->lastDifference)
+    {
+        this->lastDifference = difference;
+        this->differenceCount = 0;
+    }
+    if (!difference || ++this->differenceCount < HEARTBEAT_CONFIRM)
+    {
+        return false;
+    }
+    this->differenceCount = 0; // a lasting difference is reported again after HEARTBEAT_CONFIRM more heartbeats
+    return true;
+}
@@ -0,0 +1,59 @@
+/* LeverEvents
+ *  - init() enables the pin-change interrupt for both lever pins
+ *  - push()/pop() implement the single-producer/single-consumer ring; head is only written by the ISR,
+ *    tail only by loop(), so no interrupt locking is needed (8 bit index accesses are atomic on AVR)
+ */
+
+#include "LeverEvents.h"
+
+LeverEventQueue leverEvents;
+
+void LeverEventQueue::init()
+{
+    this->head = 0;
+    this->tail = 0;
+    this->dropped = 0;
+
+    PCMSK2 |= LEVER_EVENT_PIN_MASK; // PCINT16-23 map to PD0-PD7
+    PCIFR = _BV(PCIF2);             // clear a pending flag from before init
+    PCICR |= _BV(PCIE2);
+}
+
+bool LeverEventQueue::push(uint32_t time, uint8_t pins)
+{
+    uint8_t next = (this->head + 1) & (LEVER_EVENT_QUEUE_LEN - 1);
+    if (next == this->tail) // full -> drop newest, the queued edges stay in order
+    {
+        this->dropped++;
+        return false;
+    }
+
+    this->events[this->head].time = time;
+    this->events[this->head].pins = pins;
+    __asm__ __volatile__("" ::: "memory"); // publish the event before moving head
+    this->head = next;
+
+    return true;
+}
+
+bool LeverEventQueue::pop(LeverEvent *event)
+{
+    uint8_t tail = this->tail;
+    if (tail == this->head)
+    {
+        return false;
+    }
+
+    *event = this->events[tail];
+    __asm__ __volatile__("" ::: "memory"); // read the event before releasing the slot
+    this->tail = (tail + 1) & (LEVER_EVENT_QUEUE_LEN - 1);
+
+    return true;
+}
+
+// lever pin change: one port read, timestamp taken as close to the edge as possible
+ISR(PCINT2_vect)
+{
+    uint8_t pins = PIND & LEVER_EVENT_PIN_MASK;
+    leverEvents.push(micros(), pins);
+}
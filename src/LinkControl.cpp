@@ -0,0 +1,113 @@
+/* LinkControl Class
+ *  - The retry count assumes independent losses: an attempt fails with loss^(count + 1), bursts show up as failed
+ *    attempts and are answered with a longer delay instead
+ *  - Failed attempts stay out of the loss estimate and their extra retries end with the window: on a half-duplex
+ *    pair most of them are both sides transmitting at once (deaf while waiting for their own ACKs), counting them
+ *    kept the most retries for good, which made every such overlap last longer
+ *  - Estimates are fixed point (x / 256), the count search multiplies instead of taking logarithms
+ */
+
+#include "LinkControl.h"
+
+void LinkControl::begin(uint8_t minDelay, uint8_t maxDelay, uint8_t maxCount)
+{
+    this->minDelay = min(minDelay, maxDelay);
+    this->maxDelay = maxDelay;
+    this->maxCount = maxCount;
+    this->retryDelay = maxDelay;
+    this->retryCount = maxCount;
+    this->paLevel = this->minPaLevel;
+    this->escalate = false;
+    this->loss = 0;
+    this->payloads = 0;
+    this->failures = 0;
+    this->transmissions = 0;
+    this->losses = 0;
+    this->apply();
+}
+
+void LinkControl::delivered(uint8_t arc)
+{
+    this->payloads++;
+    this->transmissions += arc + 1;
+    this->losses += arc;
+}
+
+void LinkControl::failed()
+{
+    this->payloads++;
+    this->failures++;
+    this->escalate = true; // not counted as losses, see above
+}
+
+void LinkControl::update()
+{
+    if (this->escalate) // burst or both sides transmitting: retry the payload with a longer delay and all retries
+    {
+        this->escalate = false;
+        this->retryDelay = min(2 * this->retryDelay + 1, (int)this->maxDelay);
+        this->retryCount = this->maxCount;
+        this->apply();
+    }
+    if (this->payloads < LINK_CONTROL_WINDOW)
+    {
+        return;
+    }
+
+    uint8_t windowLoss = this->transmissions ? min((uint32_t)this->losses * 256 / this->transmissions, (uint32_t)255) : this->loss;
+    this->loss = ((uint16_t)this->loss + windowLoss + 1) / 2;
+
+    if (this->loss > LINK_CONTROL_PA_UP_LOSS * 256 && this->paLevel < this->maxPaLevel)
+    {
+        this->paLevel++;
+    }
+    else if (this->loss < LINK_CONTROL_PA_DOWN_LOSS * 256 && !this->failures && this->paLevel > this->minPaLevel)
+    {
+        this->paLevel--;
+    }
+
+    if (!this->failures && this->retryDelay > this->minDelay) // otherwise keep the escalated delay for another window
+    {
+        this->retryDelay--;
+    }
+    this->retryCount = this->retriesFor(this->loss);
+
+    this->payloads = 0;
+    this->failures = 0;
+    this->transmissions = 0;
+    this->losses = 0;
+    this->apply();
+}
+
+void LinkControl::print()
+{
+    Serial.print(F("ard="));
+    Serial.print(this->retryDelay);
+    Serial.print(F(" arc="));
+    Serial.print(this->retryCount);
+    Serial.print(F(" pa="));
+    Serial.print(this->paLevel);
+    Serial.print(F(" loss="));
+    Serial.print(this->loss * 100 / 256);
+    Serial.print('%');
+}
+
+void LinkControl::apply()
+{
+    this->radio.setRetries(this->retryDelay, this->retryCount);
+    this->radio.setPALevel(this->paLevel);
+}
+
+// fewest retries with loss^(retries + 1) <= 1 - LINK_CONTROL_TARGET
+uint8_t LinkControl::retriesFor(uint8_t loss)
+{
+    const uint16_t allowed = (1 - LINK_CONTROL_TARGET) * 65536;
+    uint16_t fail = loss << 8; // x / 65536, probability that the first transmission fails
+    uint8_t retries = 0;
+    while (fail > allowed && retries < this->maxCount)
+    {
+        fail = (uint32_t)fail * loss >> 8;
+        retries++;
+    }
+    return max(retries, (uint8_t)min(LINK_CONTROL_MIN_COUNT, (int)this->maxCount));
+}
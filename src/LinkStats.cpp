@@ -0,0 +1,79 @@
+/* LinkStats Class
+ *  - Record: "tx=<delivered>,<lost>,<MAX_RT> arc=<sum>:<histogram> rtt=<histogram>", histogram buckets separated by '/'
+ */
+
+#include "LinkStats.h"
+
+void LinkStats::delivered(uint8_t arc, uint32_t rtt)
+{
+    this->delivered();
+    this->arcSum += arc;
+    count(this->arcHistogram[bucket(arc, LINK_STATS_ARC_BUCKETS)]);
+    count(this->rttHistogram[bucket(rtt >> LINK_STATS_RTT_SHIFT, LINK_STATS_RTT_BUCKETS)]);
+}
+
+void LinkStats::delivered()
+{
+    count(this->sent);
+}
+
+void LinkStats::failedAttempt()
+{
+    count(this->maxRt);
+}
+
+void LinkStats::lost()
+{
+    count(this->lostCount);
+}
+
+void LinkStats::print()
+{
+    Serial.print(F("tx="));
+    Serial.print(this->sent);
+    Serial.print(',');
+    Serial.print(this->lostCount);
+    Serial.print(',');
+    Serial.print(this->maxRt);
+    Serial.print(F(" arc="));
+    Serial.print(this->arcSum);
+    for (uint8_t i = 0; i < LINK_STATS_ARC_BUCKETS; i++)
+    {
+        Serial.print(i ? '/' : ':');
+        Serial.print(this->arcHistogram[i]);
+    }
+    Serial.print(F(" rtt="));
+    for (uint8_t i = 0; i < LINK_STATS_RTT_BUCKETS; i++)
+    {
+        if (i)
+        {
+            Serial.print('/');
+        }
+        Serial.print(this->rttHistogram[i]);
+    }
+}
+
+void LinkStats::clear()
+{
+    *this = LinkStats();
+}
+
+void LinkStats::count(uint16_t &counter)
+{
+    if (counter < 0xFFFF)
+    {
+        counter++;
+    }
+}
+
+// 0 -> 0, 1 -> 1, 2-3 -> 2, 4-7 -> 3 ... (last bucket for everything above)
+uint8_t LinkStats::bucket(uint32_t value, uint8_t count)
+{
+    uint8_t i = 0;
+    while (value && i < count - 1)
+    {
+        value >>= 1;
+        i++;
+    }
+    return i;
+}
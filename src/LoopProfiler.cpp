@@ -0,0 +1,143 @@
+/* LoopProfiler Class
+ *  - Record: "Loop: n=<loops> cost=<nanos> lever=<min>-<max>:<histogram> remote=... radio=... task=... loop=...
+ *    worst=<millis>:<lever>/<remote>/<radio>/<task>/<loop>", durations in micros, histogram buckets separated by '/'
+ */
+
+#include "LoopProfiler.h"
+
+static const char *const phaseNames[LOOP_PROFILE_PHASES + 1] = {"lever", "remote", "radio", "task", "loop"};
+
+void LoopProfiler::start()
+{
+    uint32_t now = ticks();
+    if (this->loops && !this->skip)
+    {
+        uint32_t durations[LOOP_PROFILE_PHASES + 1];
+        uint32_t from = this->loopStart;
+        for (uint8_t i = 0; i < LOOP_PROFILE_PHASES; i++)
+        {
+            durations[i] = this->marks[i] - from;
+            from = this->marks[i];
+        }
+        durations[LOOP_PROFILE_PHASES] = now - this->loopStart;
+        for (uint8_t i = 0; i <= LOOP_PROFILE_PHASES; i++)
+        {
+            record(this->phases[i], durations[i]);
+        }
+        if (durations[LOOP_PROFILE_PHASES] > this->worst[LOOP_PROFILE_PHASES])
+        {
+            memcpy(this->worst, durations, sizeof(this->worst));
+            this->worstMillis = millis();
+        }
+    }
+    if (this->loops < 0xFFFFFFFF)
+    {
+        this->loops++;
+    }
+    this->skip = false;
+    this->loopStart = now;
+    for (uint8_t i = 0; i < LOOP_PROFILE_PHASES; i++)
+    {
+        this->marks[i] = now; // phases a loop skips take 0 ticks
+    }
+}
+
+// empty loops through the profiler, timed with micros()
+void LoopProfiler::calibrate()
+{
+    uint32_t started = micros();
+    for (uint8_t i = 0; i < LOOP_PROFILE_CALIBRATION; i++)
+    {
+        this->start();
+        this->mark(LOOP_PHASE_LEVER);
+        this->mark(LOOP_PHASE_REMOTE);
+        this->mark(LOOP_PHASE_RADIO);
+        this->mark(LOOP_PHASE_TASK);
+    }
+    uint32_t nanos = (micros() - started) * 1000 / LOOP_PROFILE_CALIBRATION;
+    this->clear();
+    this->overheadNanos = nanos < 0xFFFF ? nanos : 0xFFFF;
+}
+
+void LoopProfiler::print()
+{
+    Serial.print(F("Loop: n="));
+    Serial.print(this->loops);
+    Serial.print(F(" cost="));
+    Serial.print(this->overheadNanos);
+    for (uint8_t i = 0; i <= LOOP_PROFILE_PHASES; i++)
+    {
+        const Phase &phase = this->phases[i];
+        Serial.print(' ');
+        Serial.print(phaseNames[i]);
+        Serial.print('=');
+        printMicros(phase.min > phase.max ? 0 : phase.min);
+        Serial.print('-');
+        printMicros(phase.max);
+        for (uint8_t b = 0; b < LOOP_PROFILE_BUCKETS; b++)
+        {
+            Serial.print(b ? '/' : ':');
+            Serial.print(phase.histogram[b]);
+        }
+    }
+    Serial.print(F(" worst="));
+    Serial.print(this->worstMillis);
+    for (uint8_t i = 0; i <= LOOP_PROFILE_PHASES; i++)
+    {
+        Serial.print(i ? '/' : ':');
+        printMicros(this->worst[i]);
+    }
+    Serial.println();
+    this->skip = true;
+}
+
+void LoopProfiler::clear()
+{
+    uint16_t overheadNanos = this->overheadNanos;
+    *this = LoopProfiler();
+    this->overheadNanos = overheadNanos;
+}
+
+// min, max, histogram bucket (0 -> 0, 1 -> 1, 2-3 -> 2 ... last bucket for everything above), a full counter halves
+// all counters of the phase (the histogram keeps its shape over hours of loops)
+void LoopProfiler::record(Phase &phase, uint32_t ticks)
+{
+    if (ticks < phase.min)
+    {
+        phase.min = ticks;
+    }
+    if (ticks > phase.max)
+    {
+        phase.max = ticks;
+    }
+    uint8_t i = LOOP_PROFILE_BUCKETS - 1;
+    if (ticks < 1U << (LOOP_PROFILE_BUCKETS - 2)) // 16 bit from here on
+    {
+        uint16_t rest = ticks;
+        i = 0;
+        if (rest >> 8)
+        {
+            rest >>= 8;
+            i = 8;
+        }
+        while (rest)
+        {
+            rest >>= 1;
+            i++;
+        }
+    }
+    uint16_t &counter = phase.histogram[i];
+    if (counter == 0xFFFF)
+    {
+        for (uint8_t b = 0; b < LOOP_PROFILE_BUCKETS; b++)
+        {
+            phase.histogram[b] = (phase.histogram[b] + 1) >> 1; // rare stalls stay visible
+        }
+    }
+    counter++;
+}
+
+void LoopProfiler::printMicros(uint32_t ticks)
+{
+    Serial.print(ticks * LOOP_PROFILE_TICK_MICROS);
+}
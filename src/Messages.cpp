@@ -0,0 +1,88 @@
+/* Messages
+ *  - One named PROGMEM array per text (avr-gcc only puts named arrays into flash), the table of their addresses is in
+ *    flash as well and read with pgm_read_ptr()
+ */
+
+#include "Messages.h"
+
+#include <avr/pgmspace.h>
+
+static const char msgStStart[] PROGMEM = "ST_START";
+static const char msgStUnlocklever[] PROGMEM = "ST_UNLOCKLEVER";
+static const char msgStLeverfullup[] PROGMEM = "ST_LEVERFULLUP";
+static const char msgStLeverfulldown[] PROGMEM = "ST_LEVERFULLDOWN";
+static const char msgStSyncboxes[] PROGMEM = "ST_SYNCBOXES";
+static const char msgStReward[] PROGMEM = "ST_REWARD";
+static const char msgStLocklever[] PROGMEM = "ST_LOCKLEVER";
+static const char msgStWait[] PROGMEM = "ST_WAIT";
+static const char msgMdOne[] PROGMEM = "MD_ONE";
+static const char msgMdTwo[] PROGMEM = "MD_TWO";
+static const char msgMdThree[] PROGMEM = "MD_THREE";
+static const char msgWdSetup[] PROGMEM = "setup";
+static const char msgWdLever[] PROGMEM = "lever";
+static const char msgWdRemote[] PROGMEM = "remote";
+static const char msgWdRadio[] PROGMEM = "radio";
+static const char msgWdTask[] PROGMEM = "task";
+static const char msgState[] PROGMEM = "State: ";
+static const char msgMode[] PROGMEM = "Mode: ";
+static const char msgCurrentPullGoal[] PROGMEM = "Current random pull goal: ";
+static const char msgNewPullGoal[] PROGMEM = "New random pull goal: ";
+static const char msgLeverUp[] PROGMEM = "leverUp: ";
+static const char msgLeverDown[] PROGMEM = "leverDown: ";
+static const char msgDeployCounter[] PROGMEM = "deployCounter: ";
+static const char msgAudioNotResponding[] PROGMEM = "Audio player is not responding:";
+static const char msgAudioCheckConnection[] PROGMEM = "1.Please recheck the connection!";
+static const char msgAudioCheckSdCard[] PROGMEM = "2.Please insert the SD card!";
+static const char msgAudioRestart[] PROGMEM = "3.Restart program!";
+static const char msgIllegalSetup[] PROGMEM = "Illegal setup: SYNCH_PULL_MAX not divisible by MODE_TEST_COUNT!";
+static const char msgCheckSettings[] PROGMEM = "Check settings.h!";
+static const char msgRadioNotResponding[] PROGMEM = "Radio hardware is not responding!";
+static const char msgBoxId[] PROGMEM = "Box ID: ";
+static const char msgSetupSuccessful[] PROGMEM = "Setup successful!";
+static const char msgAlert[] PROGMEM = "*** ";
+static const char msgSlave[] PROGMEM = "Slave ";
+static const char msgMaster[] PROGMEM = "Master";
+static const char msgLinkLost[] PROGMEM = ": link lost";
+static const char msgLinkBack[] PROGMEM = ": link back";
+static const char msgLinkSilent[] PROGMEM = "*** Link silent, back to the meeting channel";
+static const char msgChannel[] PROGMEM = "Channel: ";
+static const char msgStateResynchronised[] PROGMEM = "*** State differs from the master, resynchronised: ";
+static const char msgCorruptPayload[] PROGMEM = "*** Corrupt payload received!";
+static const char msgInvalidFrame[] PROGMEM = "*** Invalid frame received!";
+static const char msgUnknownPipe[] PROGMEM = "*** Frame on unknown pipe received!";
+static const char msgDuplicateFrame[] PROGMEM = "Duplicate frame dropped";
+static const char msgTxQueueFull[] PROGMEM = "*** Transmission queue full, payload dropped!";
+static const char msgTxFailedDefinitively[] PROGMEM = "*** Transmission failed definitively for this payload!";
+static const char msgTxFailed[] PROGMEM = "*** Transmission failed!";
+static const char msgTxRetrying[] PROGMEM = "Retrying ...";
+static const char msgTxSuccessful[] PROGMEM = "Transmission successfull!";
+static const char msgPairingStarted[] PROGMEM = "Pairing: started";
+static const char msgPairingStopped[] PROGMEM = "Pairing: stopped";
+static const char msgPairingNoAnswer[] PROGMEM = "Pairing: no slave answered";
+static const char msgPairingWaiting[] PROGMEM = "Pairing: waiting for the master";
+static const char msgPairingBox[] PROGMEM = "Pairing: box ";
+static const char msgPairingIsMember[] PROGMEM = " is member ";
+static const char msgPairingMember[] PROGMEM = "Pairing: member ";
+
+static const char *const messages[] PROGMEM = {
+    msgStStart, msgStUnlocklever, msgStLeverfullup, msgStLeverfulldown, msgStSyncboxes, msgStReward, msgStLocklever,
+    msgStWait, msgMdOne, msgMdTwo, msgMdThree, msgWdSetup, msgWdLever, msgWdRemote, msgWdRadio, msgWdTask, msgState,
+    msgMode, msgCurrentPullGoal, msgNewPullGoal, msgLeverUp, msgLeverDown, msgDeployCounter, msgAudioNotResponding,
+    msgAudioCheckConnection, msgAudioCheckSdCard, msgAudioRestart, msgIllegalSetup, msgCheckSettings,
+    msgRadioNotResponding, msgBoxId, msgSetupSuccessful, msgAlert, msgSlave, msgMaster, msgLinkLost, msgLinkBack,
+    msgLinkSilent, msgChannel, msgStateResynchronised, msgCorruptPayload, msgInvalidFrame, msgUnknownPipe,
+    msgDuplicateFrame, msgTxQueueFull, msgTxFailedDefinitively, msgTxFailed, msgTxRetrying, msgTxSuccessful,
+    msgPairingStarted, msgPairingStopped, msgPairingNoAnswer, msgPairingWaiting, msgPairingBox, msgPairingIsMember,
+    msgPairingMember,
+};
+static_assert(sizeof(messages) / sizeof(messages[0]) == MSG_COUNT, "One text per message_id");
+
+const __FlashStringHelper *message(message_id id)
+{
+    return (const __FlashStringHelper *)pgm_read_ptr(&messages[id]);
+}
+
+const __FlashStringHelper *message(uint8_t first, uint8_t offset)
+{
+    return message((message_id)(first + offset));
+}
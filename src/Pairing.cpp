@@ -0,0 +1,46 @@
+/* Pairing Class
+ *  - The ID is collected from the noise of the unconnected analog pin A7 and the micros() jitter of the conversions
+ */
+
+#include "Pairing.h"
+
+void Pairing::init()
+{
+    EEPROM.get(PAIRING_EEPROM_ADDRESS, this->id);
+    if (this->id == 0 || this->id == 0xFFFFFFFF) // first start (erased EEPROM)
+    {
+        do
+        {
+            for (uint8_t i = 0; i < 32; i++)
+            {
+                this->id = (this->id << 1 | this->id >> 31) ^ analogRead(A7) ^ micros();
+            }
+        } while (this->id == 0 || this->id == 0xFFFFFFFF);
+        EEPROM.put(PAIRING_EEPROM_ADDRESS, this->id);
+    }
+    EEPROM.get(PAIRING_EEPROM_ADDRESS + sizeof(this->id), this->record);
+}
+
+bool Pairing::paired()
+{
+    return this->record.version == PAIRING_VERSION;
+}
+
+void Pairing::save(uint32_t group, uint8_t member, uint8_t channel)
+{
+    this->record.version = PAIRING_VERSION;
+    this->record.group = group;
+    this->record.member = member;
+    this->record.channel = channel;
+    EEPROM.put(PAIRING_EEPROM_ADDRESS + sizeof(this->id), this->record);
+}
+
+// member number first (pipes 2-5 only differ in the first byte), then the group ID
+void Pairing::address(uint8_t member, uint8_t *address)
+{
+    address[0] = '0' + member;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        address[1 + i] = this->record.group >> (8 * i);
+    }
+}
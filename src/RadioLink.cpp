@@ -0,0 +1,363 @@
+/* RadioLink Class
+ *  - The radio stays in listening mode while idle, every queued payload is transmitted with its own
+ *    stopListening() ... startListening() cycle (consecutive payloads are chained without listening in between,
+ *    unless the own time slot closes in slotted mode)
+ *  - A failed attempt (MAX_RT) is retried up to RADIO_TRANSMISSION_MAX_ATTEMPTS times before the payload is dropped,
+ *    after listening for a random back-off: two boxes sending at once are deaf to each other for a whole attempt
+ *    (all retries in TX mode), without the pause they would keep retrying in lockstep until both payloads are lost
+ *  - The copies of a broadcast are spaced by the same back-off
+ *  - The IRQ pin goes low on TX_DS, MAX_RT and RX_DR and stays low until the status flags are cleared;
+ *    the ISR only sets a flag and keeps the time, the status is read and cleared in serviceIrq() from loop()
+ */
+
+#include "Messages.h"
+#include "RadioLink.h"
+#include "Trace.h"
+
+static volatile bool radioIrqFlag = false;
+static volatile uint32_t radioIrqTime = 0;
+
+// nRF24 IRQ pin change (falling edge = new radio event)
+ISR(PCINT0_vect)
+{
+    if (!(PINB & _BV(RADIO_IRQ_PIN - 8)))
+    {
+        radioIrqTime = micros();
+        radioIrqFlag = true;
+    }
+}
+
+void RadioLink::init(uint8_t broadcastRepeats)
+{
+    this->broadcastRepeats = broadcastRepeats;
+    this->radio.enableDynamicAck(); // allows the NO_ACK flag (multicast) per payload (broadcasts, beacons)
+
+    pinMode(RADIO_IRQ_PIN, INPUT_PULLUP);
+    this->radio.maskIRQ(false, false, false); // IRQ on TX_DS, MAX_RT and RX_DR
+
+    PCMSK0 |= _BV(RADIO_IRQ_PIN - 8); // PCINT0-7 map to PB0-PB5 (pins 8-13)
+    PCIFR = _BV(PCIF0);
+    PCICR |= _BV(PCIE0);
+
+    radioIrqFlag = true; // read (and clear) whatever is already pending
+}
+
+// read and clear the status flags if the IRQ fired (or the fallback poll is due)
+void RadioLink::serviceIrq(bool &txOk, bool &txFail)
+{
+    uint32_t now = micros();
+    txOk = false;
+    txFail = false;
+
+    if (!radioIrqFlag && (uint32_t)(now - this->lastStatusTime) < RADIO_IRQ_POLL_MICROS)
+    {
+        return;
+    }
+
+    uint32_t irqTime;
+    noInterrupts();
+    irqTime = radioIrqFlag ? radioIrqTime : now;
+    radioIrqFlag = false; // cleared before the status is read, so a new edge from now on is not lost
+    interrupts();
+    this->lastStatusTime = now;
+
+    bool rxReady;
+    this->radio.whatHappened(txOk, txFail, rxReady);
+    if (txOk || txFail)
+    {
+        trace.transmitted(irqTime, txOk, TRACE_ENABLED ? this->radio.getARC() : 0);
+    }
+    if (txOk)
+    {
+        this->txDoneTime = irqTime;
+    }
+    if (rxReady)
+    {
+        this->rxPending = true;
+        this->rxTime = irqTime;
+
+        this->ackGone();
+    }
+}
+
+// preload the ACK payload (replaces an armed one)
+bool RadioLink::armAck(const void *buf, uint8_t len)
+{
+    if (this->busy())
+    {
+        return false;
+    }
+    this->radio.flush_tx();
+    this->ackArmed = this->radio.writeAckPayload(1, buf, len);
+    return this->ackArmed;
+}
+
+// an ACK payload that already went out stays sent (ackGone())
+void RadioLink::disarmAck()
+{
+    if (!this->ackGone() && this->ackArmed && !this->transmitting)
+    {
+        this->radio.flush_tx();
+        this->ackArmed = false;
+    }
+}
+
+bool RadioLink::ackConsumed()
+{
+    bool sent = this->ackSent;
+    this->ackSent = false;
+    return sent;
+}
+
+bool RadioLink::ackGone()
+{
+    if (this->ackArmed && this->radio.isFifo(true, true)) // TX FIFO empty -> ACK payload was sent
+    {
+        this->ackArmed = false;
+        this->ackSent = true;
+    }
+    return this->ackSent;
+}
+
+// true as long as the RX FIFO holds payloads since the last RX IRQ
+bool RadioLink::available()
+{
+    if (!this->rxPending)
+    {
+        return false;
+    }
+    if (!this->radio.available(&this->rxPipe))
+    {
+        this->rxPending = false;
+    }
+    return this->rxPending;
+}
+
+// queue a copy of buf for transmission, returns immediately
+bool RadioLink::send(const void *buf, uint8_t len, uint8_t tag, RadioTxCallback callback, const uint8_t *address)
+{
+    if (this->queueCount >= RADIO_TX_QUEUE_LEN || len > RADIO_FRAME_MAX_LEN)
+    {
+        Serial.println(message(MSG_TX_QUEUE_FULL));
+        if (callback)
+        {
+            callback(tag, false);
+        }
+        return false;
+    }
+
+    TxEntry *entry = &this->queue[(this->queueHead + this->queueCount) % RADIO_TX_QUEUE_LEN];
+    memcpy(entry->data, buf, len);
+    entry->len = len;
+    entry->tag = tag;
+    entry->callback = callback;
+    entry->address = address;
+    this->queueCount++;
+
+    this->startNext(); // idle -> go on air now instead of on the next update() (keeps timestamps in payloads fresh)
+
+    return true;
+}
+
+// true while a payload is queued or on air
+bool RadioLink::busy()
+{
+    return this->transmitting || this->queueCount;
+}
+
+void RadioLink::setChannel(uint8_t channel)
+{
+    if (this->listening)
+    {
+        this->stopListening();
+    }
+    this->radio.setChannel(channel);
+    if (this->listening)
+    {
+        this->radio.startListening();
+    }
+}
+
+void RadioLink::setAddress(const uint8_t *txAddress)
+{
+    this->txAddress = txAddress;
+    if (this->listening)
+    {
+        this->stopListening();
+    }
+    this->radio.openWritingPipe(txAddress);
+    if (this->listening)
+    {
+        this->radio.startListening(); // pipe 0 back to its reading address (if any)
+    }
+}
+
+bool RadioLink::slotOpen()
+{
+    return !this->slots || this->slots->open(micros());
+}
+
+// advance the transmit engine, never waits for the radio
+void RadioLink::update()
+{
+    bool txOk, txFail;
+    this->serviceIrq(txOk, txFail);
+
+    if (this->transmitting)
+    {
+        if (txOk && this->attempts < this->broadcastRepeats && !this->queue[this->queueHead].address)
+        {
+            // broadcast: send the same payload again after a back-off (receivers drop the copies by sequence number, a
+            // receiver sending its own frame right now can't hear back-to-back copies)
+            this->transmitting = false;
+            this->startBackoff(RADIO_REPEAT_MICROS);
+        }
+        else if (txOk)
+        {
+            if (this->broadcastRepeats > 0 || this->queue[this->queueHead].address)
+            {
+                this->stats.delivered();
+            }
+            else
+            {
+                uint8_t arc = this->radio.getARC();
+                this->stats.delivered(arc, this->txDoneTime - this->firstAttemptTime);
+                if (this->control)
+                {
+                    this->control->delivered(arc);
+                }
+            }
+            this->finish(true);
+        }
+        else if (txFail || (uint32_t)(micros() - this->attemptStartTime) > RADIO_TX_TIMEOUT_MICROS)
+        {
+            this->radio.flush_tx(); // payload stays in the TX FIFO after MAX_RT
+            this->stats.failedAttempt();
+            if (this->control && txFail)
+            {
+                this->control->failed();
+            }
+            if (this->attempts >= RADIO_TRANSMISSION_MAX_ATTEMPTS)
+            {
+                Serial.println(message(MSG_TX_FAILED_DEFINITIVELY));
+                this->stats.lost();
+                this->finish(false);
+            }
+            else
+            {
+                this->startListening(); // the back-off listens, also while the messages below block loop()
+                Serial.println(message(MSG_TX_FAILED));
+                Serial.println(message(MSG_TX_RETRYING));
+                this->transmitting = false;
+                this->startBackoff();
+            }
+        }
+    }
+
+    if (this->control && !this->transmitting)
+    {
+        this->control->update(); // between two payloads, the settings apply to whole attempts
+    }
+    this->startNext();
+}
+
+// start the next attempt if one is due and the slot is open, otherwise (go back to) listening
+void RadioLink::startNext()
+{
+    if (this->transmitting)
+    {
+        return;
+    }
+    bool slotOpen = this->slotOpen();
+    if (this->attempts && !slotOpen)
+    {
+        this->backoffStart = micros(); // the back-off runs in the own slot (the other boxes of the pair waited for it too)
+    }
+    bool backingOff = this->attempts && (uint32_t)(micros() - this->backoffStart) < this->backoff;
+    if (!this->queueCount || !slotOpen || backingOff)
+    {
+        this->startListening();
+        return;
+    }
+    if (this->listening)
+    {
+        this->stopListening();
+        this->listening = false;
+    }
+    this->startAttempt();
+}
+
+// listen for a random time before the next attempt (also with slots: master and slaves of a pair/group share theirs)
+void RadioLink::startBackoff(uint32_t longest)
+{
+    this->backoffStart = micros();
+    this->backoff = random(longest / 2, longest);
+}
+
+void RadioLink::startListening()
+{
+    if (!this->listening)
+    {
+        this->radio.startListening();
+        this->listening = true;
+    }
+}
+
+// leaving RX flushes the armed ACK payload: if the TX FIFO is already empty, it went out with a received frame whose
+// IRQ update() hasn't read yet (loop() queued a frame in between)
+void RadioLink::stopListening()
+{
+    this->ackGone();
+    this->radio.stopListening();
+    this->ackArmed = false;
+}
+
+void RadioLink::startAttempt()
+{
+    TxEntry *entry = &this->queue[this->queueHead];
+    this->ackArmed = false; // stopListening()/startWrite() flush a preloaded ACK payload
+    this->attempts++;
+    this->attemptStartTime = micros();
+    if (this->attempts == 1)
+    {
+        this->firstAttemptTime = this->attemptStartTime;
+    }
+    this->transmitting = true;
+    if (entry->address)
+    {
+        this->radio.openWritingPipe(entry->address);
+    }
+    this->radio.startWrite(entry->data, entry->len, this->broadcastRepeats > 0 || entry->address); // multicast = no ACK requested
+}
+
+// pop the current payload and report the result (the next payload is started by update())
+void RadioLink::finish(bool success)
+{
+    TxEntry *entry = &this->queue[this->queueHead];
+    RadioTxCallback callback = entry->callback;
+    uint8_t tag = entry->tag;
+
+    if (entry->address)
+    {
+        this->radio.openWritingPipe(this->txAddress);
+    }
+
+    this->queueHead = (this->queueHead + 1) % RADIO_TX_QUEUE_LEN;
+    this->queueCount--;
+    this->transmitting = false;
+    this->attempts = 0;
+    if (!this->queueCount)
+    {
+        this->startListening(); // before the message and callback, a blocking print would leave the radio deaf
+    }
+
+    if (success)
+    {
+        Serial.println(message(MSG_TX_SUCCESSFUL));
+    }
+
+    if (callback)
+    {
+        callback(tag, success);
+    }
+}
@@ -0,0 +1,45 @@
+/* SlotClock Class
+ *  - The beacon source keeps the frame it started at boot, receivers move their frame start to the beacon
+ *    (offset error = unaccounted beacon latency, covered by SLOT_GUARD_MICROS)
+ */
+
+#include "SlotClock.h"
+
+bool SlotClock::open(uint32_t now)
+{
+    if (!this->synced(now))
+    {
+        return true;
+    }
+    uint32_t slotStart = this->slot * this->slotMicros;
+    uint32_t framePhase = this->phase(now);
+    return framePhase >= slotStart && framePhase + SLOT_GUARD_MICROS <= slotStart + this->slotMicros;
+}
+
+bool SlotClock::synced(uint32_t now)
+{
+    return this->source || (this->beaconValid && (uint32_t)(now - this->lastBeacon) < SLOT_BEACON_TIMEOUT_MICROS);
+}
+
+uint32_t SlotClock::phase(uint32_t now)
+{
+    uint32_t period = this->count * this->slotMicros;
+    uint32_t elapsed = now - this->frameStart;
+    if (elapsed >= period)
+    {
+        this->frameStart += elapsed - elapsed % period;
+        elapsed %= period;
+    }
+    return elapsed;
+}
+
+void SlotClock::beacon(uint32_t phase, uint32_t rxTime)
+{
+    if (this->source)
+    {
+        return;
+    }
+    this->frameStart = rxTime - phase;
+    this->lastBeacon = rxTime;
+    this->beaconValid = true;
+}
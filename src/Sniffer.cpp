@@ -0,0 +1,75 @@
+/* Sniffer Class
+ *  - Timestamps are taken when the frame is read (polled, up to one loop after the end of the frame)
+ */
+
+#include "Sniffer.h"
+#include "settings.h"
+
+void Sniffer::begin(uint8_t addresses[][6], uint8_t count, uint8_t channel)
+{
+    this->addresses = addresses;
+    this->count = min(count, (uint8_t)SNIFFER_PIPES);
+    this->sweep = channel == SNIFFER_SWEEP;
+
+    this->radio.setAutoAck(false);           // never ACK (would collide with the real receiver's ACK)
+    this->radio.disableDynamicPayloads();    // the packet control field stays in the raw payload
+    this->radio.setPayloadSize(SNIFFER_RAW_LEN);
+    this->radio.disableCRC();                // CRC is checked on the host (also over the packet control field)
+    for (uint8_t pipe = 0; pipe < this->count; pipe++)
+    {
+        this->radio.openReadingPipe(pipe, this->addresses[pipe]); // pipes 2-5 only use the first byte
+    }
+    this->tune(this->sweep ? 0 : channel);
+    this->lastAddressTime = micros() - SNIFFER_ADDRESS_MICROS; // address records right away
+}
+
+void Sniffer::update()
+{
+    uint32_t now = micros();
+    uint8_t pipe;
+    if (this->radio.available(&pipe))
+    {
+        uint8_t record[4 + 2 + SNIFFER_RAW_LEN];
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            record[i] = now >> (8 * i);
+        }
+        record[4] = this->channel;
+        record[5] = pipe;
+        this->radio.read(&record[6], SNIFFER_RAW_LEN);
+        this->writeRecord(SNIFFER_RECORD_CAPTURE, record, sizeof(record));
+        this->dwellStart = now; // traffic -> stay on this channel
+    }
+    else if (this->sweep && (uint32_t)(now - this->dwellStart) > SNIFFER_DWELL_MICROS)
+    {
+        this->tune(this->channel < RADIO_SURVEY_MAX_CHANNEL ? this->channel + 1 : 0);
+    }
+
+    if ((uint32_t)(now - this->lastAddressTime) > SNIFFER_ADDRESS_MICROS)
+    {
+        this->lastAddressTime = now;
+        for (uint8_t pipe = 0; pipe < this->count; pipe++)
+        {
+            uint8_t record[6] = {pipe};
+            memcpy(&record[1], this->addresses[pipe], 5);
+            this->writeRecord(SNIFFER_RECORD_ADDRESS, record, sizeof(record));
+        }
+    }
+}
+
+void Sniffer::tune(uint8_t channel)
+{
+    this->radio.stopListening();
+    this->radio.setChannel(channel);
+    this->radio.startListening();
+    this->channel = channel;
+    this->dwellStart = micros();
+}
+
+void Sniffer::writeRecord(uint8_t type, const uint8_t *data, uint8_t len)
+{
+    Serial.write(SNIFFER_SYNC);
+    Serial.write(type);
+    Serial.write(len);
+    Serial.write(data, len);
+}
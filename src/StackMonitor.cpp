@@ -0,0 +1,68 @@
+#include "StackMonitor.h"
+
+void StackMonitor::paint()
+{
+    uint8_t *end = stackPointer() - STACK_PAINT_MARGIN;
+    for (volatile uint8_t *p = heapEnd(); p < end; p++) // no call in here, its frame would be painted over
+    {
+        *p = STACK_CANARY;
+    }
+    this->paintedEnd = end;
+}
+
+void StackMonitor::start()
+{
+    this->loopBase = stackPointer();
+}
+
+void StackMonitor::print()
+{
+    Serial.print(F("Stack: free="));
+    Serial.print(this->freeNow());
+    Serial.print(F(" gap="));
+    Serial.print(this->smallestGap());
+    Serial.print(F(" depth="));
+    Serial.println(this->deepestLoop());
+}
+
+uint16_t StackMonitor::freeNow()
+{
+    return stackPointer() - heapEnd();
+}
+
+uint16_t StackMonitor::smallestGap()
+{
+    return this->paintedEnd ? this->lowest() - heapEnd() : 0;
+}
+
+uint16_t StackMonitor::deepestLoop()
+{
+    if (!this->paintedEnd || !this->loopBase)
+    {
+        return 0;
+    }
+    uint8_t *low = this->lowest();
+    return low < this->loopBase ? this->loopBase - low : 0;
+}
+
+uint8_t *StackMonitor::heapEnd()
+{
+    return (uint8_t *)__malloc_heap_start;
+}
+
+// SP points at the next free byte, the stack grows down towards the heap
+uint8_t *StackMonitor::stackPointer()
+{
+    return (uint8_t *)(uintptr_t)SP;
+}
+
+// paint still left from the heap up, the stack got as far as its end (or overflowed into the heap if there is none)
+uint8_t *StackMonitor::lowest()
+{
+    volatile uint8_t *p = heapEnd();
+    while (p < this->paintedEnd && *p == STACK_CANARY)
+    {
+        p++;
+    }
+    return (uint8_t *)p;
+}
@@ -0,0 +1,137 @@
+/* Trace Class
+ *  - Every record is one Serial.print() sequence ending with a newline, the lines of the task logic stay whole
+ *  - Nothing is written unless TRACE_ENABLED (the calls stay in place, so the traced code is the code that runs)
+ */
+
+#include "Trace.h"
+
+Trace trace;
+
+void Trace::begin(uint8_t role)
+{
+    if (!TRACE_ENABLED)
+    {
+        return;
+    }
+    this->start('H');
+    this->hex(TRACE_VERSION, 2);
+    this->hex(role, 2);
+    this->hex(micros(), 8);
+    this->hex(PIND, 2);
+    this->hex(SYNCH_MICROS, 8);
+    this->hex(ITI_MICROS, 8);
+    this->hex(LONG_TIMEOUT_MICROS, 8);
+    this->hex(SYNCH_PULL_MAX, 2);
+    this->hex(MODE_TEST_ONE_COUNT, 2);
+    this->hex(MODE_TEST_TWO_COUNT, 2);
+    this->hex(MODE_TEST_THREE_COUNT, 2);
+    Serial.println();
+}
+
+void Trace::seed(uint32_t seed)
+{
+    if (!TRACE_ENABLED)
+    {
+        return;
+    }
+    this->start('N');
+    this->hex(seed, 8);
+    Serial.println();
+}
+
+void Trace::pairing(uint32_t id, uint8_t version, uint32_t group, uint8_t member, uint8_t channel)
+{
+    if (!TRACE_ENABLED)
+    {
+        return;
+    }
+    this->start('P');
+    this->hex(id, 8);
+    this->hex(version, 2);
+    this->hex(group, 8);
+    this->hex(member, 2);
+    this->hex(channel, 2);
+    Serial.println();
+}
+
+void Trace::lever(uint32_t time, uint8_t pins)
+{
+    if (!TRACE_ENABLED)
+    {
+        return;
+    }
+    this->start('L');
+    this->hex(time, 8);
+    this->hex(pins, 2);
+    Serial.println();
+}
+
+void Trace::remote(uint32_t time, uint8_t level)
+{
+    if (!TRACE_ENABLED || level == this->remoteLevel)
+    {
+        return;
+    }
+    this->remoteLevel = level;
+    this->start('R');
+    this->hex(time, 8);
+    this->hex(level, 1);
+    Serial.println();
+}
+
+void Trace::frame(uint32_t time, uint8_t pipe, const uint8_t *data, uint8_t len)
+{
+    if (!TRACE_ENABLED)
+    {
+        return;
+    }
+    this->start('F');
+    this->hex(time, 8);
+    this->hex(pipe, 1);
+    for (uint8_t i = 0; i < len; i++)
+    {
+        this->hex(data[i], 2);
+    }
+    Serial.println();
+}
+
+void Trace::transmitted(uint32_t time, bool delivered, uint8_t arc)
+{
+    if (!TRACE_ENABLED)
+    {
+        return;
+    }
+    this->start('T');
+    this->hex(time, 8);
+    this->hex(delivered, 1);
+    this->hex(arc, 1);
+    Serial.println();
+}
+
+void Trace::serialInput(uint32_t time, uint8_t c)
+{
+    if (!TRACE_ENABLED)
+    {
+        return;
+    }
+    this->start('S');
+    this->hex(time, 8);
+    this->hex(c, 2);
+    Serial.println();
+}
+
+void Trace::start(char type)
+{
+    Serial.write(TRACE_MARK);
+    Serial.write(type);
+}
+
+// fixed width, leading zeros (Serial.print(value, HEX) drops them)
+void Trace::hex(uint32_t value, uint8_t digits)
+{
+    while (digits--)
+    {
+        uint8_t nibble = value >> (4 * digits) & 0x0F;
+        Serial.write(nibble < 10 ? '0' + nibble : 'A' + nibble - 10);
+    }
+}
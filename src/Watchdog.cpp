@@ -0,0 +1,90 @@
+#include "Watchdog.h"
+
+#include "Messages.h"
+#include "settings.h"
+
+static_assert(MSG_WD_TASK - MSG_WD_SETUP == WATCHDOG_TASK, "Messages.h lists the loop phases in the order of watchdog_phase");
+
+Watchdog watchdog;
+Watchdog::Record Watchdog::record __attribute__((section(".noinit")));
+
+#ifdef __AVR__
+static uint8_t resetFlags __attribute__((section(".noinit")));
+
+// runs before the constructors (.init3): Optiboot may have cleared MCUSR, it passes the flags in r2
+static void readResetFlags() __attribute__((naked, used, section(".init3")));
+static void readResetFlags()
+{
+    uint8_t bootloaderFlags;
+    __asm__ __volatile__("mov %0, r2" : "=r"(bootloaderFlags));
+    resetFlags = bootloaderFlags | MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+#endif
+
+void Watchdog::begin(uint8_t mode, uint8_t goal)
+{
+#ifdef __AVR__
+    uint8_t flags = resetFlags;
+#else
+    uint8_t flags = MCUSR;
+    MCUSR = 0;
+#endif
+    if (!WATCHDOG_ENABLED)
+    {
+        return;
+    }
+    this->stalled = (flags & _BV(WDRF)) && record.magic == WATCHDOG_MAGIC && record.phase < WATCHDOG_PHASES;
+    if (this->stalled)
+    {
+        this->mode = record.mode;
+        this->goal = record.goal;
+        this->stallMillis = WATCHDOG_MILLIS(record.phase == WATCHDOG_SETUP ? WATCHDOG_SETUP_TIMEOUT : WATCHDOG_TIMEOUT);
+        Serial.print(message(MSG_ALERT));
+        Serial.print(F("Watchdog: reset phase="));
+        Serial.print(message(MSG_WD_SETUP, record.phase));
+        Serial.print(F(" at="));
+        Serial.println(record.loopMillis);
+    }
+    else
+    {
+        this->mode = mode;
+        this->goal = goal;
+    }
+    record.magic = WATCHDOG_MAGIC;
+    record.loopMillis = millis();
+    record.phase = WATCHDOG_SETUP;
+    record.mode = this->mode; // a stall in setup() resumes the same session
+    record.goal = this->goal;
+    wdt_enable(WATCHDOG_SETUP_TIMEOUT);
+}
+
+void Watchdog::resume()
+{
+    if (!WATCHDOG_ENABLED)
+    {
+        return;
+    }
+    wdt_enable(WATCHDOG_TIMEOUT);
+    if (this->stalled)
+    {
+        Serial.print(message(MSG_ALERT));
+        Serial.print(F("Watchdog: resumed locked recovery="));
+        Serial.println(this->stallMillis + millis());
+    }
+}
+
+void Watchdog::kick(uint8_t mode, uint8_t goal)
+{
+    wdt_reset();
+    record.loopMillis = millis();
+    record.phase = WATCHDOG_LEVER;
+    record.mode = mode;
+    record.goal = goal;
+}
+
+void Watchdog::enter(watchdog_phase phase)
+{
+    record.phase = phase;
+}
@@ -5,21 +5,88 @@
 #include <Arduino.h>
 
 #include "Apparatus.h"
+#include "ChannelSurvey.h"
+#include "ClockSync.h"
+#include "EventLog.h"
+#include "Frame.h"
+#include "Group.h"
+#include "Heartbeat.h"
+#include "LinkControl.h"
+#include "LoopProfiler.h"
+#include "Messages.h"
+#include "Pairing.h"
+#include "RadioLink.h"
+#include "SlotClock.h"
+#include "Sniffer.h"
+#include "StackMonitor.h"
+#include "Trace.h"
+#include "Watchdog.h"
 #include "remote.h"
 #include "settings.h"
 
+#include <NeoSWSerial.h>
 #include <RF24.h>
-#include <SoftwareSerial.h>
 
 #if ENABLE_AUDIO
 #include <DFRobotDFPlayerMini.h>
 #endif
 
+#if RADIO_ROLE == RADIO_SNIFFER
+// SNIFFER =========================================================================
+// passive capture only, none of the task procedure below is compiled (see Sniffer.h)
+RF24 radio(RADIO_CE_PIN, RADIO_CSN_PIN);
+Sniffer sniffer(radio);
+uint8_t addresses[SNIFFER_PIPES][6]; // by reading pipe: pipe 0 = member 5 (beacon in slotted mode), pipes 1-5 = members 0-4
+
+void setup()
+{
+  Serial.begin(SNIFFER_BAUD);
+  if (!radio.begin())
+  {
+    while (true)
+    {
+      // hold in infinite loop (no text on the binary stream)
+    }
+  }
+  radio.setDataRate(RF24_250KBPS);
+
+  // same addresses as openLink() of the pair/group
+  Pairing pairing;
+  pairing.record.group = SNIFFER_GROUP;
+  for (uint8_t member = 0; member < GROUP_MAX_SIZE; member++)
+  {
+    uint8_t *address = addresses[(member + 1) % SNIFFER_PIPES];
+    memcpy(address, "0Node", 6);
+    address[0] += member;
+    address[3] += RADIO_CHANNEL;
+    address[4] += RADIO_SLOT_ID;
+    if (SNIFFER_GROUP)
+    {
+      pairing.address(member, address);
+    }
+  }
+#if RADIO_SLOT_COUNT
+  memcpy(addresses[0], "Beacn", 6);
+#endif
+  sniffer.begin(addresses, SNIFFER_PIPES, SNIFFER_CHANNEL);
+}
+
+void loop()
+{
+  sniffer.update();
+}
+
+#else
+
 Apparatus apr;
-char buffer[50];
 
 Remote remote(REMOTE_PIN);
 
+#if LOOP_PROFILE_ENABLED
+LoopProfiler profiler; // phase durations of loop() (LOOP_PROFILE_REQUEST over serial)
+#endif
+StackMonitor stackMonitor; // free SRAM and stack depth (STACK_REQUEST over serial)
+
 // STATE MACHINES ---------------------------------------------------------------
 // State machine for TASK PROTOCOL
 enum ST_STATES
@@ -66,8 +133,36 @@ LOCK_STATUS currentLockStatus = UNLOCKED;
 
 uint8_t waitTimerEnabled = false; // used in ST_WAIT (needs to be global so it can be reset in different stages)
 
+static_assert(MSG_ST_WAIT - MSG_ST_START == ST_WAIT && MSG_MD_TWO - MSG_MD_ONE == MD_TWO,
+              "Messages.h lists the state and mode names in the order of ST_STATES and MD_MODES");
+
+// function that reports a state transition: binary record (EVENT_LOG_ENABLED) or the "State: " line
+void printState(ST_STATES state)
+{
+  if (EVENT_LOG_ENABLED)
+  {
+    eventLog.log(EVENT_STATE, state);
+    return;
+  }
+  Serial.print(message(MSG_STATE));
+  Serial.println(message(MSG_ST_START, state));
+}
+
+// function that reports a mode switch
+void printMode(MD_MODES mode)
+{
+  Serial.print(message(MSG_MODE));
+  Serial.println(message(MSG_MD_ONE, mode));
+}
+
 // AUDIO -------------------------------------------------------------------------
-SoftwareSerial softwareSerial(AUDIO_RX_PIN, AUDIO_TX_PIN);
+// NeoSWSerial is built with NEOSWSERIAL_EXTERNAL_PCINT (see platformio.ini), so the pin-change vectors stay free for
+// the lever edge capture (PCINT2) and the audio RX pin (port C) is forwarded here
+NeoSWSerial softwareSerial(AUDIO_RX_PIN, AUDIO_TX_PIN);
+ISR(PCINT1_vect)
+{
+  NeoSWSerial::rxISR(PINC);
+}
 #if ENABLE_AUDIO
 DFRobotDFPlayerMini audioPlayer;
 #endif
@@ -84,61 +179,532 @@ uint8_t playTone(uint8_t folder, uint8_t file)
 #if RADIO_ROLE != RADIO_TRAINING // TESTING
 RF24 radio(RADIO_CE_PIN, RADIO_CSN_PIN);
 
-const uint8_t addresses[][6] = {"Node0", "Node1"}; // Addresses of slave and master
+static_assert(RADIO_GROUP_SIZE >= 2 && RADIO_GROUP_SIZE <= GROUP_MAX_SIZE, "RADIO_GROUP_SIZE must be 2-6");
+static_assert(RADIO_MEMBER_ID >= 1 && RADIO_MEMBER_ID < RADIO_GROUP_SIZE, "RADIO_MEMBER_ID must be 1 to RADIO_GROUP_SIZE - 1");
 
-struct PayloadStruct
+// Address of the master (all slaves listen to it) and of each slave (master reading pipes 1-5), set in openLink()
+// (pipes 2-5 only differ from pipe 1 in the first byte)
+uint8_t addresses[GROUP_MAX_SIZE][6];
+uint8_t radioChannel = RADIO_CHANNEL; // channel of the link (from the pairing record once paired)
+uint8_t memberId = RADIO_MEMBER_ID;   // slave: own member number (from the pairing record once paired)
+
+#if RADIO_SLOT_COUNT
+static_assert(RADIO_SLOT_ID < RADIO_SLOT_COUNT, "RADIO_SLOT_ID must be 0 to RADIO_SLOT_COUNT - 1");
+static_assert(SLOT_GUARD_MICROS < RADIO_SLOT_MICROS, "RADIO_SLOT_MICROS too short for one transmission attempt");
+const uint8_t beaconAddress[6] = "Beacn"; // all boxes listen to the beacon on pipe 0
+SlotClock slots(RADIO_SLOT_ID, RADIO_SLOT_COUNT, RADIO_SLOT_MICROS, RADIO_ROLE == RADIO_MASTER && RADIO_SLOT_ID == 0);
+#endif
+
+#if RADIO_ROLE == RADIO_MASTER
+#define RADIO_PEERS (RADIO_GROUP_SIZE - 1) // master receives from every slave
+#else
+#define RADIO_PEERS 1 // slave only receives from the master
+#endif
+
+uint8_t txSeq = 0;             // sequence number of the next frame sent
+#if RADIO_ROLE == RADIO_MASTER
+Frame armedFrame; // preloaded as ACK payload: instruction for a synchronous pull in ST_SYNCBOXES, heartbeat otherwise
+#endif
+SeqTracker rxSeq[RADIO_PEERS]; // sequence numbers of received frames per sender (duplicates, gaps)
+Frame frameReceived;           // last accepted frame
+uint8_t framePeer = 0;         // sender of frameReceived (index into rxSeq, on the master = member number - 1 of the slave)
+Heartbeat heartbeat[RADIO_PEERS]; // liveness of each slave (master) or of the master (slave)
+
+RadioLink radioLink(radio); // non-blocking transmit engine (see RadioLink.cpp)
+#if RADIO_ADAPTIVE_ENABLED
+LinkControl linkControl(radio, RADIO_PA_LEVEL, RADIO_PA_LEVEL_MAX); // adaptive retries and PA level (see LinkControl.cpp)
+#endif
+
+// tags to tell queued payloads apart in onPayloadSent
+enum TX_TAGS
 {
-  bool pullDetected = false;       // lever pulled in slave (m <- s)
-  bool triggerReward = false;      // trigger reward in slave (m -> s)
-  bool longTimeoutEnabled = false; // enable long timeout in slave (m -> s)
-  bool lockLever = false;          // lock lever in slave (m -> s)
-  bool remoteLock = false;         // lock/unlock both levers on remote press (m -> s)
-  uint8_t count = 0;               // count of attempted transmissions (m -> s and m <- s)
+  TX_COMMAND,    // task instructions and status (failure is reported)
+  TX_PULL,       // lever pull (failure is reported, its ACK may carry the master's answer)
+  TX_CLOCK_SYNC, // ping/pong (failure is silent, next ping follows anyway)
+  TX_BEACON,     // slot beacon (no ACK, never fails)
+  TX_CHANNEL,    // channel negotiation (failure is silent, master proposes again)
+  TX_PAIR,       // pairing (failure is silent, master offers again)
+  TX_NONE
 };
-PayloadStruct payload;
-PayloadStruct payloadReceived;
+
+#if RADIO_PAIRING_ENABLED
+Pairing pairing;
+const uint8_t pairingAddresses[2][6] = {"PairM", "PairS"}; // master, slave while pairing
+bool pairingActive = false; // master: pairing session running, slave: waiting for an offer
+bool relinkPending = false; // pairing started/ended, openLink() once the radio is idle
+#if RADIO_ROLE == RADIO_MASTER
+uint8_t pairingMember = 1; // member number offered
+#else
+PairingRecord pairingOffer; // accepted offer, saved once the answer was delivered
+#endif
+#else
+const bool pairingActive = false;
+#endif
+
+#if RADIO_CHANNEL_SURVEY
+static_assert(!RADIO_SLOT_COUNT, "Slotted mode keeps all pairs on RADIO_CHANNEL, disable RADIO_CHANNEL_SURVEY");
+ChannelSurvey survey(radio);
+bool onSurveyChannel = false;      // moved from radioChannel to the negotiated channel
+uint32_t peerRxTimer[RADIO_PEERS]; // last frame received from each peer (silence -> back to radioChannel)
+uint8_t surveyChannel = 0;         // negotiated channel (master: being switched to, slave: switch pending if surveySwitch)
+#if RADIO_ROLE == RADIO_MASTER
+uint8_t surveyAnswers = 0; // bitfield, slaves that answered the proposal
+#else
+bool surveySwitch = false;
+#endif
+
+// function that moves the link to another channel (master and slaves must agree on it)
+void switchChannel(uint8_t channel)
+{
+  radioLink.setChannel(channel);
+  onSurveyChannel = channel != radioChannel;
+  for (uint8_t peer = 0; peer < RADIO_PEERS; peer++)
+  {
+    peerRxTimer[peer] = micros(); // peers get SURVEY_SILENCE_MICROS to show up on the new channel
+  }
+  Serial.print(message(MSG_CHANNEL));
+  Serial.println(channel);
+}
+
+// function that goes back to radioChannel when a peer fell silent on the negotiated channel (e.g. slave restarted)
+void checkChannelSilence()
+{
+  if (!onSurveyChannel || radioLink.busy())
+  {
+    return;
+  }
+  for (uint8_t peer = 0; peer < RADIO_PEERS; peer++)
+  {
+    if ((uint32_t)(micros() - peerRxTimer[peer]) > SURVEY_SILENCE_MICROS)
+    {
+      Serial.println(message(MSG_LINK_SILENT));
+      switchChannel(radioChannel);
+#if RADIO_ROLE == RADIO_MASTER
+      surveyAnswers = 0; // negotiate again
+#endif
+      return;
+    }
+  }
+}
+#endif
 
 #if RADIO_ROLE == RADIO_SLAVE
 bool triggerReward = false;
 bool lockLever = false;
 bool remoteLock = false;
+uint8_t lastAckedTag = TX_NONE; // tag of the last delivered frame (an ACK payload belongs to it)
+#endif
+
+// called by radioLink once a payload was delivered or given up after RADIO_TRANSMISSION_MAX_ATTEMPTS
+void onPayloadSent(uint8_t tag, bool success)
+{
+  if (!success && (tag == TX_COMMAND || tag == TX_PULL))
+  {
+    playTone(AUDIO_FOLDER, AUDIO_SOUND_TRANSMISSION_FAIL);
+  }
+#if RADIO_ROLE == RADIO_SLAVE
+  lastAckedTag = success ? tag : (uint8_t)TX_NONE;
+#endif
+#if RADIO_PAIRING_ENABLED && RADIO_ROLE == RADIO_SLAVE
+  if (tag == TX_PAIR && success && pairingActive) // master has the answer, the pairing is complete
+  {
+    pairing.save(pairingOffer.group, pairingOffer.member, pairingOffer.channel);
+    pairingActive = false;
+    relinkPending = true;
+    Serial.print(message(MSG_PAIRING_MEMBER));
+    Serial.println(pairingOffer.member);
+    playTone(AUDIO_FOLDER, AUDIO_SOUND_START);
+  }
+#endif
+#if RADIO_CHANNEL_SURVEY && RADIO_ROLE == RADIO_MASTER
+  if (tag == TX_CHANNEL && surveyAnswers) // switch decision went out (slaves switch on receipt)
+  {
+    if (success)
+    {
+      switchChannel(surveyChannel);
+    }
+    surveyAnswers = 0; // failed -> propose again
+  }
+#endif
+}
+
+#if RADIO_ROLE == RADIO_MASTER
+// the armed ACK payload has txSeq until it goes out, then the number is used up (also while the frame it went with
+// isn't read yet, a frame sent now must not get the same number)
+void useArmedSeq()
+{
+  if (radioLink.ackGone() && armedFrame.seq == txSeq)
+  {
+    txSeq++;
+  }
+}
+#endif
+
+// function that queues a frame for transmission to the receiver (returns immediately, result via onPayloadSent)
+// newSeq == false repeats a frame under its old sequence number (receiver drops it if it already has it)
+// address != NULL sends the frame once without ACK to that address instead of the receiver
+uint8_t sendFrame(Frame *frame, uint8_t tag = TX_COMMAND, bool newSeq = true, const uint8_t *address = NULL)
+{
+  static_assert(FRAME_MAX_LEN <= RADIO_FRAME_MAX_LEN, "Frame too large for the RadioLink queue");
+  uint8_t buf[FRAME_MAX_LEN];
+
+  if (newSeq)
+  {
+#if RADIO_ROLE == RADIO_MASTER
+    radioLink.disarmAck(); // armed under the number this frame takes, it may wait for its slot while the radio listens (updateAckPayload() arms the next)
+    useArmedSeq();
+#endif
+    frame->seq = txSeq++; // one number per frame, retries of the same frame keep it
+  }
+  uint8_t len = frameEncode(frame, buf);
+
+#if PRINT_DEBUG
+  Serial.print(F("Send frame: Type="));
+  Serial.print(frame->type);
+  Serial.print(F(", Seq="));
+  Serial.print(frame->seq);
+  Serial.print(F(", Flags="));
+  Serial.print(frame->flags, BIN);
+  Serial.print(F(", Size="));
+  Serial.println(len);
 #endif
 
-// function that transmits a payload to a receiver
-uint8_t sendPayload(PayloadStruct *payloadFunc)
+  return radioLink.send(buf, len, tag, onPayloadSent, address);
+}
+
+// function that queues a command frame with the given FRAME_FLAG_ instructions
+uint8_t sendCommand(uint8_t flags)
+{
+  Frame frame;
+  frame.type = FRAME_COMMAND;
+  frame.flags = flags;
+  return sendFrame(&frame);
+}
+
+// function that prints the name of a link partner (index into rxSeq/heartbeat)
+void printPeer(uint8_t peer)
 {
-  radio.stopListening();
-  bool report = false;
-  uint16_t attempts = 1;
+#if RADIO_ROLE == RADIO_MASTER
+  Serial.print(message(MSG_SLAVE));
+  Serial.print(peer + 1);
+#else
+  (void)peer; // a slave's only partner is the master
+  Serial.print(message(MSG_MASTER));
+#endif
+}
 
-  while (!report && attempts <= RADIO_TRANSMISSION_MAX_ATTEMPTS)
+// function that reports link partners that fell silent (no frame for HEARTBEAT_TIMEOUT_MICROS)
+void checkHeartbeats()
+{
+  for (uint8_t peer = 0; peer < RADIO_PEERS; peer++)
   {
-    if (attempts > 1)
+    if (heartbeat[peer].expired(micros()))
     {
-      Serial.println("*** Transmission failed!");
-      Serial.println("Retrying ...");
+      Serial.print(message(MSG_ALERT));
+      printPeer(peer);
+      Serial.println(message(MSG_LINK_LOST));
+      playTone(AUDIO_FOLDER, AUDIO_SOUND_TRANSMISSION_FAIL);
     }
-    report = radio.write(payloadFunc, sizeof(*payloadFunc));
-    attempts++;
   }
-  if (attempts > RADIO_TRANSMISSION_MAX_ATTEMPTS)
+}
+
+// function that packs the state master and slaves must agree on (carried by every ping, the master's is authoritative);
+// longTimeoutEnabled isn't part of it: it comes with each reward command and master and slave clear it at the end of
+// their own wait, so the two legitimately differ for a while after every long timeout
+uint32_t packState()
+{
+  return (uint32_t)currentLockStatus | (uint32_t)currentMode << 8 | (uint32_t)synchPullCount << 16;
+}
+
+#if RADIO_ROLE == RADIO_SLAVE
+// function that takes over the master's state from a heartbeat once it differs from the own state (e.g. slave rebooted,
+// remote lock toggle lost); mode and synch pull count are only mirrored, the master alone decides on them
+void syncState(uint32_t masterState)
+{
+  currentMode = (MD_MODES)(masterState >> 8 & 0xFF);
+  synchPullCount = masterState >> 16 & 0xFF;
+  if (!heartbeat[0].differs(packState(), masterState))
+  {
+    return;
+  }
+  Serial.print(message(MSG_STATE_RESYNCHRONISED));
+  Serial.println(masterState, HEX);
+  if ((masterState & 0xFF) != currentLockStatus)
   {
-    Serial.println("*** Transmission failed definitively for this payload!");
-    playTone(AUDIO_FOLDER, AUDIO_SOUND_TRANSMISSION_FAIL);
+    remoteLock = true; // same transition as the master's remote toggle
+  }
+}
+#endif
+
+// function that reads one payload from the radio into frameReceived, false if corrupt, invalid or a duplicate
+bool receiveFrame()
+{
+  uint8_t buf[32];
+  uint8_t len = radio.getDynamicPayloadSize();
+  if (!len) // If a corrupt payload (!len) is received, it will be flushed
+  {
+    Serial.println(message(MSG_CORRUPT_PAYLOAD));
+    return false;
+  }
+  radio.read(buf, len);
+  trace.frame(radioLink.rxTime, radioLink.rxPipe, buf, len);
+
+  if (!frameDecode(buf, len, &frameReceived))
+  {
+    Serial.println(message(MSG_INVALID_FRAME));
+    return false;
+  }
+
+#if PRINT_DEBUG
+  Serial.print(F("Received frame: Size="));
+  Serial.print(len);
+  Serial.print(F(", Type="));
+  Serial.print(frameReceived.type);
+  Serial.print(F(", Seq="));
+  Serial.print(frameReceived.seq);
+  Serial.print(F(", Flags="));
+  Serial.println(frameReceived.flags, BIN);
+#endif
+
+#if RADIO_SLOT_COUNT
+  if (frameReceived.type == FRAME_BEACON) // from the slot 0 master (any pair), outside the sequence numbering
+  {
+    slots.beacon(frameReceived.time[0], radioLink.rxTime - frameAirMicros(len));
+    return false;
+  }
+#endif
+
+#if RADIO_ROLE == RADIO_MASTER
+  if (radioLink.rxPipe < 1 || radioLink.rxPipe > RADIO_PEERS)
+  {
+    Serial.println(message(MSG_UNKNOWN_PIPE));
+    return false;
+  }
+  framePeer = radioLink.rxPipe - 1; // slave n sends to the address of reading pipe n
+#endif
+#if RADIO_ROLE == RADIO_SLAVE
+  if (frameReceived.type == FRAME_COMMAND && (frameReceived.flags & FRAME_FLAG_ON_PULL) && lastAckedTag != TX_PULL)
+  {
+    // ACK payload meant for a pull was attached to another frame -> ignore, before its sequence number is taken (the
+    // master repeats the instruction under it if it can't tell which frame the ACK went with)
+    return false;
+  }
+#endif
+
+  if (!rxSeq[framePeer].accept(frameReceived.seq, radioLink.rxTime)) // retransmission of a frame that was already handled
+  {
+    Serial.println(message(MSG_DUPLICATE_FRAME));
+    return false;
+  }
+  if (heartbeat[framePeer].seen(radioLink.rxTime))
+  {
+    printPeer(framePeer);
+    Serial.println(message(MSG_LINK_BACK));
+  }
+#if RADIO_CHANNEL_SURVEY
+  peerRxTimer[framePeer] = radioLink.rxTime;
+#endif
+  return true;
+}
+
+#if RADIO_ROLE == RADIO_MASTER
+Group group(RADIO_GROUP_SIZE);     // last lever pull of the master (member 0) and of each slave (master clock)
+ClockSync clockSync[RADIO_PEERS]; // offset/drift of each slave clock, from ping/pong round trips
+
+bool armedCommandSent = false; // armedFrame went out with the ACK of a slave pull, ST_SYNCBOXES has to follow it
+
+// instruction a synchronous slave pull would cause right now (mirrors ST_SYNCBOXES)
+uint8_t synchPullFlags()
+{
+  if (synchPullCount + 1 >= currentModeSynchPullGoal)
+  {
+    return FRAME_FLAG_TRIGGER_REWARD | ((longTimeoutEnabled || totalSynchPullCount + 1 >= SYNCH_PULL_MAX) ? FRAME_FLAG_LONG_TIMEOUT : 0);
+  }
+  else if (EACH_SYNCH_PULL_TIMEOUT_ENABLED)
+  {
+    return FRAME_FLAG_LOCK_LEVER;
+  }
+  return 0;
+}
+
+// keep the ACK payload armed: the instruction for a synchronous pull while in ST_SYNCBOXES, otherwise the own state as
+// heartbeat, so every pull and pong of the slave brings back the lock, long timeout and mode it has to follow
+void updateAckPayload()
+{
+  // only for pairs, in a group the pull of one slave doesn't decide the quorum (and slave pipes can't share one ACK payload)
+  bool enabled = RADIO_ACK_PAYLOAD_ENABLED && RADIO_GROUP_SIZE == 2 && !pairingActive;
+  uint8_t flags = (enabled && currentState == ST_SYNCBOXES) ? synchPullFlags() : 0;
+  Frame frame;
+  frame.type = flags ? FRAME_COMMAND : FRAME_STATE;
+  frame.flags = flags ? flags | FRAME_FLAG_ON_PULL : 0;
+  frame.time[0] = flags ? 0 : packState();
+  bool keep = enabled && !armedCommandSent && radioLink.ackArmed && armedFrame.type == frame.type && armedFrame.flags == frame.flags && armedFrame.time[0] == frame.time[0];
+
+  if (!keep)
+  {
+    useArmedSeq(); // the payload about to be replaced may be gone already (a repeated frame takes it without an IRQ)
+  }
+  if (radioLink.ackSent)
+  {
+    // went out, the frame it went with isn't read yet (or was a repeat): armedFrame has to stay what the slave got
+  }
+  else if (!enabled || armedCommandSent) // armedFrame keeps the instruction until ST_SYNCBOXES repeats it
+  {
+    radioLink.disarmAck();
+  }
+  else if (!keep)
+  {
+    uint8_t buf[FRAME_MAX_LEN];
+    armedFrame = frame;
+    armedFrame.seq = txSeq; // only used up once the ACK payload is sent
+    radioLink.armAck(buf, frameEncode(&armedFrame, buf));
+  }
+}
+
+// function that instructs the slave after a synchronous pull, unless the instruction already went out in the ACK payload
+void sendSynchPullCommand(uint8_t flags)
+{
+  if (armedCommandSent)
+  {
+    // repeat under the same sequence number in case the ACK got lost (slave drops it as duplicate otherwise)
+    armedFrame.flags &= ~FRAME_FLAG_ON_PULL;
+    sendFrame(&armedFrame, TX_COMMAND, false);
+    armedCommandSent = false;
   }
   else
   {
-    Serial.println("Transmission successfull!");
+    sendCommand(flags);
   }
+}
+#endif
 
-  radio.startListening();
+#if RADIO_PAIRING_ENABLED && RADIO_ROLE == RADIO_MASTER
+// channel offered to the slaves, pseudo random from the ID so different pairs spread over the band
+uint8_t pairingChannel()
+{
+#if RADIO_SLOT_COUNT
+  return RADIO_CHANNEL; // slotted pairs share one channel
+#else
+  uint8_t channel = pairing.id % (RADIO_SURVEY_MAX_CHANNEL + 1);
+  return channel == RADIO_PAIRING_CHANNEL ? channel + 1 : channel;
+#endif
+}
+#endif
 
-  return report;
+// function that prints the link quality record (on LINK_STATS_REQUEST over serial):
+// "Link: up=<s> ch=<channel> tx=... arc=... rtt=... rx<member>=<received>,<duplicates>,<missed> ..."
+void printLinkStats()
+{
+  Serial.print(F("Link: up="));
+  Serial.print(micros() / 1000000); // wraps after 71 min like micros()
+  Serial.print(F(" ch="));
+  Serial.print(radio.getChannel());
+  Serial.print(' ');
+  radioLink.stats.print();
+#if RADIO_ADAPTIVE_ENABLED
+  Serial.print(' ');
+  linkControl.print();
+#endif
+  for (uint8_t peer = 0; peer < RADIO_PEERS; peer++)
+  {
+    Serial.print(F(" rx"));
+    Serial.print(RADIO_ROLE == RADIO_MASTER ? peer + 1 : 0); // member number of the sender
+    Serial.print('=');
+    Serial.print(rxSeq[peer].received);
+    Serial.print(',');
+    Serial.print(rxSeq[peer].duplicates);
+    Serial.print(',');
+    Serial.print(rxSeq[peer].missed);
+  }
+  Serial.println();
 }
 
+// function that (re)opens the link: addresses, channel and retries (pairing addresses while pairing, private ones once paired)
+void openLink()
+{
+  for (uint8_t peer = 0; peer < RADIO_PEERS; peer++)
+  {
+    rxSeq[peer].restart();
+  }
+#if RADIO_CHANNEL_SURVEY
+  onSurveyChannel = false; // negotiate again from the meeting channel
+#if RADIO_ROLE == RADIO_MASTER
+  surveyAnswers = 0;
+#endif
+#endif
+
+#if RADIO_PAIRING_ENABLED
+  if (pairingActive)
+  {
+    radioLink.setChannel(RADIO_PAIRING_CHANNEL);
+#if RADIO_ROLE == RADIO_MASTER
+    radio.openReadingPipe(1, pairingAddresses[1]);
+    radioLink.setAddress(pairingAddresses[0]);
+#else
+    radio.openReadingPipe(1, pairingAddresses[0]);
+    radioLink.setAddress(pairingAddresses[1]);
+#endif
+    return;
+  }
+#endif
+
+  for (uint8_t i = 0; i < GROUP_MAX_SIZE; i++)
+  {
+    memcpy(addresses[i], "0Node", 6);
+    addresses[i][0] += i;
+    addresses[i][3] += RADIO_CHANNEL; // pairs that negotiated the same channel don't hear each other
+    addresses[i][4] += RADIO_SLOT_ID; // pairs sharing a channel in slotted mode don't hear each other
+  }
+#if RADIO_PAIRING_ENABLED
+  if (pairing.paired())
+  {
+    for (uint8_t i = 0; i < GROUP_MAX_SIZE; i++)
+    {
+      pairing.address(i, addresses[i]);
+    }
+    radioChannel = pairing.record.channel;
+#if RADIO_ROLE == RADIO_SLAVE
+    memberId = pairing.record.member;
+#endif
+  }
+#endif
+
+  // retry delay (x * 250 micros + 250 micros) and count (number of retries), the upper limits with RADIO_ADAPTIVE_ENABLED
+  // Example: (5 would give a 1500 (1250+250) µs delay which would be needed for 32 byte of ackData)
+  // so, for (5, 5), the max delay per loop would be 5 * 1500 = 7500 micros (7,5 ms)
+#if RADIO_SLOT_COUNT
+  uint8_t retryDelay = RADIO_ROLE == RADIO_SLAVE ? 1 + memberId : 5; // one attempt (4 transmissions) must fit into SLOT_GUARD_MICROS
+  uint8_t retryCount = 3;
+#elif RADIO_ROLE == RADIO_SLAVE
+  uint8_t retryDelay = 17 - 2 * memberId; // slaves of a group retry after different delays, so frames that collided once
+  uint8_t retryCount = 15;                // (e.g. all answers to one ping) don't collide again on every retry
+#else
+  uint8_t retryDelay = 15;
+  uint8_t retryCount = 15;
+#endif
+#if RADIO_ADAPTIVE_ENABLED
+  // shortest delays stay staggered between the members of a group
+  linkControl.begin(LINK_CONTROL_MIN_DELAY + (RADIO_ROLE == RADIO_SLAVE ? memberId : 0), retryDelay, retryCount);
+#else
+  radio.setRetries(retryDelay, retryCount);
+#endif
+
 #if RADIO_ROLE == RADIO_MASTER
-static uint32_t slaveLastPullTimer = 0; // saves the time in micros when isPulled was received from slave
+  for (uint8_t pipe = 1; pipe <= RADIO_PEERS; pipe++)
+  {
+    radio.openReadingPipe(pipe, addresses[pipe]);
+  }
+  radioLink.setAddress(addresses[0]);
+  for (uint8_t peer = 0; peer < RADIO_PEERS; peer++)
+  {
+    clockSync[peer] = ClockSync(); // might be another slave now
+  }
+#else
+  radio.openReadingPipe(1, addresses[0]);
+  radioLink.setAddress(addresses[memberId]);
 #endif
+  radioLink.setChannel(radioChannel);
+}
 
 #endif
 
@@ -147,11 +713,13 @@ static uint32_t slaveLastPullTimer = 0; // saves the time in micros when isPulle
 void setup()
 {
 
-  Serial.begin(9600); // open the serial port at 9600 bps
+  Serial.begin(EVENT_LOG_ENABLED ? EVENT_LOG_BAUD : 9600); // open the serial port (binary records or text at 9600 bps)
   while (!Serial)
   {
     // wait to ensure access to serial
   }
+  watchdog.begin(currentMode, currentModeSynchPullGoal); // reports a watchdog reset, setup() is guarded from here on
+  trace.begin(RADIO_ROLE);
 
   apr = Apparatus();
 
@@ -159,84 +727,117 @@ void setup()
   remote.init();
 #endif
 
-#if RADIO_ROLE == RADIO_MASTER
-  slaveLastPullTimer = 4000000000 - (5 * SECOND_MICROS); // set invalid so first 5s pull in master is not by default counted as synchPull
-#endif
-
   // Audio setup ------------------------------------------------------------------
   softwareSerial.begin(9600);
-  while (!softwareSerial)
-  {
-    // wait to ensure access to serial
-  }
 #if ENABLE_AUDIO
   if (!audioPlayer.begin(softwareSerial))
   {
-    Serial.println(F("Audio player is not responding:"));
-    Serial.println(F("1.Please recheck the connection!"));
-    Serial.println(F("2.Please insert the SD card!"));
-    Serial.println(F("3.Restart program!"));
+    Serial.println(message(MSG_AUDIO_NOT_RESPONDING));
+    Serial.println(message(MSG_AUDIO_CHECK_CONNECTION));
+    Serial.println(message(MSG_AUDIO_CHECK_SD_CARD));
+    Serial.println(message(MSG_AUDIO_RESTART));
     playTone(AUDIO_FOLDER, AUDIO_SOUND_ERROR);
     while (true)
     {
-      // hold in infinite loop
+      // hold until the watchdog resets the box (retries the setup), or forever without WATCHDOG_ENABLED
     }
   }
 
   audioPlayer.volume(AUDIO_VOLUME);
 #endif
 
+  uint16_t seed = analogRead(A7); // generate random seed using unused analog pin (radio boxes: back-offs differ between the boxes)
+  trace.seed(seed);
+  randomSeed(seed);
+
 #if RADIO_ROLE != RADIO_TRAINING // TESTING
   // Check Settings ---------------------------------------------------------------
   // Check for illegal settings
   if ((SYNCH_PULL_MAX % MODE_TEST_ONE_COUNT != 0) || (SYNCH_PULL_MAX % MODE_TEST_ONE_COUNT != 0) || (SYNCH_PULL_MAX % MODE_TEST_ONE_COUNT != 0))
   {
-    Serial.println("Illegal setup: SYNCH_PULL_MAX not divisible by MODE_TEST_COUNT!");
-    Serial.println("Check settings.h!");
+    Serial.println(message(MSG_ILLEGAL_SETUP));
+    Serial.println(message(MSG_CHECK_SETTINGS));
     playTone(AUDIO_FOLDER, AUDIO_SOUND_ERROR);
     while (true)
     {
-      // hold in infinite loop
+      // hold until the watchdog resets the box (retries the setup), or forever without WATCHDOG_ENABLED
     }
   }
 
   // Radio setup -----------------------------------------------------------------
   if (!radio.begin())
   {
-    Serial.println(F("Radio hardware is not responding!"));
+    Serial.println(message(MSG_RADIO_NOT_RESPONDING));
     playTone(AUDIO_FOLDER, AUDIO_SOUND_ERROR);
     while (true)
     {
-      // hold in infinite loop
+      // hold until the watchdog resets the box (retries the setup), or forever without WATCHDOG_ENABLED
     }
   }
 
   // Transmission parameters
   radio.setChannel(RADIO_CHANNEL); // (2400 MHz + channel number (0-125)) default = 2476 MHz
   radio.setDataRate(RF24_250KBPS); // 3 modes: RF24_250KBPS, RF24_1MBPS, RF24_2MBPS (lowest most stable and longest range)
-  radio.setPALevel(RF24_PA_LOW);   // set to RF24_PA_MAX for longer range (could cause power supply problems) (PA = Power amplifier)
-  radio.setPayloadSize(sizeof(payload));
-  radio.setRetries(15, 15); // delay (x * 250 micros + 250 micros), count (number of retries)
-                            // Example: (5 would give a 1500 (1250+250) µs delay which would be needed for 32 byte of ackData)
-                            // so, for (5, 5), the max delay per loop would be 5 * 1500 = 7500 micros (7,5 ms)
+  radio.setPALevel(RADIO_PA_LEVEL); // set to RF24_PA_MAX for longer range (could cause power supply problems) (PA = Power amplifier)
+  radio.enableDynamicPayloads();   // frames are only as long as their content (shorter air time)
+  radio.setCRCLength(RF24_CRC_16); // hardware CRC protects each frame
+#if RADIO_ACK_PAYLOAD_ENABLED && RADIO_GROUP_SIZE == 2
+  radio.enableAckPayload(); // master answers slave frames within the ACK (needs dynamic payloads and >= 500 micros retry delay)
+#endif
 
-#if RADIO_ROLE == RADIO_MASTER
-  radio.openWritingPipe(addresses[RADIO_SLAVE]);
-  radio.openReadingPipe(1, addresses[RADIO_MASTER]);
-#elif RADIO_ROLE == RADIO_SLAVE
-  radio.openWritingPipe(addresses[RADIO_MASTER]);
-  radio.openReadingPipe(1, addresses[RADIO_SLAVE]);
+#if RADIO_CHANNEL_SURVEY
+  survey.scan(); // both sides, the master weighs in the slaves' view of its candidates
+  survey.print();
+#endif
+
+#if RADIO_SLOT_COUNT
+  radio.openReadingPipe(0, beaconAddress); // pipe 0 is switched to the writing address only while transmitting
+  radioLink.slots = &slots;
+#endif
+
+#if RADIO_ADAPTIVE_ENABLED
+  radioLink.control = &linkControl;
+#endif
+
+#if RADIO_ROLE == RADIO_MASTER && RADIO_GROUP_SIZE > 2
+  radioLink.init(RADIO_BROADCAST_REPEATS); // one frame reaches all slaves (several ACKs would collide)
+#else
+  radioLink.init(); // radio IRQ on RADIO_IRQ_PIN
 #endif
 
+#if RADIO_PAIRING_ENABLED
+  pairing.init();
+  trace.pairing(pairing.id, pairing.record.version, pairing.record.group, pairing.record.member, pairing.record.channel);
+  Serial.print(message(MSG_BOX_ID));
+  Serial.println(pairing.id, HEX);
+#if RADIO_ROLE == RADIO_SLAVE
+  if (digitalRead(LEVER_DOWN_PIN) == LEVER_DOWN_STATE) // switched on with the lever pulled down -> wait for the master's offer
+  {
+    pairingActive = true;
+    Serial.println(message(MSG_PAIRING_WAITING));
+  }
+#endif
+#endif
+  openLink();
   radio.startListening(); // Boxes are by default in listening mode and
                           // only transmit when something changes (e.g. lever pulled in slave)
-
-#else // TRAINING
-  randomSeed(analogRead(A7)); // generate random seed using unused analog pin
 #endif
 
-  Serial.println("Setup successful!");
+#if LOOP_PROFILE_ENABLED
+  profiler.calibrate();
+#endif
+  if (watchdog.stalled) // after a watchdog reset: the session of before, locked like after a remote lock
+  {
+    currentMode = (MD_MODES)watchdog.mode;
+    currentModeSynchPullGoal = watchdog.goal;
+    currentLockStatus = LOCKED;
+    currentState = ST_LOCKLEVER;
+    printState(ST_LOCKLEVER);
+  }
+  watchdog.resume();
+  Serial.println(message(MSG_SETUP_SUCCESSFUL));
   playTone(AUDIO_FOLDER, AUDIO_SOUND_START);
+  stackMonitor.paint(); // last, the stack of setup() is left out
 }
 
 // =================================================================================
@@ -244,26 +845,73 @@ void setup()
 void loop()
 {
 
+#if LOOP_PROFILE_ENABLED
+  profiler.start();
+#endif
+  stackMonitor.start();
+  watchdog.kick(currentMode, currentModeSynchPullGoal);
+
 #if PRINT_DEBUG
   static unsigned long lastTime = 0;
   static unsigned long count = 0;
+  static unsigned long previousLoopTime = 0;
+  static unsigned long maxLoopTime = 0; // worst case, shows stalls the average hides
   unsigned long currentTime = micros();
   unsigned long printTime = 1e6 * 5;
-  if (currentTime > lastTime + printTime) // print avg. loop time every 5 sec
+  if (currentTime - previousLoopTime > maxLoopTime)
   {
-    sprintf(buffer, "Avg loop time: %ld\n", (currentTime - lastTime) / count);
-    Serial.print(buffer);
-    lastTime += currentTime;
+    maxLoopTime = currentTime - previousLoopTime;
+  }
+  previousLoopTime = currentTime;
+  count++; // this loop included, never 0 below
+  if (currentTime - lastTime > printTime) // print avg. and max. loop time every 5 sec
+  {
+    Serial.print(F("Avg loop time: "));
+    Serial.println((currentTime - lastTime) / count);
+    Serial.print(F("Max loop time: "));
+    Serial.println(maxLoopTime);
+    stackMonitor.print();
+    lastTime = currentTime;
     count = 0;
+    maxLoopTime = 0;
   }
-  count++;
 #endif
 
   apr.update(); // check if lever was pulled
+#if LOOP_PROFILE_ENABLED
+  profiler.mark(LOOP_PHASE_LEVER);
+#endif
+  watchdog.enter(WATCHDOG_REMOTE);
 
 #if RADIO_ROLE != RADIO_SLAVE
   remote.update(); // check if remote control button was pressed
 #endif
+#if LOOP_PROFILE_ENABLED
+  profiler.mark(LOOP_PHASE_REMOTE);
+#endif
+  watchdog.enter(WATCHDOG_RADIO);
+
+  if (Serial.available())
+  {
+    uint8_t request = Serial.read();
+    trace.serialInput(micros(), request);
+#if RADIO_ROLE != RADIO_TRAINING
+    if (request == LINK_STATS_REQUEST)
+    {
+      printLinkStats();
+    }
+#endif
+#if LOOP_PROFILE_ENABLED
+    if (request == LOOP_PROFILE_REQUEST)
+    {
+      profiler.print();
+    }
+#endif
+    if (request == STACK_REQUEST)
+    {
+      stackMonitor.print();
+    }
+  }
 
 // =================================================================================
 // RADIO AND REMOTE PROCEDURE:
@@ -280,14 +928,14 @@ void loop()
     case UNLOCKED:
     {
       currentState = ST_LOCKLEVER;
-      Serial.println("State: ST_LOCKLEVER");
+      printState(ST_LOCKLEVER);
       currentLockStatus = LOCKED;
       break;
     }
     case LOCKED:
     {
       currentState = ST_UNLOCKLEVER;
-      Serial.println("State: ST_UNLOCKLEVER");
+      printState(ST_UNLOCKLEVER);
       currentLockStatus = UNLOCKED;
 
       break;
@@ -304,8 +952,8 @@ void loop()
       {
         currentMode = MD_TWO;
         currentModeSynchPullGoal = random(trainingModeTwoCountMinMax[0], trainingModeTwoCountMinMax[1]);
-        Serial.println("Mode: MD_TWO");
-        Serial.print("Current random pull goal: ");
+        printMode(MD_TWO);
+        Serial.print(message(MSG_CURRENT_PULL_GOAL));
         Serial.println(currentModeSynchPullGoal);
         playTone(AUDIO_FOLDER, AUDIO_SOUND_MODE_TWO);
         break;
@@ -314,7 +962,7 @@ void loop()
       {
         currentMode = MD_ONE;
         currentModeSynchPullGoal = MODE_TRAIN_ONE_COUNT;
-        Serial.println("Mode: MD_ONE");
+        printMode(MD_ONE);
         playTone(AUDIO_FOLDER, AUDIO_SOUND_MODE_ONE);
         break;
       }
@@ -333,45 +981,19 @@ void loop()
     {
     case UNLOCKED:
     {
-      payload.remoteLock = true;
-      payload.count++;
-      sendPayload(&payload);
-
-#if PRINT_DEBUG
-      Serial.print("Send payload (remoteLock == true) to slave: ");
-      Serial.print(payload.pullDetected);
-      Serial.print(payload.triggerReward);
-      Serial.print(payload.longTimeoutEnabled);
-      Serial.print(payload.lockLever);
-      Serial.print(payload.remoteLock);
-      Serial.println(payload.count);
-#endif
+      sendCommand(FRAME_FLAG_REMOTE_LOCK);
 
-      payload.remoteLock = false;
       currentState = ST_LOCKLEVER;
-      Serial.println("State: ST_LOCKLEVER");
+      printState(ST_LOCKLEVER);
       currentLockStatus = LOCKED;
       break;
     }
     case LOCKED:
     {
-      payload.remoteLock = true;
-      payload.count++;
-      sendPayload(&payload);
+      sendCommand(FRAME_FLAG_REMOTE_LOCK);
 
-#if PRINT_DEBUG
-      Serial.print("Send payload (remoteLock == true) to slave: ");
-      Serial.print(payload.pullDetected);
-      Serial.print(payload.triggerReward);
-      Serial.print(payload.longTimeoutEnabled);
-      Serial.print(payload.lockLever);
-      Serial.print(payload.remoteLock);
-      Serial.println(payload.count);
-#endif
-
-      payload.remoteLock = false;
       currentState = ST_UNLOCKLEVER;
-      Serial.println("State: ST_UNLOCKLEVER");
+      printState(ST_UNLOCKLEVER);
       currentLockStatus = UNLOCKED;
       break;
     }
@@ -387,7 +1009,7 @@ void loop()
       {
         currentMode = MD_TWO;
         currentModeSynchPullGoal = MODE_TEST_TWO_COUNT;
-        Serial.println("Mode: MD_TWO");
+        printMode(MD_TWO);
         playTone(AUDIO_FOLDER, AUDIO_SOUND_MODE_TWO);
         break;
       }
@@ -395,7 +1017,7 @@ void loop()
       {
         currentMode = MD_THREE;
         currentModeSynchPullGoal = MODE_TEST_THREE_COUNT;
-        Serial.println("Mode: MD_THREE");
+        printMode(MD_THREE);
         playTone(AUDIO_FOLDER, AUDIO_SOUND_MODE_THREE);
         break;
       }
@@ -403,118 +1025,266 @@ void loop()
       {
         currentMode = MD_ONE;
         currentModeSynchPullGoal = MODE_TEST_ONE_COUNT;
-        Serial.println("Mode: MD_ONE");
+        printMode(MD_ONE);
         playTone(AUDIO_FOLDER, AUDIO_SOUND_MODE_ONE);
         break;
       }
       }
     }
   }
+#if RADIO_PAIRING_ENABLED
+  if (currentGesture == LONG_LONG_LONG) // start/stop pairing the next slave
+  {
+    pairingActive = !pairingActive;
+    relinkPending = true;
+    Serial.println(message(pairingActive ? MSG_PAIRING_STARTED : MSG_PAIRING_STOPPED));
+  }
+#endif
 
   // RADIO
-  if (radio.available()) // payload available in top lvl of this FIFO?
+  radioLink.update(); // advance queued transmissions
+
+#if RADIO_PAIRING_ENABLED
+  // PAIRING: offer the next member number on RADIO_PAIRING_CHANNEL until a slave answers or PAIRING_MICROS passed
+  static uint32_t pairingTimer = 0;
+  static uint32_t lastOfferTimer = 0;
+  if (relinkPending && !radioLink.busy())
   {
-    // Fetch the payload
-    uint8_t len = radio.getPayloadSize();
-    if (len)
-    {
-      radio.read(&payloadReceived, len);
+    relinkPending = false;
+    pairingTimer = micros();
+    openLink();
+  }
+  else if (pairingActive && !relinkPending && (uint32_t)(micros() - pairingTimer) > PAIRING_MICROS)
+  {
+    pairingActive = false;
+    relinkPending = true;
+    Serial.println(message(MSG_PAIRING_NO_ANSWER));
+    playTone(AUDIO_FOLDER, AUDIO_SOUND_ERROR);
+  }
+  else if (pairingActive && !relinkPending && !radioLink.busy() && (uint32_t)(micros() - lastOfferTimer) > PAIRING_OFFER_MICROS)
+  {
+    // next member of the own group, or member 1 of a new group (full group or paired to another master before)
+    bool ownGroup = pairing.paired() && pairing.record.group == pairing.id && pairing.record.member < RADIO_PEERS;
+    pairingMember = ownGroup ? pairing.record.member + 1 : 1;
+
+    Frame offer;
+    offer.type = FRAME_PAIR;
+    offer.time[0] = pairing.id;
+    offer.time[1] = pairingMember | (uint32_t)pairingChannel() << 8;
+    lastOfferTimer = micros();
+    sendFrame(&offer, TX_PAIR);
+  }
+#endif
 
-      if (payloadReceived.pullDetected)
-      {
-        slaveLastPullTimer = micros();
-        payloadReceived.pullDetected = false;
-      }
+#if RADIO_SLOT_COUNT && RADIO_SLOT_ID == 0
+  // SLOT BEACON: tell all boxes on the channel where the slot frame stands (sent in slot 0 right away, so the phase is fresh, and before the ping: the pong would overlap it)
+  static uint32_t lastBeaconTimer = 0;
+  if (!radioLink.busy() && radioLink.slotOpen() && (uint32_t)(micros() - lastBeaconTimer) > SLOT_BEACON_INTERVAL_MICROS)
+  {
+    Frame beacon;
+    beacon.type = FRAME_BEACON;
+    lastBeaconTimer = micros();
+    beacon.time[0] = slots.phase(lastBeaconTimer);
+    sendFrame(&beacon, TX_BEACON, false, beaconAddress);
+  }
+#endif
 
-#if PRINT_DEBUG
-      Serial.print(F("Received data (from slave): Size="));
-      Serial.print(len);
-      Serial.print(F(", Count="));
-      Serial.println(payloadReceived.count);
+  // CLOCK SYNC: ping the slaves regularly (one ping answered by all slaves of a group) (only on an idle link, queueing delay would be in the round trip)
+  static uint32_t lastPingTimer = 0;
+  if (!pairingActive && !radioLink.busy() && radioLink.slotOpen() && (uint32_t)(micros() - lastPingTimer) > CLOCK_SYNC_INTERVAL_MICROS)
+  {
+    Frame ping;
+    ping.type = FRAME_PING;
+    lastPingTimer = micros();
+    ping.time[0] = lastPingTimer;
+    ping.time[1] = packState(); // heartbeat: slaves compare it with their own state
+    sendFrame(&ping, TX_CLOCK_SYNC);
+  }
+  checkHeartbeats();
 
-      Serial.print("PayloadReceived from slave:");
-      Serial.print(payloadReceived.pullDetected);
-      Serial.print(payloadReceived.triggerReward);
-      Serial.print(payloadReceived.longTimeoutEnabled);
-      Serial.print(payloadReceived.lockLever);
-      Serial.print(payloadReceived.remoteLock);
-      Serial.println(payloadReceived.count);
-#endif
+#if RADIO_CHANNEL_SURVEY
+  // CHANNEL SURVEY: propose the quietest channels on RADIO_CHANNEL, decide once all slaves answered (or SURVEY_ANSWER_MICROS after the first)
+  static uint32_t surveyTimer = 0;
+  if (!pairingActive && !onSurveyChannel && !radioLink.busy())
+  {
+    if (surveyAnswers && (surveyAnswers == _BV(RADIO_PEERS) - 1 || (uint32_t)(micros() - surveyTimer) > SURVEY_ANSWER_MICROS))
+    {
+      Frame decision;
+      decision.type = FRAME_CHANNEL;
+      decision.flags = FRAME_FLAG_CHANNEL_SWITCH;
+      surveyChannel = survey.decide();
+      decision.time[0] = surveyChannel;
+      sendFrame(&decision, TX_CHANNEL); // switch in onPayloadSent
     }
-    else // If a corrupt payload (!len) is received, it will be flushed
+    else if (!surveyAnswers && (uint32_t)(micros() - surveyTimer) > SURVEY_PROPOSE_MICROS)
     {
-      Serial.println("*** Corrupt payload received!");
+      Frame proposal;
+      proposal.type = FRAME_CHANNEL;
+      proposal.time[0] = survey.propose();
+      surveyTimer = micros();
+      sendFrame(&proposal, TX_CHANNEL);
     }
   }
+  checkChannelSilence();
+#endif
 
-#elif RADIO_ROLE == RADIO_SLAVE
-  // SLAVE ---------------------------------------------------------------------------
+  updateAckPayload();
 
-  // RADIO
-  if (radio.available()) // payload available in top lvl of this FIFO?
+  if (radioLink.available()) // payload available in top lvl of this FIFO? (only checked after the radio IRQ fired)
   {
-    // Fetch the payload
-    uint8_t len = radio.getPayloadSize();
+    useArmedSeq();
+    bool ackSent = radioLink.ackConsumed(); // armedFrame went out with the ACK of this frame
 
-    if (len)
+    if (receiveFrame())
     {
-      radio.read(&payloadReceived, len);
-
-#if PRINT_DEBUG
-      Serial.print(F("Received data (from master): Size="));
-      Serial.print(len);
-      Serial.print(F(", Count="));
-      Serial.println(payloadReceived.count);
-
-      Serial.print("PayloadReceived from master:");
-      Serial.print(payloadReceived.pullDetected);
-      Serial.print(payloadReceived.triggerReward);
-      Serial.print(payloadReceived.longTimeoutEnabled);
-      Serial.print(payloadReceived.lockLever);
-      Serial.print(payloadReceived.remoteLock);
-      Serial.println(payloadReceived.count);
+      if (frameReceived.type == FRAME_PONG)
+      {
+        clockSync[framePeer].addSample(frameReceived.time[0], frameReceived.time[1], frameReceived.time[2], radioLink.rxTime);
+      }
+      else if (frameReceived.type == FRAME_PULL)
+      {
+        // the slave's own pull time mapped to master time (IRQ arrival time until the clocks are synced)
+        ClockSync *sync = &clockSync[framePeer];
+        group.pull(framePeer + 1, sync->synced ? sync->toLocal(frameReceived.time[0]) : radioLink.rxTime);
+        armedCommandSent = ackSent && armedFrame.type == FRAME_COMMAND; // slave already has the instruction for this synchronous pull
+      }
+#if RADIO_PAIRING_ENABLED
+      else if (frameReceived.type == FRAME_PAIR && pairingActive) // slave answered the offer with its ID
+      {
+        pairing.save(pairing.id, pairingMember, pairingChannel());
+        pairingActive = false;
+        relinkPending = true;
+        Serial.print(message(MSG_PAIRING_BOX));
+        Serial.print(frameReceived.time[0], HEX);
+        Serial.print(message(MSG_PAIRING_IS_MEMBER));
+        Serial.println(pairingMember);
+        playTone(AUDIO_FOLDER, AUDIO_SOUND_START);
+      }
+#endif
+#if RADIO_CHANNEL_SURVEY
+      else if (frameReceived.type == FRAME_CHANNEL && !onSurveyChannel && !(surveyAnswers & _BV(framePeer)))
+      {
+        if (!surveyAnswers)
+        {
+          surveyTimer = micros(); // first answer starts the wait for the others
+        }
+        surveyAnswers |= _BV(framePeer);
+        survey.vote(frameReceived.time[0]);
+      }
 #endif
-    }
-    else // If a corrupt payload (!len) is received, it will be flushed
-    {
-      Serial.println("*** Corrupt payload received!");
     }
   }
 
-  // Update changes in variables (so a new incoming payload doesnt just overwrite any variables to false).
-  // Not sure if this is actually needed, but seemed safer,
-  // otherwise a later received message might overwrite an earlier one that wasnt handled yet
-  if (payloadReceived.triggerReward)
+#elif RADIO_ROLE == RADIO_SLAVE
+  // SLAVE ---------------------------------------------------------------------------
+
+  // RADIO
+  radioLink.update(); // advance queued transmissions
+
+#if RADIO_PAIRING_ENABLED
+  if (relinkPending && !radioLink.busy()) // pairing answer delivered -> private addresses from now on
   {
-    triggerReward = true;
-    payloadReceived.triggerReward = false;
+    relinkPending = false;
+    openLink();
   }
-  if (payloadReceived.longTimeoutEnabled)
+#endif
+
+  if (radioLink.available()) // payload available in top lvl of this FIFO? (only checked after the radio IRQ fired)
   {
-    longTimeoutEnabled = true;
-    payloadReceived.longTimeoutEnabled = false;
+    if (receiveFrame())
+    {
+      if (frameReceived.type == FRAME_PING) // clock sync: answer with own receive and send time
+      {
+        Frame pong;
+        pong.type = FRAME_PONG;
+        pong.time[0] = frameReceived.time[0];
+        pong.time[1] = radioLink.rxTime;
+        pong.time[2] = micros();
+        sendFrame(&pong, TX_CLOCK_SYNC);
+        syncState(frameReceived.time[1]);
+      }
+      else if (frameReceived.type == FRAME_STATE) // heartbeat in the ACK of an own frame
+      {
+        syncState(frameReceived.time[0]);
+      }
+#if RADIO_PAIRING_ENABLED
+      else if (frameReceived.type == FRAME_PAIR && pairingActive && !radioLink.busy()) // offer: accept it and answer with the own ID
+      {
+        pairingOffer.version = PAIRING_VERSION;
+        pairingOffer.group = frameReceived.time[0];
+        pairingOffer.member = frameReceived.time[1] & 0xFF;
+        pairingOffer.channel = frameReceived.time[1] >> 8;
+
+        Frame answer;
+        answer.type = FRAME_PAIR;
+        answer.time[0] = pairing.id;
+        sendFrame(&answer, TX_PAIR);
+      }
+#endif
+#if RADIO_CHANNEL_SURVEY
+      else if (frameReceived.type == FRAME_CHANNEL && (frameReceived.flags & FRAME_FLAG_CHANNEL_SWITCH))
+      {
+        surveyChannel = frameReceived.time[0];
+        surveySwitch = true;
+      }
+      else if (frameReceived.type == FRAME_CHANNEL) // proposal: answer with the own noise on the candidates
+      {
+        Frame answer;
+        answer.type = FRAME_CHANNEL;
+        answer.time[0] = survey.noise(frameReceived.time[0]);
+        sendFrame(&answer, TX_CHANNEL);
+      }
+#endif
+      else if (frameReceived.type == FRAME_COMMAND)
+      {
+        // Latch instructions (so a new incoming frame doesnt just overwrite any instruction that wasnt handled yet)
+        if (frameReceived.flags & FRAME_FLAG_TRIGGER_REWARD)
+        {
+          triggerReward = true;
+        }
+        if (frameReceived.flags & FRAME_FLAG_LONG_TIMEOUT)
+        {
+          longTimeoutEnabled = true;
+        }
+        if (frameReceived.flags & FRAME_FLAG_LOCK_LEVER)
+        {
+          lockLever = true;
+        }
+        if (frameReceived.flags & FRAME_FLAG_REMOTE_LOCK)
+        {
+          remoteLock = true;
+        }
+      }
+    }
   }
-  if (payloadReceived.lockLever)
+
+  checkHeartbeats();
+
+#if RADIO_CHANNEL_SURVEY
+  if (surveySwitch && !radioLink.busy()) // after the own queued frames went out on the old channel
   {
-    lockLever = true;
-    payloadReceived.lockLever = false;
+    surveySwitch = false;
+    switchChannel(surveyChannel);
   }
-  if (payloadReceived.remoteLock)
+  checkChannelSilence();
+#endif
+
+  if (remoteLock)
   {
-    payloadReceived.remoteLock = false; // reset
+    remoteLock = false; // reset
     switch (currentLockStatus)
     {
     case UNLOCKED:
     {
       currentState = ST_LOCKLEVER;
-      Serial.println("State: ST_LOCKLEVER");
+      printState(ST_LOCKLEVER);
       currentLockStatus = LOCKED;
       break;
     }
     case LOCKED:
     {
       currentState = ST_UNLOCKLEVER;
-      Serial.println("State: ST_UNLOCKLEVER");
+      printState(ST_UNLOCKLEVER);
       currentLockStatus = UNLOCKED;
       break;
     }
@@ -523,17 +1293,21 @@ void loop()
   else if (triggerReward) // if reward instruction was received from master -> go directly to reward state
   {
     currentState = ST_REWARD;
-    Serial.println("State: ST_REWARD");
+    printState(ST_REWARD);
     triggerReward = false; // reset
   }
   else if (lockLever) // if lockLever instruction was received from master -> go to LOCKLEVER state if reward wasn't triggered before, otherwise wait for reward to finish
   {
     currentState = ST_LOCKLEVER;
-    Serial.println("State: ST_LOCKLEVER");
+    printState(ST_LOCKLEVER);
     lockLever = false; // reset
   }
 
 #endif
+#if LOOP_PROFILE_ENABLED
+  profiler.mark(LOOP_PHASE_RADIO);
+#endif
+  watchdog.enter(WATCHDOG_TASK);
 
 // =================================================================================
 // TASK PROCEDURE:
@@ -548,7 +1322,7 @@ void loop()
     case ST_START:
     {
       currentState = ST_UNLOCKLEVER;
-      Serial.println("State: ST_UNLOCKLEVER");
+      printState(ST_UNLOCKLEVER);
       break;
     }
 
@@ -556,17 +1330,17 @@ void loop()
     {
       apr.openLever(true);
       currentState = ST_LEVERFULLUP;
-      Serial.println("State: ST_LEVERFULLUP");
+      printState(ST_LEVERFULLUP);
       waitTimerEnabled = false; // reset (needed in case of remote unlock)
       break;
     }
 
     case ST_LEVERFULLUP: // wait for lever to reach full up state
     {
-      if (apr.debouncedLeverUp)
+      if (apr.debouncedLeverUp && !apr.debouncedLeverDown) // a quick re-pull reaches down before the up hold-off ends
       {
         currentState = ST_LEVERFULLDOWN;
-        Serial.println("State: ST_LEVERFULLDOWN");
+        printState(ST_LEVERFULLDOWN);
       }
       break;
     }
@@ -576,7 +1350,7 @@ void loop()
       if (apr.debouncedLeverDown)
       {
         currentState = ST_SYNCBOXES;
-        Serial.println("State: ST_SYNCBOXES");
+        printState(ST_SYNCBOXES);
       }
       break;
     }
@@ -590,23 +1364,30 @@ void loop()
         if (currentMode == MD_TWO) // if in mode 2 (randomized goal), set new random goal
         {
           currentModeSynchPullGoal = random(trainingModeTwoCountMinMax[0], trainingModeTwoCountMinMax[1]); // set new random goal
-          Serial.print("New random pull goal: ");
-          Serial.println(currentModeSynchPullGoal);
+          if (EVENT_LOG_ENABLED)
+          {
+            eventLog.log(EVENT_PULL_GOAL, currentModeSynchPullGoal);
+          }
+          else
+          {
+            Serial.print(message(MSG_NEW_PULL_GOAL));
+            Serial.println(currentModeSynchPullGoal);
+          }
         }
         currentState = ST_REWARD;
-        Serial.println("State: ST_REWARD");
+        printState(ST_REWARD);
       }
       else
       {
         if (EACH_SYNCH_PULL_TIMEOUT_ENABLED) // timeout after each legal pull
         {
           currentState = ST_LOCKLEVER;
-          Serial.println("State: ST_LOCKLEVER");
+          printState(ST_LOCKLEVER);
         }
         else // timeout only after reward
         {
           currentState = ST_START;
-          Serial.println("State: ST_START");
+          printState(ST_START);
         }
       }
       break;
@@ -619,7 +1400,7 @@ void loop()
       playTone(AUDIO_FOLDER, AUDIO_SOUND_REWARD);
 
       currentState = ST_LOCKLEVER;
-      Serial.println("State: ST_LOCKLEVER");
+      printState(ST_LOCKLEVER);
       break;
     }
 
@@ -627,7 +1408,7 @@ void loop()
     {
       apr.openLever(false);
       currentState = ST_WAIT;
-      Serial.println("State: ST_WAIT");
+      printState(ST_WAIT);
       break;
     }
 
@@ -672,7 +1453,7 @@ void loop()
     case ST_START:
     {
       currentState = ST_UNLOCKLEVER;
-      Serial.println("State: ST_UNLOCKLEVER");
+      printState(ST_UNLOCKLEVER);
       break;
     }
 
@@ -680,17 +1461,17 @@ void loop()
     {
       apr.openLever(true);
       currentState = ST_LEVERFULLUP;
-      Serial.println("State: ST_LEVERFULLUP");
+      printState(ST_LEVERFULLUP);
       waitTimerEnabled = false; // reset (required in case of remote unlock (otherwise next ITI is skipped after remote lock and unlock))
       break;
     }
 
     case ST_LEVERFULLUP: // wait for lever to reach full up state
     {
-      if (apr.debouncedLeverUp)
+      if (apr.debouncedLeverUp && !apr.debouncedLeverDown) // a quick re-pull reaches down before the up hold-off ends
       {
         currentState = ST_LEVERFULLDOWN;
-        Serial.println("State: ST_LEVERFULLDOWN");
+        printState(ST_LEVERFULLDOWN);
       }
       break;
     }
@@ -700,7 +1481,7 @@ void loop()
       if (apr.debouncedLeverDown)
       {
         currentState = ST_SYNCBOXES;
-        Serial.println("State: ST_SYNCBOXES");
+        printState(ST_SYNCBOXES);
       }
       break;
     }
@@ -713,15 +1494,17 @@ void loop()
       if (!pullTimerEnabled) // only set pull timer once per trial
       {
         pullTimerEnabled = true;
-        masterLastPullTimer = micros();
+        masterLastPullTimer = apr.leverDownTime; // edge time captured in the lever ISR, not the (later) loop time
+        group.pull(0, masterLastPullTimer);
       }
 
-      if (((uint32_t)(micros() - slaveLastPullTimer) <= SYNCH_MICROS)) // last pull from slave less than SYNCH_MICROS seconds ago?
+      // GROUP_QUORUM levers pulled less than SYNCH_MICROS from the master's pull? (or the slave was already told so in the ACK)
+      if (armedCommandSent || group.count(masterLastPullTimer, SYNCH_MICROS) >= GROUP_QUORUM)
       {
         pullTimerEnabled = false;
         synchPullCount++;
         totalSynchPullCount++;
-        slaveLastPullTimer = slaveLastPullTimer - (SYNCH_MICROS + (1 * SECOND_MICROS)); // set to invalid time so slave lever has to be pulled again to count next synchPull
+        group.clear(); // every lever has to be pulled again to count next synchPull
         if (synchPullCount >= currentModeSynchPullGoal)
         {
           if (totalSynchPullCount >= SYNCH_PULL_MAX)
@@ -731,44 +1514,32 @@ void loop()
           }
           synchPullCount = 0; // reset
           currentState = ST_REWARD;
-          Serial.println("State: ST_REWARD");
+          printState(ST_REWARD);
         }
         else // pull goal not yet reached
         {
           if (EACH_SYNCH_PULL_TIMEOUT_ENABLED) // timeout after each legal pull
           {
             // instruct slave to lock lever
-            payload.lockLever = true;
-            payload.count++;
-            sendPayload(&payload);
-
-#if PRINT_DEBUG
-            Serial.print("Sent payload (lockLever) to slave: ");
-            Serial.print(payload.pullDetected);
-            Serial.print(payload.triggerReward);
-            Serial.print(payload.longTimeoutEnabled);
-            Serial.print(payload.lockLever);
-            Serial.print(payload.remoteLock);
-            Serial.println(payload.count);
-#endif
-
-            payload.lockLever = false; // reset
+            sendSynchPullCommand(FRAME_FLAG_LOCK_LEVER);
 
             currentState = ST_LOCKLEVER;
-            Serial.println("State: ST_LOCKLEVER");
+            printState(ST_LOCKLEVER);
           }
           else
           {
             currentState = ST_START;
-            Serial.println("State: ST_START");
+            printState(ST_START);
           }
         }
       }
       else if ((uint32_t)(micros() - masterLastPullTimer) > SYNCH_MICROS) // if last pull from slave more than 5s ago, wait for 5s if pull occurs, otherwise go back to start
       {
         pullTimerEnabled = false;
+        useArmedSeq();
+        radioLink.disarmAck(); // right away, a pull arriving now must not get the instruction anymore
         currentState = ST_START;
-        Serial.println("State: ST_START");
+        printState(ST_START);
       }
       break;
     }
@@ -776,31 +1547,14 @@ void loop()
     case ST_REWARD:
     {
       // Instruct slave to trigger reward
-      payload.triggerReward = true;
-      payload.longTimeoutEnabled = longTimeoutEnabled;
-      payload.count++;
-
-      sendPayload(&payload);
-
-#if PRINT_DEBUG
-      Serial.println("Send Payload with triggerReward == true to SLAVE");
-      Serial.print("Payload:");
-      Serial.print(payload.pullDetected);
-      Serial.print(payload.triggerReward);
-      Serial.print(payload.longTimeoutEnabled);
-      Serial.print(payload.lockLever);
-      Serial.print(payload.remoteLock);
-      Serial.println(payload.count);
-#endif
-
-      payload.triggerReward = false; // reset
+      sendSynchPullCommand(FRAME_FLAG_TRIGGER_REWARD | (longTimeoutEnabled ? FRAME_FLAG_LONG_TIMEOUT : 0));
 
       // Trigger reward
       apr.deployFood(STANDARD_REWARD_AMOUNT);
       playTone(AUDIO_FOLDER, AUDIO_SOUND_REWARD);
 
       currentState = ST_LOCKLEVER;
-      Serial.println("State: ST_LOCKLEVER");
+      printState(ST_LOCKLEVER);
       break;
     }
 
@@ -808,7 +1562,7 @@ void loop()
     {
       apr.openLever(false);
       currentState = ST_WAIT;
-      Serial.println("State: ST_WAIT");
+      printState(ST_WAIT);
       break;
     }
 
@@ -846,7 +1600,7 @@ void loop()
           }
           waitTimerEnabled = false;
           currentState = ST_START;
-          Serial.println("State: ST_START");
+          printState(ST_START);
         }
       }
       break;
@@ -863,7 +1617,7 @@ void loop()
     case ST_START:
     {
       currentState = ST_UNLOCKLEVER;
-      Serial.println("State: ST_UNLOCKLEVER");
+      printState(ST_UNLOCKLEVER);
       break;
     }
 
@@ -871,17 +1625,17 @@ void loop()
     {
       apr.openLever(true);
       currentState = ST_LEVERFULLUP;
-      Serial.println("State: ST_LEVERFULLUP");
+      printState(ST_LEVERFULLUP);
       waitTimerEnabled = false; // reset (needed in case of remote unlock)
       break;
     }
 
     case ST_LEVERFULLUP: // wait for lever to reach full up state
     {
-      if (apr.debouncedLeverUp)
+      if (apr.debouncedLeverUp && !apr.debouncedLeverDown) // a quick re-pull reaches down before the up hold-off ends
       {
         currentState = ST_LEVERFULLDOWN;
-        Serial.println("State: ST_LEVERFULLDOWN");
+        printState(ST_LEVERFULLDOWN);
       }
       break;
     }
@@ -891,7 +1645,7 @@ void loop()
       if (apr.debouncedLeverDown)
       {
         currentState = ST_SYNCBOXES;
-        Serial.println("State: ST_SYNCBOXES");
+        printState(ST_SYNCBOXES);
       }
       break;
     }
@@ -899,38 +1653,37 @@ void loop()
     case ST_SYNCBOXES: // check and wait for synch pull, if no synch -> go back to start
     {
       // Send status to master
-      payload.pullDetected = true;
-      payload.count++;
-
-      sendPayload(&payload);
-
-#if PRINT_DEBUG
-      Serial.print("Send payload (pullDetected) to master: ");
-      Serial.print(payload.pullDetected);
-      Serial.print(payload.triggerReward);
-      Serial.print(payload.longTimeoutEnabled);
-      Serial.print(payload.lockLever);
-      Serial.print(payload.remoteLock);
-      Serial.println(payload.count);
-#endif
-
-      payload.pullDetected = false; // reset
+      Frame pull;
+      pull.type = FRAME_PULL;
+      pull.time[0] = apr.leverDownTime; // slave clock, the master maps it onto its own clock
+      sendFrame(&pull, TX_PULL);
 
       currentState = ST_START; // go back to start, instructions (e.g., triggerReward) from master are handled outside state machine
-      Serial.println("State: ST_START");
+      printState(ST_START);
 
       break;
     }
 
     case ST_REWARD:
     {
+#if PRINT_DEBUG
+      if (EVENT_LOG_ENABLED)
+      {
+        eventLog.log(EVENT_REWARD_LATENCY, micros() - apr.leverDownTime); // with vs. without ACK payload
+      }
+      else
+      {
+        Serial.print(F("Pull to reward latency: ")); // with vs. without ACK payload
+        Serial.println(micros() - apr.leverDownTime);
+      }
+#endif
       // Trigger reward
       apr.deployFood(STANDARD_REWARD_AMOUNT);
       playTone(AUDIO_FOLDER, AUDIO_SOUND_REWARD);
       triggerReward = false; // reset
 
       currentState = ST_LOCKLEVER;
-      Serial.println("State: ST_LOCKLEVER");
+      printState(ST_LOCKLEVER);
       break;
     }
 
@@ -938,7 +1691,7 @@ void loop()
     {
       apr.openLever(false);
       currentState = ST_WAIT;
-      Serial.println("State: ST_WAIT");
+      printState(ST_WAIT);
       break;
     }
 
@@ -965,7 +1718,7 @@ void loop()
         }
       }
 
-      if (currentLockStatus == UNLOCKED) // stay in ST_WAIT until instructed to unlock (payloadReceived.remoteLock == false)
+      if (currentLockStatus == UNLOCKED) // stay in ST_WAIT until instructed to unlock (remoteLock instruction from master)
       {
         if (waitTimerEnabled && (uint32_t)(micros() - waitTimer) > currentTimeoutDuration) // 10s inter trial interval
         {
@@ -976,7 +1729,7 @@ void loop()
           }
           waitTimerEnabled = false;
           currentState = ST_START;
-          Serial.println("State: ST_START");
+          printState(ST_START);
         }
       }
       break;
@@ -986,4 +1739,11 @@ void loop()
   } // Slave
 
 #endif
-}
\ No newline at end of file
+
+  eventLog.drain(); // records of this loop, as far as the serial TX buffer has room
+#if LOOP_PROFILE_ENABLED
+  profiler.mark(LOOP_PHASE_TASK);
+#endif
+}
+
+#endif // RADIO_SNIFFER
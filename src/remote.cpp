@@ -1,11 +1,7 @@
 #include "remote.h"
+#include "Trace.h"
 using namespace std;
 
-#if DEBUG_REMOTE
-char debug_remote_buffer[50];
-uint8_t debug_remote_buffer_len = 0;
-#endif
-
 void Remote::init(void)
 {
     pinMode(pin_remote, INPUT_PULLUP);
@@ -24,7 +20,9 @@ void Remote::update(void)
     if (!this->remoteDebouncing || time - this->remoteDebouncingTime > REMOTE_DEBOUNCING_MICROS)
     {
         this->remoteDebouncing = false;
-        _remoteState = digitalRead(pin_remote) == LOW;
+        uint8_t level = digitalRead(pin_remote);
+        trace.remote(time, level);
+        _remoteState = level == LOW;
 
         // ### detect rising/falling edge
         if (this->remoteState != _remoteState)
@@ -34,8 +32,8 @@ void Remote::update(void)
             remoteStateRisingEdge = _remoteState == HIGH;
             remoteStateFallingEdge = _remoteState == LOW;
 #if DEBUG_REMOTE
-            debug_remote_buffer_len = sprintf(debug_remote_buffer, "_remoteState: %d\n", _remoteState);
-            Serial.print(debug_remote_buffer);
+            Serial.print(F("_remoteState: "));
+            Serial.println(_remoteState);
 #endif
         }
         this->remoteState = _remoteState;
@@ -51,14 +49,14 @@ void Remote::update(void)
             activeGestureState = STATE_TIMING;
             remoteGestureTime = time;
 #if DEBUG_REMOTE
-            Serial.print("STATE_START to STATE_TIMING\n");
+            Serial.println(F("STATE_START to STATE_TIMING"));
 #endif
         }
         if (gestureBufferIndex >= GESTURE_BUFFER_LEN || (gestureBufferIndex && time - remoteGestureTime > REMOTE_GESTURE_MICROS))
         {
             activeGestureState = STATE_ANALYSE;
 #if DEBUG_REMOTE
-            Serial.print("STATE_START to STATE_ANALYSE\n");
+            Serial.println(F("STATE_START to STATE_ANALYSE"));
 #endif
         }
         break;
@@ -71,40 +69,46 @@ void Remote::update(void)
             {
                 activeGestureState = STATE_LONG;
 #if DEBUG_REMOTE
-                Serial.print("STATE_TIMING to STATE_LONG\n");
+                Serial.println(F("STATE_TIMING to STATE_LONG"));
 #endif
             }
             else
             {
                 activeGestureState = STATE_SHORT;
 #if DEBUG_REMOTE
-                Serial.print("STATE_TIMING to STATE_SHORT\n");
+                Serial.println(F("STATE_TIMING to STATE_SHORT"));
 #endif
             }
 #if DEBUG_REMOTE
-            debug_remote_buffer_len = sprintf(debug_remote_buffer, "time - remoteGestureTime: %d\n", (int)(time - remoteGestureTime));
-            Serial.print(debug_remote_buffer);
+            Serial.print(F("time - remoteGestureTime: "));
+            Serial.println((int)(time - remoteGestureTime));
 #endif
         }
         break;
     }
     case STATE_SHORT:
     {
-        gestureBuffer[gestureBufferIndex++] = GESTURE_BUFFER_SHORT_GESTURE;
+        if (gestureBufferIndex < GESTURE_BUFFER_LEN) // STATE_START analyses a full buffer before the next press
+        {
+            gestureBuffer[gestureBufferIndex++] = GESTURE_BUFFER_SHORT_GESTURE;
+        }
         remoteGestureTime = time;
         activeGestureState = STATE_START;
 #if DEBUG_REMOTE
-        Serial.print("STATE_SHORT to STATE_START\n");
+        Serial.println(F("STATE_SHORT to STATE_START"));
 #endif
         break;
     }
     case STATE_LONG:
     {
-        gestureBuffer[gestureBufferIndex++] = GESTURE_BUFFER_LONG_GESTURE;
+        if (gestureBufferIndex < GESTURE_BUFFER_LEN)
+        {
+            gestureBuffer[gestureBufferIndex++] = GESTURE_BUFFER_LONG_GESTURE;
+        }
         remoteGestureTime = time;
         activeGestureState = STATE_START;
 #if DEBUG_REMOTE
-        Serial.print("STATE_LONG to STATE_START\n");
+        Serial.println(F("STATE_LONG to STATE_START"));
 #endif
         break;
     }
@@ -118,14 +122,14 @@ void Remote::update(void)
 
         this->detectedGesture = (remote_gesture)gesture_id;
 #if DEBUG_REMOTE
-        debug_remote_buffer_len = sprintf(debug_remote_buffer, "this->detectedGesture: %d\n", this->detectedGesture);
-        Serial.print(debug_remote_buffer);
+        Serial.print(F("this->detectedGesture: "));
+        Serial.println(this->detectedGesture);
 #endif
 
         gestureBufferIndex = 0;
         activeGestureState = STATE_START;
 #if DEBUG_REMOTE
-        Serial.print("STATE_ANALYSE to STATE_START\n");
+        Serial.println(F("STATE_ANALYSE to STATE_START"));
 #endif
 
         break;
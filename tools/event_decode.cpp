@@ -0,0 +1,133 @@
+/*
+ * Decoder for the serial stream of a box built with EVENT_LOG_ENABLED (see include/EventLog.h)
+ *
+ * Binary event records become the text lines the firmware prints without the event log, the text in between (setup,
+ * link and loop records, trace) passes through, so the output reads like the serial log of before and replays as one
+ * (native/replay.cpp). --csv writes the records only, one per line with the time in micros of the box.
+ * Records with a bad checksum are skipped and counted, the box counts the records its full ring dropped itself
+ * (EVENT_DROPPED, "Events dropped: n").
+ *
+ * build: g++ -std=gnu++11 -O2 -Iinclude -Inative -Inative/hal -o event_decode tools/event_decode.cpp
+ * usage: stty -F /dev/ttyUSB0 1000000 raw && cat /dev/ttyUSB0 > capture.bin
+ *        event_decode [--time | --csv] capture.bin   (or the stream on stdin, --time puts the record time in seconds
+ *                                                     before the lines of the records)
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <string>
+#include <vector>
+
+#include "EventFormat.h"
+
+static bool csv = false;
+static bool times = false;
+
+static void printText(const std::string &line)
+{
+    if (csv)
+    {
+        return;
+    }
+    printf(times ? "%11s%s\n" : "%s%s\n", "", line.c_str());
+}
+
+static void printRecord(const EventRecord &record)
+{
+    if (csv)
+    {
+        printf("%lu,%s,%s\n", (unsigned long)record.time, eventNames[record.event], eventValue(record).c_str());
+    }
+    else if (times)
+    {
+        printf("%10.6f %s\n", record.time / 1e6, eventLine(record).c_str());
+    }
+    else
+    {
+        printf("%s\n", eventLine(record).c_str());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--csv"))
+        {
+            csv = true;
+        }
+        else if (!strcmp(argv[i], "--time"))
+        {
+            times = true;
+        }
+        else if (!path && argv[i][0] != '-')
+        {
+            path = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: event_decode [--time | --csv] [capture.bin]\n");
+            return 2;
+        }
+    }
+    FILE *file = path ? fopen(path, "rb") : stdin;
+    if (!file)
+    {
+        perror(path);
+        return 1;
+    }
+    std::vector<uint8_t> stream;
+    uint8_t chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        stream.insert(stream.end(), chunk, chunk + read);
+    }
+    if (path)
+    {
+        fclose(file);
+    }
+
+    if (csv)
+    {
+        printf("time,event,value\n");
+    }
+    std::string line;
+    unsigned long records = 0, corrupt = 0;
+    for (size_t i = 0; i < stream.size(); i++)
+    {
+        uint8_t c = stream[i];
+        if (c == EVENT_LOG_SYNC)
+        {
+            EventRecord record;
+            if (i + EVENT_LOG_WIRE_LEN <= stream.size() && eventParse(&stream[i], &record))
+            {
+                printRecord(record);
+                records++;
+                i += EVENT_LOG_WIRE_LEN - 1;
+            }
+            else
+            {
+                corrupt++; // resynchronises on the next sync byte
+            }
+        }
+        else if (c == '\n')
+        {
+            printText(line);
+            line.clear();
+        }
+        else if ((c >= ' ' && c < 0x7F) || c == '\t') // the rest of a corrupt record is left out
+        {
+            line += (char)c;
+        }
+    }
+    if (!line.empty())
+    {
+        printText(line);
+    }
+    fprintf(stderr, "%lu records, %lu corrupt records skipped\n", records, corrupt);
+    return 0;
+}
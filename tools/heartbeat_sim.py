@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""Host check of the heartbeat and state resynchronisation (src/Heartbeat.cpp, syncState() in src/main.cpp).
+
+Runs master and slave as event models for the scenarios below and checks two
+bounds, the exit code is 1 if one is violated:
+  - a diverged slave state (lock status, long timeout) is resynchronised at
+    most HEARTBEAT_CONFIRM pings after the first ping that gets through
+    (plus the pings lost in between)
+  - a silent partner is reported within HEARTBEAT_TIMEOUT_MICROS + one ping,
+    and reported back with the first pong after it returns
+
+Model (deliberately simple):
+  - the master toggles the lock with the remote at random times and sends
+    FRAME_FLAG_REMOTE_LOCK, every command and every ping is lost with the
+    scenario's loss rate (a lost command is the "missed remoteLock toggle")
+  - the master pings once per CLOCK_SYNC_INTERVAL_MICROS, the slave answers
+  - a reboot resets the slave's state and heartbeat (UNLOCKED, no long timeout)
+  - the master's long timeout toggles with its reward cycle, the slave's
+    follows the reward command (lost with the commands)
+
+usage: heartbeat_sim.py [--seconds 3600] [--seed 1]
+"""
+
+import argparse
+import random
+import sys
+
+INTERVAL = 1_000_000  # CLOCK_SYNC_INTERVAL_MICROS
+TIMEOUT = 3_500_000  # HEARTBEAT_TIMEOUT_MICROS
+CONFIRM = 2  # HEARTBEAT_CONFIRM
+LOOP = 1_000  # loop() period
+
+# name: (command/ping loss, mean micros between slave reboots, (start, end) of a slave power cut)
+SCENARIOS = {
+    "clean": (0.0, None, None),
+    "lost packets": (0.2, None, None),
+    "reboots": (0.0, 120e6, None),
+    "lost packets + reboots": (0.3, 60e6, None),
+    "slave power cut": (0.05, None, (600e6, 660e6)),
+}
+
+
+class Heartbeat:
+    """Port of src/Heartbeat.cpp."""
+
+    def __init__(self):
+        self.alive = False
+        self.last_time = 0
+        self.last_difference = 0
+        self.difference_count = 0
+
+    def seen(self, now):
+        back = not self.alive and self.last_time
+        self.alive = True
+        self.last_time = now | 1
+        return bool(back)
+
+    def expired(self, now):
+        if not self.alive or now - self.last_time <= TIMEOUT:
+            return False
+        self.alive = False
+        return True
+
+    def differs(self, local, remote):
+        difference = local ^ remote
+        if difference != self.last_difference:
+            self.last_difference = difference
+            self.difference_count = 0
+        if not difference:
+            return False
+        self.difference_count += 1
+        if self.difference_count < CONFIRM:
+            return False
+        self.difference_count = 0
+        return True
+
+
+def pack(lock, long_timeout):
+    return lock | long_timeout << 24
+
+
+def run(loss, reboot_micros, power_cut, seconds, seed):
+    rng = random.Random(seed)
+    end = int(seconds * 1e6)
+    master_lock = slave_lock = 0
+    master_long = slave_long = 0
+    slave_beat, master_beat = Heartbeat(), Heartbeat()
+    next_toggle = rng.expovariate(1 / 30e6)
+    next_reward = rng.expovariate(1 / 20e6)
+    next_reboot = rng.expovariate(1 / reboot_micros) if reboot_micros else end
+    next_ping = INTERVAL
+    diverged_since = None
+    pings_since_divergence = 0  # pings that got through while diverged
+    lost_pings = 0
+    worst_pings = 0
+    violations = []
+    lost_reported = back_reported = None
+
+    def delivered():
+        return rng.random() >= loss
+
+    for now in range(0, end, LOOP):
+        off = power_cut and power_cut[0] <= now < power_cut[1]
+        if now >= next_reboot or (power_cut and now == power_cut[1] // LOOP * LOOP):
+            slave_lock, slave_long, slave_beat = 0, 0, Heartbeat()
+            next_reboot = now + rng.expovariate(1 / reboot_micros) if reboot_micros else end
+        if now >= next_toggle:  # remote SHORT on the master
+            master_lock ^= 1
+            if not off and delivered():
+                slave_lock ^= 1
+            next_toggle = now + rng.expovariate(1 / 30e6)
+        if now >= next_reward:  # reward with/without long timeout, ends some time later
+            master_long ^= 1
+            if not off and delivered():
+                slave_long = master_long
+            next_reward = now + rng.expovariate(1 / 20e6)
+        if now >= next_ping:
+            next_ping += INTERVAL
+            if not off and delivered():
+                slave_beat.seen(now)
+                if diverged_since is not None:
+                    pings_since_divergence += 1
+                master_state = pack(master_lock, master_long)
+                if slave_beat.differs(pack(slave_lock, slave_long), master_state):
+                    slave_lock, slave_long = master_lock, master_long
+                if delivered():  # pong
+                    if master_beat.seen(now) and power_cut and now >= power_cut[1] and back_reported is None:
+                        back_reported = now
+            elif diverged_since is not None:
+                lost_pings += 1
+
+        if master_beat.expired(now) and power_cut and now >= power_cut[0] and lost_reported is None:
+            lost_reported = now
+
+        if pack(slave_lock, slave_long) != pack(master_lock, master_long):
+            if diverged_since is None:
+                diverged_since, pings_since_divergence, lost_pings = now, 0, 0
+            elif pings_since_divergence > CONFIRM + 1:  # one extra: the state may change again right after a ping
+                violations.append("diverged for %d pings at %.1f s" % (pings_since_divergence, now / 1e6))
+                diverged_since = None
+        elif diverged_since is not None:
+            worst_pings = max(worst_pings, pings_since_divergence + lost_pings)
+            diverged_since = None
+
+    if power_cut:
+        # last pong at most one interval before the cut, reported TIMEOUT later
+        if lost_reported is None or not power_cut[0] < lost_reported <= power_cut[0] + TIMEOUT + INTERVAL + LOOP:
+            violations.append("power cut reported lost at %s" % lost_reported)
+        if back_reported is None or not power_cut[1] <= back_reported <= power_cut[1] + 2 * INTERVAL:
+            violations.append("power cut reported back at %s" % back_reported)
+    return worst_pings, lost_reported, back_reported, violations
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--seconds", type=float, default=3600, help="simulated time per scenario")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    failed = False
+    print("scenario                 worst resync (pings)  lost/back reported (s)  result")
+    for name, (loss, reboot_micros, power_cut) in SCENARIOS.items():
+        worst, lost, back, violations = run(loss, reboot_micros, power_cut, args.seconds, args.seed)
+        reported = "%.1f/%.1f" % (lost / 1e6, back / 1e6) if power_cut and lost and back else "-"
+        print("%-23s  %20d  %22s  %s" % (name, worst, reported, "FAIL" if violations else "ok"))
+        for violation in violations[:5]:
+            print("    " + violation)
+        failed |= bool(violations)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,250 @@
+/*
+ * Fuzz harness for the gesture decoding of the remote (src/remote.cpp)
+ *
+ * Every case drives one fresh Remote through a random pin waveform: a poll period (the loop() duration, up to the
+ * 50 ms of a loop that blocks), a micros() start value (the wraparound at 2^32 included) and a series of pin levels
+ * with their durations. After every update() it checks
+ *  - the gesture buffer index stays within GESTURE_BUFFER_LEN and only moves on by one or back to 0 (a write past
+ *    the buffer lands in the index itself, inside the object, where AddressSanitizer doesn't see it)
+ *  - getGesture() only returns values of remote_gesture
+ *  - a gesture in the works is decoded at the latest REMOTE_DEBOUNCING_MICROS + REMOTE_GESTURE_MICROS and three polls
+ *    after the button was released
+ *
+ * build:  g++ -std=gnu++11 -O2 -Iinclude -Inative/hal -o remote_fuzz tools/remote_fuzz.cpp
+ *         (add -fsanitize=address,undefined -g for the sanitizers)
+ * usage:  remote_fuzz [--cases N] [--seed N]       random cases, prints a failing case as hex
+ *         remote_fuzz --case HEX                   runs one case (as printed) and shows the decoded gestures
+ * libFuzzer: clang++ -std=gnu++11 -g -O1 -fsanitize=fuzzer,address,undefined -DREMOTE_FUZZ_LIBFUZZER -Iinclude
+ *            -Inative/hal -o remote_fuzz tools/remote_fuzz.cpp && ./remote_fuzz corpus/
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include <Arduino.h>
+
+#include "Trace.h"
+
+#define private public // the checks look at the state of the decoder
+#include "../src/remote.cpp"
+#undef private
+
+#define FUZZ_PIN REMOTE_PIN
+#define FUZZ_MAX_STEPS 64         // pin levels per case
+#define FUZZ_RANDOM_STEPS 16      // pin levels per random case (up to 8 presses, more than a gesture takes)
+#define FUZZ_DRAIN_MICROS 3000000 // idle after the last step, every pending gesture is decoded by then
+
+// the firmware side the decoder needs: micros(), the remote pin, the trace (off)
+static uint32_t fuzzMicros;
+static uint8_t fuzzLevel;
+
+unsigned long micros()
+{
+    return fuzzMicros;
+}
+
+int digitalRead(uint8_t pin)
+{
+    return pin == FUZZ_PIN ? fuzzLevel : LOW;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    (void)pin;
+    (void)mode;
+}
+
+Trace trace;
+
+void Trace::remote(uint32_t time, uint8_t level)
+{
+    (void)time;
+    (void)level;
+}
+
+static const uint32_t pollMicros[8] = {250, 500, 1000, 2000, 4000, 10000, 20000, 50000};
+static const uint32_t stepScale[8] = {250, 1000, 4000, 16000, 50000, 100000, 200000, 400000};
+
+static bool validGesture(remote_gesture gesture)
+{
+    static const remote_gesture gestures[] = {NO_GESTURE,       SHORT,            LONG,
+                                              SHORT_SHORT,      LONG_SHORT,       SHORT_LONG,
+                                              LONG_LONG,        SHORT_SHORT_SHORT, LONG_SHORT_SHORT,
+                                              SHORT_LONG_SHORT, LONG_LONG_SHORT,  SHORT_SHORT_LONG,
+                                              LONG_SHORT_LONG,  SHORT_LONG_LONG,  LONG_LONG_LONG};
+    for (remote_gesture valid : gestures)
+    {
+        if (gesture == valid)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// a gesture is in the works from the first recorded press until STATE_ANALYSE has run
+static bool pending(const Remote &remote)
+{
+    return remote.gestureBufferIndex || remote.activeGestureState == STATE_SHORT ||
+           remote.activeGestureState == STATE_LONG || remote.activeGestureState == STATE_ANALYSE;
+}
+
+// case layout: poll period (1 byte, low 3 bits), micros() at the start (4 bytes, little endian), then one byte per
+// step: bit 7 button pressed, bits 4-6 scale, bits 0-3 duration (1-16 times the scale)
+// returns NULL or what went wrong, verbose prints the decoded gestures
+static const char *runCase(const uint8_t *data, size_t size, bool verbose)
+{
+    if (size < 5)
+    {
+        return NULL;
+    }
+    uint32_t poll = pollMicros[data[0] & 7];
+    fuzzMicros = data[1] | (uint32_t)data[2] << 8 | (uint32_t)data[3] << 16 | (uint32_t)data[4] << 24;
+    fuzzLevel = LOW; // released: the receiver drives the pin high while the button is pressed
+    uint32_t bound = REMOTE_DEBOUNCING_MICROS + REMOTE_GESTURE_MICROS + 3 * poll;
+    uint32_t releasedSince = fuzzMicros;
+
+    Remote remote(FUZZ_PIN);
+    remote.init();
+    size_t steps = min(size - 5, (size_t)FUZZ_MAX_STEPS);
+    for (size_t step = 0; step <= steps; step++)
+    {
+        uint8_t code = step < steps ? data[5 + step] : 0;
+        uint8_t level = code & 0x80 ? HIGH : LOW;
+        uint32_t duration = step < steps ? ((code & 0x0F) + 1) * stepScale[code >> 4 & 7] : FUZZ_DRAIN_MICROS;
+        if (level != fuzzLevel && level == LOW)
+        {
+            releasedSince = fuzzMicros;
+        }
+        fuzzLevel = level;
+        for (uint32_t elapsed = 0; elapsed < duration; elapsed += poll)
+        {
+            if (step == steps && !pending(remote) && remote.activeGestureState == STATE_START && !remote.remoteDebouncing)
+            {
+                break; // drained
+            }
+            uint8_t index = remote.gestureBufferIndex;
+            remote.update();
+            uint8_t next = remote.gestureBufferIndex;
+            if (next > GESTURE_BUFFER_LEN || (next != index && next != index + 1 && next != 0))
+            {
+                return "gesture buffer overflow";
+            }
+            remote_gesture gesture = remote.getGesture();
+            if (!validGesture(gesture))
+            {
+                return "invalid gesture";
+            }
+            if (verbose && gesture != NO_GESTURE)
+            {
+                printf("%10lu gesture %d\n", (unsigned long)fuzzMicros, gesture);
+            }
+            if (fuzzLevel == LOW && pending(remote) && fuzzMicros - releasedSince > bound)
+            {
+                return "gesture not decoded in time";
+            }
+            fuzzMicros += poll;
+        }
+    }
+    return NULL;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    const char *failure = runCase(data, size, false);
+    if (failure)
+    {
+        fprintf(stderr, "remote_fuzz: %s\n", failure);
+        abort();
+    }
+    return 0;
+}
+
+#ifndef REMOTE_FUZZ_LIBFUZZER
+static uint32_t randomState;
+
+static uint32_t next()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+static void printCase(const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        printf("%02x", data[i]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long cases = 1000000, seed = 1;
+    std::vector<uint8_t> data;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!strcmp(argv[i], "--cases"))
+        {
+            cases = strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (!strcmp(argv[i], "--seed"))
+        {
+            seed = strtoul(argv[i + 1], NULL, 0);
+        }
+        else if (!strcmp(argv[i], "--case"))
+        {
+            for (const char *hex = argv[i + 1]; hex[0] && hex[1]; hex += 2)
+            {
+                unsigned byte;
+                sscanf(hex, "%2x", &byte);
+                data.push_back(byte);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: remote_fuzz [--cases N] [--seed N] [--case HEX]\n");
+            return 2;
+        }
+    }
+    if (!data.empty())
+    {
+        const char *failure = runCase(data.data(), data.size(), true);
+        printf("%s\n", failure ? failure : "ok");
+        return failure ? 1 : 0;
+    }
+
+    // presses and gaps around the thresholds are what the random cases need most of
+    randomState = seed ? seed : 1;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    for (unsigned long n = 0; n < cases; n++)
+    {
+        data.assign(5 + next() % (FUZZ_RANDOM_STEPS + 1), 0);
+        for (uint8_t &byte : data)
+        {
+            byte = next();
+        }
+        for (size_t i = 5; i < data.size(); i++)
+        {
+            data[i] = (i & 1 ? 0x80 : 0) | (next() % 6) << 4 | (data[i] & 0x0F); // alternating, up to 800 ms
+        }
+        const char *failure = runCase(data.data(), data.size(), false);
+        if (failure)
+        {
+            printf("case %lu: %s\n", n, failure);
+            printCase(data.data(), data.size());
+            return 1;
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    printf("%lu cases in %.1f s (%.0f per minute), no failure\n", cases, elapsed, elapsed > 0 ? cases * 60 / elapsed : 0);
+    return 0;
+}
+#endif
@@ -0,0 +1,259 @@
+/*
+ * Decoder for the binary capture stream of a RADIO_SNIFFER box (see include/Sniffer.h)
+ *
+ * Turns the raw captures into a timeline: checks the CRC of every packet, tells frames, retransmissions and ACKs
+ * apart and decodes the frames (layout of include/Frame.h).
+ *
+ * build: g++ -std=c++11 -O2 -o sniffer_decode tools/sniffer_decode.cpp
+ * usage: stty -F /dev/ttyUSB0 1000000 raw && cat /dev/ttyUSB0 > capture.bin
+ *        sniffer_decode [--all] capture.bin   (or the stream on stdin, --all also lists packets with a bad CRC)
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// include/Sniffer.h
+static const uint8_t SNIFFER_SYNC = 0xA5;
+static const uint8_t SNIFFER_RECORD_ADDRESS = 1;
+static const uint8_t SNIFFER_RECORD_CAPTURE = 2;
+static const int SNIFFER_PIPES = 6;
+static const int SNIFFER_RAW_LEN = 32;
+
+// include/Frame.h
+static const uint8_t FRAME_VERSION = 2;
+static const int FRAME_HEADER_LEN = 4;
+static const char *const frameTypeNames[] = {"COMMAND", "PULL", "PING", "PONG", "BEACON", "CHANNEL", "PAIR", "STATE"};
+static const uint8_t frameTimeCount[] = {0, 1, 2, 3, 1, 1, 2, 1}; // src/Frame.cpp
+static const int FRAME_TYPE_COUNT = sizeof(frameTimeCount);
+
+static const uint32_t ACK_WINDOW_MICROS = 2000; // an ACK follows its frame within this time (polled timestamps)
+
+struct Packet
+{
+    uint32_t time;
+    uint8_t channel;
+    uint8_t pipe;
+    uint8_t len; // payload length from the packet control field
+    uint8_t pid;
+    bool noAck;
+    bool crcOk;
+    uint8_t payload[SNIFFER_RAW_LEN];
+};
+
+// bit i (MSB first) of the raw bytes
+static int rawBit(const uint8_t *raw, int i)
+{
+    return (raw[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static uint16_t crcBit(uint16_t crc, int bit)
+{
+    bool feedback = ((crc >> 15) & 1) ^ bit;
+    crc <<= 1;
+    return feedback ? crc ^ 0x1021 : crc;
+}
+
+// CRC-16-CCITT over the address (sent last byte of the RF24 address array first), the 9 bit packet control field and
+// the payload, compared with the 16 bits following the payload
+static bool checkCrc(const uint8_t *address, const uint8_t *raw, int len)
+{
+    uint16_t crc = 0xFFFF;
+    for (int i = 4; i >= 0; i--)
+    {
+        for (int b = 7; b >= 0; b--)
+        {
+            crc = crcBit(crc, (address[i] >> b) & 1);
+        }
+    }
+    int bits = 9 + 8 * len;
+    for (int i = 0; i < bits; i++)
+    {
+        crc = crcBit(crc, rawBit(raw, i));
+    }
+    uint16_t received = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        received = received << 1 | rawBit(raw, bits + i);
+    }
+    return crc == received;
+}
+
+static bool decodePacket(const uint8_t *record, const uint8_t addresses[][5], Packet *packet)
+{
+    packet->time = record[0] | record[1] << 8 | record[2] << 16 | (uint32_t)record[3] << 24;
+    packet->channel = record[4];
+    packet->pipe = record[5];
+    const uint8_t *raw = &record[6];
+    packet->len = raw[0] >> 2;
+    packet->pid = raw[0] & 3;
+    packet->noAck = raw[1] >> 7;
+    if (9 + 8 * packet->len + 16 > 8 * SNIFFER_RAW_LEN)
+    {
+        packet->crcOk = false;
+        packet->len = 0;
+        return false;
+    }
+    for (int i = 0; i < packet->len; i++)
+    {
+        packet->payload[i] = raw[1 + i] << 1 | raw[2 + i] >> 7;
+    }
+    packet->crcOk = checkCrc(addresses[packet->pipe], raw, packet->len);
+    return packet->crcOk;
+}
+
+static void printFrame(const uint8_t *buf, int len)
+{
+    if (len < FRAME_HEADER_LEN || buf[0] != FRAME_VERSION || buf[1] >= FRAME_TYPE_COUNT ||
+        len != FRAME_HEADER_LEN + 4 * frameTimeCount[buf[1]])
+    {
+        printf("?");
+        for (int i = 0; i < len; i++)
+        {
+            printf(" %02x", buf[i]);
+        }
+        return;
+    }
+    printf("%s seq=%u flags=%02x", frameTypeNames[buf[1]], buf[2], buf[3]);
+    for (int i = 0; i < frameTimeCount[buf[1]]; i++)
+    {
+        const uint8_t *b = &buf[FRAME_HEADER_LEN + 4 * i];
+        printf(" t%d=%lu", i, (unsigned long)(b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24));
+    }
+}
+
+// sender of frames on a pipe: pipe 0 = member 5 (or the slot beacon), pipes 1-5 = members 0-4 (0 = master)
+static void printSender(uint8_t pipe, const uint8_t *address)
+{
+    if (!memcmp(address, "Beacn", 5))
+    {
+        printf("%-6s", "beacon");
+    }
+    else
+    {
+        int member = (pipe + SNIFFER_PIPES - 1) % SNIFFER_PIPES;
+        char name[8];
+        snprintf(name, sizeof(name), member ? "S%d" : "M", member);
+        printf("%-6s", name);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    bool all = false;
+    FILE *in = stdin;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--all"))
+        {
+            all = true;
+        }
+        else if (!(in = fopen(argv[i], "rb")))
+        {
+            perror(argv[i]);
+            return 1;
+        }
+    }
+
+    uint8_t addresses[SNIFFER_PIPES][5] = {};
+    bool haveAddresses = false;
+    Packet last[SNIFFER_PIPES] = {}; // last packet with a valid CRC per pipe (ACK/retransmission detection)
+    bool haveLast[SNIFFER_PIPES] = {};
+    uint32_t lastTime = 0;
+    bool haveTime = false;
+    uint64_t elapsed = 0; // micros since the first capture (survives the 71 min wrap)
+    unsigned long frames = 0, retries = 0, acks = 0, bad = 0;
+
+    printf("%12s %9s %4s %-6s %-5s %3s %3s  %s\n", "time (s)", "dt (ms)", "ch", "from", "kind", "pid", "len", "content");
+    int c;
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c != SNIFFER_SYNC)
+        {
+            continue;
+        }
+        int type = fgetc(in);
+        int len = fgetc(in);
+        if (type == EOF || len == EOF)
+        {
+            break;
+        }
+        uint8_t record[255];
+        if (fread(record, 1, len, in) != (size_t)len)
+        {
+            break;
+        }
+
+        if (type == SNIFFER_RECORD_ADDRESS && len == 6 && record[0] < SNIFFER_PIPES)
+        {
+            memcpy(addresses[record[0]], &record[1], 5);
+            haveAddresses = true;
+            continue;
+        }
+        if (type != SNIFFER_RECORD_CAPTURE || len != 6 + SNIFFER_RAW_LEN || !haveAddresses || record[5] >= SNIFFER_PIPES)
+        {
+            continue; // resync on the next SNIFFER_SYNC (or captures before the first address records)
+        }
+
+        Packet packet;
+        bool ok = decodePacket(record, addresses, &packet);
+        if (!ok)
+        {
+            bad++;
+            if (!all)
+            {
+                continue;
+            }
+        }
+
+        if (!haveTime)
+        {
+            lastTime = packet.time;
+            haveTime = true;
+        }
+        uint32_t dt = packet.time - lastTime;
+        elapsed += dt;
+        lastTime = packet.time;
+
+        const char *kind = "bad";
+        Packet *previous = haveLast[packet.pipe] ? &last[packet.pipe] : NULL;
+        bool sameAsPrevious = previous && previous->pid == packet.pid && previous->len == packet.len &&
+                              !memcmp(previous->payload, packet.payload, packet.len);
+        if (ok)
+        {
+            if (previous && previous->pid == packet.pid && packet.time - previous->time < ACK_WINDOW_MICROS &&
+                !previous->noAck && !sameAsPrevious)
+            {
+                kind = "ack";
+                acks++;
+            }
+            else if (sameAsPrevious)
+            {
+                kind = "retry";
+                retries++;
+            }
+            else
+            {
+                kind = "frame";
+                frames++;
+            }
+            if (strcmp(kind, "ack")) // ACKs don't replace the frame they answer
+            {
+                last[packet.pipe] = packet;
+                haveLast[packet.pipe] = true;
+            }
+        }
+
+        printf("%12.6f %9.3f %4u ", elapsed / 1e6, dt / 1e3, packet.channel);
+        printSender(packet.pipe, addresses[packet.pipe]);
+        printf(" %-5s %3u %3u  ", kind, packet.pid, packet.len);
+        if (ok && packet.len)
+        {
+            printFrame(packet.payload, packet.len);
+        }
+        printf("%s\n", ok && packet.noAck ? " (no ACK)" : "");
+    }
+
+    printf("frames %lu, retransmissions %lu, ACKs %lu, bad CRC %lu\n", frames, retries, acks, bad);
+    return 0;
+}
@@ -0,0 +1,87 @@
+"""
+SRAM report of the firmware (ATmega328: 2048 bytes shared by .data, .bss, .noinit, heap and stack)
+
+Prints the static SRAM of the build, what is left for the stack and the largest variables, and warns when less than
+custom_sram_min_free bytes (platformio.ini) are left. String literals and constant tables without PROGMEM are copied
+to SRAM at startup and show up as unnamed .data (the serial texts are in flash, see include/Messages.h).
+
+PlatformIO runs it after every build of env:nanoatmega328 (extra_scripts in platformio.ini).
+standalone: python3 tools/sram_report.py .pio/build/nanoatmega328/firmware.elf [--nm avr-nm] [--top N] [--min-free N]
+"""
+
+import subprocess
+import sys
+
+SRAM_BYTES = 2048
+SRAM_MIN_FREE = 512  # default of custom_sram_min_free: stack of the deepest call chain with ISRs on top, with margin
+SRAM_SECTIONS = (".data", ".bss", ".noinit")
+TOP = 12
+
+
+def sections(size_tool, elf, run_env=None):
+    sizes = dict.fromkeys(SRAM_SECTIONS, 0)
+    output = subprocess.check_output([size_tool, "-A", elf], env=run_env, universal_newlines=True)
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in sizes:
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+# (size, type, name) of the variables: d/D initialised (.data), b/B zeroed (.bss and .noinit)
+def variables(nm_tool, elf, run_env=None):
+    output = subprocess.check_output([nm_tool, "--size-sort", "-S", "-t", "d", "-C", elf], env=run_env,
+                                     universal_newlines=True)
+    found = []
+    for line in output.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) == 4 and fields[2] in "dDbB":
+            found.append((int(fields[1]), fields[2].lower(), fields[3]))
+    return found
+
+
+def report(elf, nm_tool="avr-nm", top=TOP, min_free=SRAM_MIN_FREE, run_env=None):
+    sizes = sections(nm_tool[:-2] + "size", elf, run_env)  # avr-nm -> avr-size
+    found = variables(nm_tool, elf, run_env)
+    used = sum(sizes.values())
+    free = SRAM_BYTES - used
+    unnamed = sizes[".data"] - sum(size for size, kind, _ in found if kind == "d")
+
+    print("SRAM: %d of %d bytes static (%s), %d bytes left for the stack"
+          % (used, SRAM_BYTES, ", ".join("%s %d" % (name, sizes[name]) for name in SRAM_SECTIONS), free))
+    print("  unnamed .data (string literals, tables without PROGMEM): %d bytes" % max(unnamed, 0))
+    print("  largest variables:")
+    for size, kind, name in sorted(found, reverse=True)[:top]:
+        print("  %6d  %s  %s" % (size, ".data" if kind == "d" else ".bss ", name))
+    if free < min_free:
+        print("warning: only %d bytes of SRAM left for the stack (custom_sram_min_free = %d)" % (free, min_free))
+    return free
+
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO extra script)
+except NameError:
+    env = None
+
+if env is not None:
+    def after_build(source, target, env):
+        min_free = int(env.GetProjectOption("custom_sram_min_free", SRAM_MIN_FREE))
+        report(str(target[0]), env.subst("$CC").replace("gcc", "nm"), min_free=min_free, run_env=env["ENV"])
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_build)
+elif __name__ == "__main__":
+    arguments = sys.argv[1:]
+    options = {"--nm": "avr-nm", "--top": TOP, "--min-free": SRAM_MIN_FREE}
+    paths = []
+    while arguments:
+        argument = arguments.pop(0)
+        if argument in options and arguments:
+            options[argument] = type(options[argument])(arguments.pop(0))
+        elif not argument.startswith("-"):
+            paths.append(argument)
+        else:
+            paths = []
+            break
+    if len(paths) != 1:
+        sys.exit("usage: sram_report.py firmware.elf [--nm avr-nm] [--top N] [--min-free N]")
+    report(paths[0], options["--nm"], options["--top"], options["--min-free"])